@@ -58,6 +58,14 @@ var (
 		// Harvester
 		BufferSize: 16 * humanize.KiByte,
 		MaxBytes:   10 * humanize.MiByte,
+
+		// LSF
+		LsfBatchSize:    1,
+		LsfBatchTimeout: 100 * time.Millisecond,
+		LsfInotify:      true,
+		LsfRotation:     true,
+		LsfDedupWindow:  16384,
+
 		LogConfig: LogConfig{
 			Backoff:       1 * time.Second,
 			BackoffFactor: 2,
@@ -105,6 +113,24 @@ type config struct {
 
 	// define the lsf events topic related options
 	LsfTopics []parselsb.Topic `config:"lsf_topics"`
+	// lines parsed in one round trip to the lsf parser, and how long to
+	// wait for more lines once a batch has its first
+	LsfBatchSize    int           `config:"lsf_batch_size" validate:"min=1"`
+	LsfBatchTimeout time.Duration `config:"lsf_batch_timeout" validate:"min=0"`
+	// type of the lsf files of the input, such as "lsb.stream", by default
+	// taken from their names
+	LsfFileType string `config:"lsf_file_type"`
+	// rotated files, such as lsb.acct.*, published before the file is
+	// read from its start
+	LsfBackfill []string `config:"lsf_backfill"`
+	// read lsf files from a mapping of the file
+	LsfMmap bool `config:"lsf_mmap"`
+	// wake up on changes of lsf files instead of polling them
+	LsfInotify bool `config:"lsf_inotify"`
+	// read lsf files rotated by renaming to their end before the new file
+	LsfRotation bool `config:"lsf_rotation"`
+	// ids of the last lsf messages sent, a message sent again is dropped
+	LsfDedupWindow int `config:"lsf_dedup_window" validate:"min=0"`
 	
 	// Hidden on purpose, used by the docker input:
 	DockerJSON *struct {
@@ -177,6 +203,10 @@ func (c *config) Validate() error {
 		return fmt.Errorf("When using the JSON decoder and line filtering together, you need to specify a message_key value")
 	}
 
+	if _, ok := parselsb.FileTypes[c.LsfFileType]; c.LsfFileType != "" && !ok {
+		return fmt.Errorf("Invalid lsf_file_type: %v", c.LsfFileType)
+	}
+
 	if c.ScanSort != "" {
 		cfgwarn.Experimental("scan_sort is used.")
 
@@ -34,7 +34,6 @@ import (
 	"fmt"
 	"io"
 	"os"
-	"strings"
 	"sync"
 	"time"
 
@@ -70,6 +69,7 @@ var (
 
 	ErrFileTruncate = errors.New("detected file being truncated")
 	ErrRenamed      = errors.New("file was renamed")
+	ErrRotated      = errors.New("file was rotated")
 	ErrRemoved      = errors.New("file was removed")
 	ErrInactive     = errors.New("file inactive")
 	ErrClosed       = errors.New("reader closed")
@@ -100,6 +100,15 @@ type Harvester struct {
 	encodingFactory encoding.EncodingFactory
 	encoding        encoding.Encoding
 
+	// type of the lsf file, -1 if it is not one
+	lsfFileType int
+	// reader of the mapped file with lsf_mmap
+	lsfMmap *mmapReader
+	// changes of the file with lsf_inotify
+	lsfWatch *fileWatch
+	// hands the file name over to the next harvester with lsf_rotation
+	lsfHandoff *lsfHandoff
+
 	// event/state publishing
 	outletFactory OutletFactory
 	publishState  func(*util.Data) bool
@@ -137,6 +146,14 @@ func NewHarvester(
 	}
 	h.encodingFactory = encodingFactory
 
+	// the parser of the file is chosen once, by lsf_file_type or else by
+	// the file name
+	h.lsfFileType = GetFileType(h.state.Source)
+	if h.config.LsfFileType != "" {
+		h.lsfFileType = FileTypes[h.config.LsfFileType]
+	}
+	lsfDedup.grow(h.config.LsfDedupWindow)
+
 	// Add ttl if clean_inactive is set
 	if h.config.CleanInactive > 0 {
 		h.state.TTL = h.config.CleanInactive
@@ -180,6 +197,10 @@ func (h *Harvester) Setup() error {
 		return fmt.Errorf("Harvester setup failed. Unexpected encoding line reader error: %s", err)
 	}
 
+	if h.config.LsfRotation && h.lsfFileType >= 0 && h.source.HasState() {
+		h.lsfRegister()
+	}
+
 	return nil
 }
 
@@ -205,6 +226,7 @@ func (h *Harvester) Run() error {
 	h.stopLock.Unlock()
 	select {
 	case <-h.done:
+		h.lsfRelease()
 		h.stopWg.Done()
 		return nil
 	default:
@@ -219,9 +241,6 @@ func (h *Harvester) Run() error {
 
 		harvesterRunning.Add(-1)
 
-		// stop job states snapshot sync task
-		StopSyncTask()
-
 		// Marks harvester stopping completed
 		h.stopWg.Done()
 	}()
@@ -230,9 +249,13 @@ func (h *Harvester) Run() error {
 	harvesterRunning.Add(1)
 
 	// channel to receive parsed lsf records
-	jsonChan := make(chan []MessageWithTopic)
+	batchChan := make(chan [][]MessageWithTopic)
 	parser := NewLsbParser()
 
+	// job states are synced while any harvester runs
+	StartSyncTask()
+	defer StopSyncTask()
+
 	// Closes reader after timeout or when done channel is closed
 	// This routine is also responsible to properly stop the reader
 	go func(source string) {
@@ -257,141 +280,155 @@ func (h *Harvester) Run() error {
 
 	logp.Info("Harvester started for file: %s", h.state.Source)
 
-	for {
-		select {
-		case <-h.done:
+	// with lsf_rotation, the files which had the name before are read to
+	// their end first
+	if h.lsfHandoff != nil {
+		if !h.lsfTakeOver() {
+			return nil
+		}
+		if !h.lsfCatchUp(forwarder, h.lsfRotated()) {
 			return nil
-		default:
 		}
+	}
 
-		message, err := h.reader.Next()
-		if err != nil {
-			switch err {
-			case ErrFileTruncate:
-				logp.Info("File was truncated. Begin reading file from offset 0: %s", h.state.Source)
-				h.state.Offset = 0
-				filesTruncated.Add(1)
-			case ErrRemoved:
-				logp.Info("File was removed: %s. Closing because close_removed is enabled.", h.state.Source)
-			case ErrRenamed:
-				logp.Info("File was renamed: %s. Closing because close_renamed is enabled.", h.state.Source)
-			case ErrClosed:
-				logp.Info("Reader was closed: %s. Closing.", h.state.Source)
-			case io.EOF:
-				logp.Info("End of file reached: %s. Closing because close_eof is enabled.", h.state.Source)
-			case ErrInactive:
-				logp.Info("File is inactive: %s. Closing because close_inactive of %v reached.", h.state.Source, h.config.CloseInactive)
-			default:
-				logp.Err("Read line error: %v; File: %v", err, h.state.Source)
-			}
+	// rotated files are backfilled once, before the first file of the input
+	// is read from its start
+	if h.lsfShouldBackfill() {
+		if !h.backfill(forwarder) {
 			return nil
 		}
+	}
 
-		// Strip UTF-8 BOM if beginning of file
-		// As all BOMS are converted to UTF-8 it is enough to only remove this one
+	// lines are read and parsed in batches of up to lsf_batch_size, so a
+	// backlog costs one parser round trip per batch instead of per line
+	batcher := newLineBatcher(h.reader, h.config.LsfBatchSize, h.config.LsfBatchTimeout, h.done)
+	var rate *sourceRate
+	if h.lsfFileType >= 0 {
+		rate = lsfSources.open(h.state.Source)
+		defer lsfSources.close(h.state.Source)
+	}
+	var fileID string
+	if h.source.HasState() {
+		fileID = h.state.FileStateOS.String()
+		// nothing of a file read from its start was sent, its inode may be
+		// that of a file removed since
 		if h.state.Offset == 0 {
-			message.Content = bytes.Trim(message.Content, "\xef\xbb\xbf")
+			lsfDedup.forget(fileID)
+		}
+	}
+	var lines []lsfLine
+	var recs []LsfRec
+
+	for {
+		select {
+		case <-h.done:
+			return nil
+		default:
+		}
+
+		messages, err := batcher.Next()
+		if rate != nil && len(messages) > 0 {
+			lsfSources.add(rate, len(messages))
 		}
 
 		// Get copy of state to work on
 		// This is important in case sending is not successful so on shutdown
 		// the old offset is reported
 		state := h.getState()
-		startingOffset := state.Offset
-		state.Offset += int64(message.Bytes)
-
-		// Create state event
-		data := util.NewData()
-		if h.source.HasState() {
-			data.SetState(state)
-		}
-
-		text := string(message.Content)
-
-		var msgs []MessageWithTopic
-		oneLine := true
-
-		// Check if data should be added to event. Only export non empty events.
-		if !message.IsEmpty() && h.shouldExportLine(text) {
-			fields := common.MapStr{
-				"source": state.Source,
-				"offset": startingOffset, // Offset here is the offset before the starting char.
+		lines, recs = lines[:0], recs[:0]
+		for _, message := range messages {
+			// Strip UTF-8 BOM if beginning of file
+			// As all BOMS are converted to UTF-8 it is enough to only remove this one
+			if state.Offset == 0 {
+				message.Content = bytes.Trim(message.Content, "\xef\xbb\xbf")
 			}
-			fields.DeepUpdate(message.Fields)
 
-			// Check if json fields exist
-			var jsonFields common.MapStr
-			if f, ok := fields["json"]; ok {
-				jsonFields = f.(common.MapStr)
-			}
+			startingOffset := state.Offset
+			state.Offset += int64(message.Bytes)
+			line := lsfLine{state: state, offset: startingOffset, rec: -1}
 
-			data.Event = beat.Event{
-				Timestamp: message.Ts,
-			}
+			// Check if data should be added to event. Only export non empty events.
+			if !message.IsEmpty() && h.exportContent(message.Content) {
+				line.exported = true
+				line.ts = message.Ts
 
-			if h.config.JSON != nil && len(jsonFields) > 0 {
-				ts := json.MergeJSONFields(fields, jsonFields, &text, *h.config.JSON)
-				if !ts.IsZero() {
-					// there was a `@timestamp` key in the event, so overwrite
-					// the resulting timestamp
-					data.Event.Timestamp = ts
-				}
-			} else if &text != nil {
-				if fields == nil {
-					fields = common.MapStr{}
+				fields := common.MapStr{
+					"source": state.Source,
+					"offset": startingOffset, // Offset here is the offset before the starting char.
 				}
+				fields.DeepUpdate(message.Fields)
 
-				oldTxt := text
-
-				// lsf events are just raw string
-				if strings.Contains(h.state.Source, "lsb.stream") {
-					parser.Post(LsfRec{Type: StreamFile, RawContent: text, RetChan: jsonChan, Topics: h.config.LsfTopics})
-					msgs = <-jsonChan
-				} else if strings.Contains(h.state.Source, "lsb.acct") {
-					parser.Post(LsfRec{Type: AcctFile, RawContent: text, RetChan: jsonChan, Topics: h.config.LsfTopics})
-					msgs = <-jsonChan
-				} else if strings.Contains(h.state.Source, "lsb.events") {
-					parser.Post(LsfRec{Type: EventFile, RawContent: text, RetChan: jsonChan, Topics: h.config.LsfTopics})
-					msgs = <-jsonChan
-				} else if strings.Contains(h.state.Source, "lsb.status") {
-					parser.Post(LsfRec{Type: StatusFile, RawContent: text, RetChan: jsonChan, Topics: h.config.LsfTopics})
-					msgs = <-jsonChan
-				}
-				if len(msgs) <= 0 {
-					logp.Info("Failed to parse from %s, data: %s", h.state.Source, oldTxt)
-					// Do not bail out if an empty line is returned:
-					// some events (e.g. MBD_START) are not parsed but we want to continue
-					// just return
+				// Check if json fields exist
+				var jsonFields common.MapStr
+				if f, ok := fields["json"]; ok {
+					jsonFields = f.(common.MapStr)
 				}
-			}
 
-			// deal with multiple parsed results
-			for _, msg := range msgs {
-				if oneLine {
-					oneLine = false
+				if h.config.JSON != nil && len(jsonFields) > 0 {
+					text := string(message.Content)
+					ts := json.MergeJSONFields(fields, jsonFields, &text, *h.config.JSON)
+					if !ts.IsZero() {
+						// there was a `@timestamp` key in the event, so overwrite
+						// the resulting timestamp
+						line.ts = ts
+					}
 				} else {
-					data := util.NewData()
-					if h.source.HasState() {
-						data.SetState(state)
+					line.content = message.Content
+
+					// lsf events are just raw string
+					if h.lsfFileType >= 0 {
+						line.rec = len(recs)
+						recs = append(recs, LsfRec{Type: h.lsfFileType, RawContent: message.Content, Topics: h.config.LsfTopics})
 					}
 				}
+				line.fields = fields
+			}
+			lines = append(lines, line)
+		}
 
-				fields["message"] = msg.Text
-				data.Event.Fields = fields
+		var results [][]MessageWithTopic
+		if len(recs) > 0 {
+			parser.PostBatch(recs, batchChan)
+			results = <-batchChan
+		}
 
-				// specify the topic name and routing key exactly
-				if data.Event.Meta == nil {
-					data.Event.Meta = common.MapStr{}
-				}
-				if msg.Topic != "" {
-					data.Event.Meta["topic"] = msg.Topic
-				}
-				data.Event.Meta["routing"] = msg.RoutingKey
-				if msg.Props != nil {
-					data.Event.Meta["properties"] = msg.Props
+		// the last message of the batch carries the state after its last
+		// line, so the registry advances to the end of the batch
+		last := -1
+		for i := range lines {
+			if lines[i].rec >= 0 && len(results[lines[i].rec]) > 0 {
+				last = i
+			}
+		}
+
+		for i := range lines {
+			line := &lines[i]
+			if !line.exported {
+				continue
+			}
+			var msgs []MessageWithTopic
+			if line.rec >= 0 {
+				msgs = results[line.rec]
+			}
+			if len(line.content) > 0 && len(msgs) <= 0 {
+				logp.Info("Failed to parse from %s, data: %s", h.state.Source, line.content)
+				// Do not bail out if an empty line is returned:
+				// some events (e.g. MBD_START) are not parsed but we want to continue
+				// just return
+			}
+
+			// each message is an event of its own, its fields a copy of
+			// those of the line. Only the last one updates the state.
+			for j := range msgs {
+				data := lsfEvent(&msgs[j], line.fields, line.ts, fileID, line.offset)
+				if j == len(msgs)-1 && h.source.HasState() {
+					if i == last {
+						data.SetState(state)
+					} else {
+						data.SetState(line.state)
+					}
 				}
 
-				// Always send event to update state, also if lines was skipped
 				// Stop harvester in case of an error
 				if !h.sendEvent(data, forwarder) {
 					return nil
@@ -400,10 +437,94 @@ func (h *Harvester) Run() error {
 		}
 
 		// Update state of harvester as successfully sent
-		h.state = state
+		if len(lines) > 0 {
+			h.state = state
+			if last < 0 && h.source.HasState() {
+				h.states.Update(state)
+			}
+			// the lines of the batch are parsed and sent, the mappings
+			// they were read from may go
+			if h.lsfMmap != nil {
+				h.lsfMmap.release(state.Offset)
+			}
+		}
+
+		if err != nil {
+			switch err {
+			case ErrFileTruncate:
+				logp.Info("File was truncated. Begin reading file from offset 0: %s", h.state.Source)
+				h.state.Offset = 0
+				filesTruncated.Add(1)
+				// the offsets of its messages are those of other records now
+				lsfDedup.forget(fileID)
+			case ErrRemoved:
+				logp.Info("File was removed: %s. Closing because close_removed is enabled.", h.state.Source)
+			case ErrRenamed:
+				logp.Info("File was renamed: %s. Closing because close_renamed is enabled.", h.state.Source)
+			case ErrRotated:
+				logp.Info("File was rotated: %s. Closing as it was read to its end.", h.state.Source)
+			case ErrClosed:
+				logp.Info("Reader was closed: %s. Closing.", h.state.Source)
+			case io.EOF:
+				logp.Info("End of file reached: %s. Closing because close_eof is enabled.", h.state.Source)
+			case ErrInactive:
+				logp.Info("File is inactive: %s. Closing because close_inactive of %v reached.", h.state.Source, h.config.CloseInactive)
+			default:
+				logp.Err("Read line error: %v; File: %v", err, h.state.Source)
+			}
+			return nil
+		}
 	}
 }
 
+// lsfEvent returns the event of a parsed message, its fields a copy of
+// those of its line. The record of the message is at offset of the file of
+// fileID, "" if the file has no state.
+func lsfEvent(msg *MessageWithTopic, lineFields common.MapStr, ts time.Time, fileID string, offset int64) *util.Data {
+	fields := make(common.MapStr, len(lineFields)+1)
+	for k, v := range lineFields {
+		fields[k] = v
+	}
+	fields["message"] = msg.Text
+
+	// specify the topic name and routing key exactly
+	meta := make(common.MapStr, 4)
+	if fileID != "" {
+		meta["id"] = lsfMessageID(fileID, offset, msg.TopicIndex)
+	}
+	if msg.Topic != "" {
+		meta["topic"] = msg.Topic
+	}
+	meta["routing"] = msg.RoutingKey
+	if msg.Props != nil {
+		meta["properties"] = msg.Props
+	}
+
+	data := util.NewData()
+	data.Event = beat.Event{
+		Timestamp: ts,
+		Meta:      meta,
+		Fields:    fields,
+	}
+	return data
+}
+
+// lsfLine is a line of a batch waiting for its parsed messages
+type lsfLine struct {
+	// state after the line, and the offset of the line
+	state  file.State
+	offset int64
+	// whether the line is exported, with the timestamp and fields shared
+	// by its messages
+	exported bool
+	ts       time.Time
+	fields   common.MapStr
+	// the line as read, only made a string to log a parse failure
+	content []byte
+	// index of its record in the batch, -1 if it is not parsed
+	rec int
+}
+
 // stop is intended for internal use and closed the done channel to stop execution
 func (h *Harvester) stop() {
 	h.stopOnce.Do(func() {
@@ -423,11 +544,29 @@ func (h *Harvester) Stop() {
 // sendEvent sends event to the spooler channel
 // Return false if event was not sent
 func (h *Harvester) sendEvent(data *util.Data, forwarder *harvester.Forwarder) bool {
-	if h.source.HasState() {
+	// a message sent before, as by a harvester of the file which started
+	// at an older offset, is dropped; its state is still sent on so the
+	// registry moves past the line
+	if id, ok := data.Event.Meta["id"].(string); ok && !lsfDedup.add(id) {
+		lsfDuplicates.Add(1)
+		if !data.HasState() {
+			return true
+		}
+		state := data.GetState()
+		data = util.NewData()
+		data.SetState(state)
+	}
+
+	if h.source.HasState() && data.HasState() {
 		h.states.Update(data.GetState())
 	}
 
+	if h.lsfFileType < 0 {
+		return forwarder.Send(data) == nil
+	}
+	start := time.Now()
 	err := forwarder.Send(data)
+	lsfPublishBlocked.Since(start)
 	return err == nil
 }
 
@@ -470,6 +609,15 @@ func (h *Harvester) shouldExportLine(line string) bool {
 	return true
 }
 
+// exportContent is shouldExportLine for the content of a message. The
+// content is only copied into a string when there are patterns to match.
+func (h *Harvester) exportContent(content []byte) bool {
+	if len(h.config.IncludeLines) == 0 && len(h.config.ExcludeLines) == 0 {
+		return true
+	}
+	return h.shouldExportLine(string(content))
+}
+
 // openFile opens a file and checks for the encoding. In case the encoding cannot be detected
 // or the file cannot be opened because for example of failing read permissions, an error
 // is returned and the harvester is closed. The file will be picked up again the next time
@@ -568,6 +716,14 @@ func (h *Harvester) cleanup() {
 	// If file was never opened, it can't be closed
 	if h.source != nil {
 
+		// unmap the file before closing it
+		if h.lsfMmap != nil {
+			h.lsfMmap.Close()
+		}
+		if h.lsfWatch != nil {
+			h.lsfWatch.Close()
+		}
+
 		// close file handler
 		h.source.Close()
 
@@ -581,6 +737,9 @@ func (h *Harvester) cleanup() {
 		logp.Warn("Stopping harvester, NOT closing file as file info not available: %s", h.state.Source)
 	}
 
+	// the harvester of the next file under the name may go on
+	h.lsfRelease()
+
 	harvesterClosed.Add(1)
 }
 
@@ -588,12 +747,12 @@ func (h *Harvester) cleanup() {
 //
 // It creates a chain of readers which looks as following:
 //
-//   limit -> (multiline -> timeout) -> strip_newline -> json -> encode -> line -> log_file
+//   limit -> (multiline -> timeout | lsf_record) -> strip_newline -> json -> encode -> line -> log_file
 //
 // Each reader on the left, contains the reader on the right and calls `Next()` to fetch more data.
 // At the base of all readers the the log_file reader. That means in the data is flowing in the opposite direction:
 //
-//   log_file -> line -> encode -> json -> strip_newline -> (timeout -> multiline) -> limit
+//   log_file -> line -> encode -> json -> strip_newline -> (timeout -> multiline | lsf_record) -> limit
 //
 // log_file implements io.Reader interface and encode reader is an adapter for io.Reader to
 // reader.Reader also handling file encodings. All other readers implement reader.Reader
@@ -609,7 +768,36 @@ func (h *Harvester) newLogFileReader() (reader.Reader, error) {
 		return nil, err
 	}
 
-	r, err = encode.New(h.log, h.encoding, h.config.BufferSize)
+	// with lsf_inotify, LSF files are read as soon as they change, and
+	// with lsf_rotation, reading stops at the end of a rotated file
+	var logReader io.Reader = h.log
+	var tailOpts tailOptions
+	if f, ok := h.source.(File); ok && (h.config.LsfInotify || h.config.LsfRotation) && h.lsfFileType >= 0 {
+		if h.config.LsfInotify {
+			if h.lsfWatch, err = newFileWatch(f.File); err != nil {
+				logp.Warn("Fail watching %s, polling it: %s", h.state.Source, err.Error())
+			}
+		}
+		tailOpts = tailOptions{watch: h.lsfWatch, rotation: h.config.LsfRotation}
+		if logReader, err = newLsfLog(f.File, h.config.LogConfig, h.done, tailOpts); err != nil {
+			return nil, err
+		}
+	}
+
+	// with lsf_mmap, plain LSF files are read from a mapping of the file
+	// instead of through the reader chain
+	if f, ok := h.source.(File); ok && h.config.LsfMmap && h.lsfFileType >= 0 {
+		if !h.lsfPlain() || h.config.JSON != nil || h.config.Multiline != nil || h.config.DockerJSON != nil {
+			logp.Warn("lsf_mmap is only for plain encoded files without json, multiline or docker-json, not used for %s", h.state.Source)
+		} else if mr, err := newMmapReader(f.File, h.state.Offset, h.config.LogConfig, h.config.MaxBytes, h.done, tailOpts); err != nil {
+			logp.Warn("Fail mapping %s, lsf_mmap not used: %s", h.state.Source, err.Error())
+		} else {
+			h.lsfMmap = mr
+			return newRecordFramer(mr, h.config.MaxBytes), nil
+		}
+	}
+
+	r, err = encode.New(logReader, h.encoding, h.config.BufferSize)
 	if err != nil {
 		return nil, err
 	}
@@ -625,6 +813,11 @@ func (h *Harvester) newLogFileReader() (reader.Reader, error) {
 
 	r = strip_newline.New(r)
 
+	// lsf records with line breaks in quoted fields are joined
+	if h.lsfFileType >= 0 && h.config.Multiline == nil {
+		r = newRecordFramer(r, h.config.MaxBytes)
+	}
+
 	if h.config.Multiline != nil {
 		r, err = multiline.New(r, "\n", h.config.MaxBytes, h.config.Multiline)
 		if err != nil {
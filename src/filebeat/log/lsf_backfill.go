@@ -0,0 +1,167 @@
+package log
+
+import (
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/elastic/beats/filebeat/harvester"
+	. "github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/libbeat/common"
+	file_helper "github.com/elastic/beats/libbeat/common/file"
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// lsfBackfills holds the lsf_backfill patterns backfilled by the process
+var lsfBackfills = struct {
+	sync.Mutex
+	m map[string]bool
+}{m: make(map[string]bool)}
+
+// lsfShouldBackfill tells if the harvester is to backfill: its file is read
+// from its start, no file was harvested under its name before, as by a
+// rotation or a run before, and no harvester backfilled the same patterns
+func (h *Harvester) lsfShouldBackfill() bool {
+	if len(h.config.LsfBackfill) == 0 || h.state.Offset != 0 || h.lsfFileType < 0 {
+		return false
+	}
+	for _, st := range h.states.GetStates() {
+		if st.Source == h.state.Source && !st.FileStateOS.IsSame(h.state.FileStateOS) {
+			return false
+		}
+	}
+	key := strings.Join(h.config.LsfBackfill, "\x00")
+	lsfBackfills.Lock()
+	defer lsfBackfills.Unlock()
+	if lsfBackfills.m[key] {
+		return false
+	}
+	lsfBackfills.m[key] = true
+	return true
+}
+
+// backfill publishes the rotated files of lsf_backfill, oldest first, in
+// the order of their records, their lines decoded and filtered as those of
+// the harvested file. Their events carry no state, the files are not
+// harvested. Returns false if the harvester is to stop.
+func (h *Harvester) backfill(forwarder *harvester.Forwarder) bool {
+	files := rotatedFiles(h.config.LsfBackfill, h.state.Source)
+	if len(files) == 0 {
+		return true
+	}
+	logp.Info("Backfilling %v before %s", files, h.state.Source)
+
+	start := time.Now()
+	if !h.lsfPlain() {
+		// records of encoded files are only found once decoded, the files
+		// are read one after the other
+		for _, name := range files {
+			f, err := os.Open(name)
+			if err != nil {
+				logp.Err("Fail reading backfill file %s: %s", name, err.Error())
+				continue
+			}
+			var fileID string
+			if info, err := f.Stat(); err == nil {
+				fileID = file_helper.GetOSState(info).String()
+				lsfDedup.forget(fileID)
+			}
+			ok := h.readLsfFile(forwarder, f, fileID, 0, nil)
+			f.Close()
+			if !ok {
+				return false
+			}
+		}
+		logp.Info("Backfilled %d files in %v", len(files), time.Since(start))
+		return true
+	}
+
+	// records are dropped by include_lines and exclude_lines as those of
+	// the harvested file
+	var keep func([]byte) bool
+	if len(h.config.IncludeLines) > 0 || len(h.config.ExcludeLines) > 0 {
+		keep = h.exportContent
+	}
+	events := 0
+	ok := true
+	fileIDs := make(map[string]string, len(files))
+	NewLsbParser().Backfill(files, h.lsfFileType, h.config.LsfTopics, keep, func(file string, offset int64, msgs []MessageWithTopic) bool {
+		select {
+		case <-h.done:
+			ok = false
+			return false
+		default:
+		}
+		fields := common.MapStr{
+			"source": file,
+			"offset": offset,
+		}
+		fileID, found := fileIDs[file]
+		if !found {
+			if info, err := os.Stat(file); err == nil {
+				// read from its start, as a file new to the harvesters
+				fileID = file_helper.GetOSState(info).String()
+				lsfDedup.forget(fileID)
+			}
+			fileIDs[file] = fileID
+		}
+		ts := time.Now()
+		for i := range msgs {
+			if !h.sendEvent(lsfEvent(&msgs[i], fields, ts, fileID, offset), forwarder) {
+				ok = false
+				return false
+			}
+			events++
+		}
+		return true
+	})
+	logp.Info("Backfilled %d events of %d files in %v", events, len(files), time.Since(start))
+	return ok
+}
+
+// rotatedFiles returns the files matching patterns but source, oldest
+// first: lsb.acct.N before lsb.acct.1, then files with no rotation number
+// by name
+func rotatedFiles(patterns []string, source string) []string {
+	srcInfo, _ := os.Stat(source)
+	seen := make(map[string]bool)
+	var files []string
+	for _, pattern := range patterns {
+		matches, err := filepath.Glob(pattern)
+		if err != nil {
+			logp.Err("Fail expanding lsf_backfill %s: %s", pattern, err.Error())
+			continue
+		}
+		for _, m := range matches {
+			info, err := os.Stat(m)
+			if err != nil || !info.Mode().IsRegular() || seen[m] {
+				continue
+			}
+			if srcInfo != nil && os.SameFile(info, srcInfo) {
+				continue
+			}
+			seen[m] = true
+			files = append(files, m)
+		}
+	}
+
+	rotation := func(name string) int {
+		i := strings.LastIndexByte(name, '.')
+		if n, err := strconv.Atoi(name[i+1:]); i >= 0 && err == nil {
+			return n
+		}
+		return -1
+	}
+	sort.SliceStable(files, func(i, j int) bool {
+		ri, rj := rotation(files[i]), rotation(files[j])
+		if ri != rj {
+			return ri > rj
+		}
+		return files[i] < files[j]
+	})
+	return files
+}
@@ -0,0 +1,94 @@
+package log
+
+import (
+	"time"
+
+	"github.com/elastic/beats/filebeat/reader"
+)
+
+// lineBatcher collects the lines of a harvester reader into batches of up
+// to size lines. A batch is returned once it is full, or once timeout has
+// passed since its first line, so lines read before the reader blocks at
+// the end of a file are not held back. With size 1 lines are read
+// directly, without the reading goroutine.
+type lineBatcher struct {
+	reader  reader.Reader
+	size    int
+	timeout time.Duration
+	done    <-chan struct{}
+
+	lines chan lineOrErr
+	batch []reader.Message
+	err   error
+}
+
+type lineOrErr struct {
+	message reader.Message
+	err     error
+}
+
+func newLineBatcher(r reader.Reader, size int, timeout time.Duration, done <-chan struct{}) *lineBatcher {
+	b := &lineBatcher{reader: r, size: size, timeout: timeout, done: done}
+	if size > 1 {
+		b.lines = make(chan lineOrErr, size)
+		go b.run()
+	}
+	return b
+}
+
+// run reads lines until the reader fails, which it does once it is
+// closed on shutdown
+func (b *lineBatcher) run() {
+	for {
+		message, err := b.reader.Next()
+		select {
+		case b.lines <- lineOrErr{message, err}:
+		case <-b.done:
+			return
+		}
+		if err != nil {
+			return
+		}
+	}
+}
+
+// Next returns the next batch of lines and the error which ended reading,
+// if any. A batch may come with the error, it holds the lines read before
+// it. The batch is reused by the next call.
+func (b *lineBatcher) Next() ([]reader.Message, error) {
+	b.batch = b.batch[:0]
+	if b.err != nil {
+		return nil, b.err
+	}
+	if b.lines == nil {
+		message, err := b.reader.Next()
+		if err != nil {
+			b.err = err
+			return nil, err
+		}
+		return append(b.batch, message), nil
+	}
+
+	var timeout <-chan time.Time
+	for len(b.batch) < b.size {
+		var line lineOrErr
+		select {
+		case line = <-b.lines:
+		case <-timeout:
+			return b.batch, nil
+		case <-b.done:
+			return b.batch, ErrClosed
+		}
+		if line.err != nil {
+			b.err = line.err
+			return b.batch, line.err
+		}
+		if len(b.batch) == 0 {
+			timer := time.NewTimer(b.timeout)
+			defer timer.Stop()
+			timeout = timer.C
+		}
+		b.batch = append(b.batch, line.message)
+	}
+	return b.batch, nil
+}
@@ -0,0 +1,91 @@
+package log
+
+import (
+	"strconv"
+	"strings"
+	"sync"
+
+	"github.com/elastic/beats/libbeat/monitoring"
+)
+
+// A message of an LSF record has the id <inode>-<device>:<offset>:<topic>
+// of the file, the offset of the record in it and the index of its topic,
+// so a record read again after a restart gives messages with the same ids.
+// Outputs pass it on for the broker to drop duplicates, and the messages
+// sent again within the same process are dropped before that.
+
+var (
+	lsfDuplicates = monitoring.NewInt(harvesterMetrics, "lsf_duplicates")
+
+	// ids of the last messages sent by all harvesters
+	lsfDedup dedupWindow
+)
+
+// lsfMessageID returns the id of the message of topic of the record at
+// offset of the file of fileID
+func lsfMessageID(fileID string, offset int64, topic int) string {
+	buf := make([]byte, 0, len(fileID)+24)
+	buf = append(buf, fileID...)
+	buf = append(buf, ':')
+	buf = strconv.AppendInt(buf, offset, 10)
+	buf = append(buf, ':')
+	buf = strconv.AppendInt(buf, int64(topic), 10)
+	return string(buf)
+}
+
+// dedupWindow holds the last ids added, up to its size, in a ring
+type dedupWindow struct {
+	sync.Mutex
+	seen map[string]struct{}
+	ids  []string
+	next int
+}
+
+// grow makes the window hold at least n ids, keeping those it holds
+func (w *dedupWindow) grow(n int) {
+	w.Lock()
+	defer w.Unlock()
+	if n <= len(w.ids) {
+		return
+	}
+	ids := make([]string, n)
+	copy(ids, w.ids[w.next:])
+	copy(ids[len(w.ids)-w.next:], w.ids[:w.next])
+	w.ids, w.next = ids, len(w.ids)
+	if w.seen == nil {
+		w.seen = make(map[string]struct{}, n)
+	}
+}
+
+// add adds id to the window, the oldest id making room for it. Returns
+// false if id is in the window already.
+func (w *dedupWindow) add(id string) bool {
+	w.Lock()
+	defer w.Unlock()
+	if len(w.ids) == 0 {
+		return true
+	}
+	if _, ok := w.seen[id]; ok {
+		return false
+	}
+	if old := w.ids[w.next]; old != "" {
+		delete(w.seen, old)
+	}
+	w.ids[w.next] = id
+	w.seen[id] = struct{}{}
+	w.next = (w.next + 1) % len(w.ids)
+	return true
+}
+
+// forget removes the ids of the messages of the file of fileID
+func (w *dedupWindow) forget(fileID string) {
+	w.Lock()
+	defer w.Unlock()
+	prefix := fileID + ":"
+	for i, id := range w.ids {
+		if strings.HasPrefix(id, prefix) {
+			delete(w.seen, id)
+			w.ids[i] = ""
+		}
+	}
+}
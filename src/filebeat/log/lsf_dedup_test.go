@@ -0,0 +1,38 @@
+package log
+
+import (
+	"testing"
+
+	"github.com/elastic/beats/filebeat/harvester"
+	"github.com/elastic/beats/filebeat/input/file"
+	"github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/libbeat/common"
+)
+
+// A message sent again is dropped, but the state it carries is sent on
+// and kept as the harvester's
+func TestLsfDedupKeepsState(t *testing.T) {
+	lsfDedup.grow(16)
+	out := &rotationOutlet{}
+	h := &Harvester{states: &file.States{}, source: File{}, lsfFileType: -1}
+	forwarder := harvester.NewForwarder(out)
+	src := file.State{Source: "lsb.stream", Offset: 100}
+	msg := &parselsb.MessageWithTopic{Text: `{"job_id":7}`}
+	for i := int64(0); i < 3; i++ {
+		data := lsfEvent(msg, common.MapStr{}, src.Timestamp, "1-2", 0)
+		src.Offset = 100 + i
+		data.SetState(src)
+		if !h.sendEvent(data, forwarder) {
+			t.Fatal("send failed")
+		}
+	}
+	if len(out.ids) != 1 || out.ids[0] != 7 {
+		t.Fatalf("events %v, want [7]", out.ids)
+	}
+	if len(out.states) != 2 || out.states[1] != 102 {
+		t.Fatalf("state updates %v, want [101 102]", out.states)
+	}
+	if st := h.states.GetStates(); len(st) != 1 || st[0].Offset != 102 {
+		t.Fatalf("states %v", st)
+	}
+}
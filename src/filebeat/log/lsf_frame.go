@@ -0,0 +1,96 @@
+package log
+
+import (
+	"io"
+	"os"
+
+	. "github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/filebeat/reader"
+	"github.com/elastic/beats/filebeat/reader/encode"
+	"github.com/elastic/beats/filebeat/reader/limit"
+	"github.com/elastic/beats/filebeat/reader/strip_newline"
+)
+
+// recordFramer joins the lines of an LSF record with line breaks in a
+// quoted field, such as a job command with a here-document, so the parser
+// gets whole records. Lines leaving no quote open, nearly all of them,
+// are passed on as they are.
+type recordFramer struct {
+	reader   reader.Reader
+	maxBytes int
+	// a line read past the end of a broken record
+	next *reader.Message
+}
+
+func newRecordFramer(r reader.Reader, maxBytes int) *recordFramer {
+	return &recordFramer{reader: r, maxBytes: maxBytes}
+}
+
+func (f *recordFramer) Next() (reader.Message, error) {
+	message, err := f.line()
+	if err != nil || !QuoteOpen(message.Content, false) {
+		return message, err
+	}
+
+	// lines are only valid until the next read, the record is a copy
+	content := append([]byte(nil), message.Content...)
+	for f.maxBytes <= 0 || len(content) < f.maxBytes {
+		line, err := f.reader.Next()
+		if err != nil {
+			// the offset stays at the start of the record, which is read
+			// again by the next harvester
+			return reader.Message{}, err
+		}
+		if RecordHead(line.Content) {
+			f.next = &line
+			break
+		}
+		content = append(append(content, '\n'), line.Content...)
+		message.Bytes += line.Bytes
+		if !QuoteOpen(line.Content, true) {
+			break
+		}
+	}
+	message.Content = content
+	return message, nil
+}
+
+func (f *recordFramer) line() (reader.Message, error) {
+	if f.next != nil {
+		message := *f.next
+		f.next = nil
+		return message, nil
+	}
+	return f.reader.Next()
+}
+
+// lsfPlain tells if the harvester's files are read as they are, with no
+// encoding to decode
+func (h *Harvester) lsfPlain() bool {
+	return h.config.Encoding == "" || h.config.Encoding == "plain" || h.config.Encoding == "utf-8"
+}
+
+// lsfFileReader returns the records of f, an LSF file other than the
+// harvester's, from offset as the harvester reads its own: decoded with its
+// encoding and framed. An offset of 0 is moved past what the encoding read
+// to detect itself. Returns the offset reading starts at.
+func (h *Harvester) lsfFileReader(f *os.File, offset int64) (reader.Reader, int64, error) {
+	enc, err := h.encodingFactory(f)
+	if err != nil {
+		return nil, 0, err
+	}
+	if offset > 0 {
+		_, err = f.Seek(offset, io.SeekStart)
+	} else {
+		offset, err = f.Seek(0, io.SeekCurrent)
+	}
+	if err != nil {
+		return nil, 0, err
+	}
+	r, err := encode.New(f, enc, h.config.BufferSize)
+	if err != nil {
+		return nil, 0, err
+	}
+	r = newRecordFramer(strip_newline.New(r), h.config.MaxBytes)
+	return limit.New(r, h.config.MaxBytes), offset, nil
+}
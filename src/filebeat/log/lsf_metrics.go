@@ -0,0 +1,105 @@
+package log
+
+import (
+	"sync"
+	"time"
+
+	. "github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/libbeat/monitoring"
+)
+
+// Along with the parser metrics of parselsb, these tell the stage holding
+// LSF events back: a harvester reads lines of its source, waits for the
+// parser, and is blocked sending the events while the output is behind.
+
+const (
+	// lines per second of a source are counted over this window
+	lsfRateWindow = 10 * time.Second
+)
+
+var (
+	lsfMetrics = harvesterMetrics.NewRegistry("lsf")
+
+	// time sending an event blocked the harvester
+	lsfPublishBlocked = NewHistogram(lsfMetrics, "publish_blocked")
+
+	// lines read of each source harvested
+	lsfSources = &sourceRates{m: make(map[string]*sourceRate)}
+)
+
+func init() {
+	monitoring.NewFunc(lsfMetrics, "sources", lsfSources.report)
+}
+
+type sourceRates struct {
+	sync.Mutex
+	m map[string]*sourceRate
+}
+
+type sourceRate struct {
+	// harvesters of the source, as that of a rotated file and that of
+	// the new one
+	refs  int
+	lines int64
+	// lines per second in the last window, and the window going on
+	rate        float64
+	windowStart time.Time
+	windowLines int64
+}
+
+// open returns the lines read of source, counted until it is closed by
+// all its harvesters
+func (s *sourceRates) open(source string) *sourceRate {
+	s.Lock()
+	defer s.Unlock()
+	r := s.m[source]
+	if r == nil {
+		r = &sourceRate{windowStart: time.Now()}
+		s.m[source] = r
+	}
+	r.refs++
+	return r
+}
+
+func (s *sourceRates) close(source string) {
+	s.Lock()
+	defer s.Unlock()
+	if r := s.m[source]; r != nil {
+		if r.refs--; r.refs <= 0 {
+			delete(s.m, source)
+		}
+	}
+}
+
+// add counts n lines read
+func (s *sourceRates) add(r *sourceRate, n int) {
+	now := time.Now()
+	s.Lock()
+	defer s.Unlock()
+	r.lines += int64(n)
+	if d := now.Sub(r.windowStart); d >= lsfRateWindow {
+		r.rate = float64(r.lines-r.windowLines) / d.Seconds()
+		r.windowStart, r.windowLines = now, r.lines
+	}
+}
+
+// report reports the lines and the lines per second of each source. The
+// first window, and one left open longer as no lines were read since,
+// count as ended.
+func (s *sourceRates) report(_ monitoring.Mode, V monitoring.Visitor) {
+	now := time.Now()
+	s.Lock()
+	defer s.Unlock()
+	V.OnRegistryStart()
+	defer V.OnRegistryFinished()
+	for source, r := range s.m {
+		rate := r.rate
+		if d := now.Sub(r.windowStart); d >= lsfRateWindow || r.windowLines == 0 {
+			rate = float64(r.lines-r.windowLines) / d.Seconds()
+		}
+		monitoring.ReportNamespace(V, source, func() {
+			monitoring.ReportInt(V, "lines", r.lines)
+			monitoring.ReportFloat(V, "lines_per_sec", rate)
+		})
+	}
+}
@@ -0,0 +1,179 @@
+package log
+
+import (
+	"bytes"
+	"os"
+	"sync"
+	"time"
+
+	"github.com/elastic/beats/filebeat/reader"
+)
+
+// mmapReader reads the lines of an LSF file straight from a mapping of it,
+// in place of the line reader chain. Lines are found with bytes.IndexByte,
+// which scans with vector instructions, and handed out as slices of the
+// mapping, so nothing is copied before the parser. The mapping reserves
+// address space beyond the end of the file, so a growing file is seen
+// without remapping; only once it outgrows the reservation is it mapped
+// again. A mapping superseded so is kept while lines handed out may still
+// point into it, until the harvester released the offset they end by.
+//
+// A file truncated in place while mapped faults on access of the lost
+// pages, so lsf_mmap is only for files which LSF rotates by renaming.
+type mmapReader struct {
+	tail
+	// lines longer than maxBytes are cut, as by the limit reader
+	maxBytes int
+
+	mu   sync.Mutex
+	data []byte
+	// mappings superseded by data, oldest first
+	old     []mmapOld
+	size    int64
+	offset  int64
+	scanned int64
+	closed  bool
+}
+
+// mmapOld is a superseded mapping, and the offset the lines handed out of
+// it end by
+type mmapOld struct {
+	data  []byte
+	until int64
+}
+
+const (
+	// address space reserved beyond the end of the file
+	mmapReserve = 1 << 30
+)
+
+func newMmapReader(f *os.File, offset int64, config LogConfig, maxBytes int, done <-chan struct{}, opts tailOptions) (*mmapReader, error) {
+	r := &mmapReader{
+		tail:     newTail(f, config, done, opts),
+		maxBytes: maxBytes,
+		offset:   offset,
+		scanned:  offset,
+	}
+	info, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if err := r.remap(info.Size()); err != nil {
+		return nil, err
+	}
+	return r, nil
+}
+
+// remap maps the file anew for size bytes plus the reservation
+func (r *mmapReader) remap(size int64) error {
+	length := size + mmapReserve
+	data, err := mapFile(r.file, length)
+	if err != nil {
+		return err
+	}
+	if r.data != nil {
+		r.old = append(r.old, mmapOld{data: r.data, until: r.offset})
+	}
+	r.data = data
+	r.size = size
+	return nil
+}
+
+// Next returns the next complete line, waiting for it at the end of the
+// file as the log reader does
+func (r *mmapReader) Next() (reader.Message, error) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	for {
+		if r.closed {
+			return reader.Message{}, ErrClosed
+		}
+		select {
+		case <-r.done:
+			return reader.Message{}, ErrClosed
+		default:
+		}
+
+		if r.scanned < r.size {
+			if i := bytes.IndexByte(r.data[r.scanned:r.size], '\n'); i >= 0 {
+				end := r.scanned + int64(i) + 1
+				message := r.message(r.data[r.offset:end])
+				r.offset, r.scanned = end, end
+				return message, nil
+			}
+			r.scanned = r.size
+		}
+
+		info, err := r.file.Stat()
+		if err != nil {
+			return reader.Message{}, err
+		}
+		if size := info.Size(); size < r.offset {
+			return reader.Message{}, ErrFileTruncate
+		} else if size > r.size {
+			if size > int64(len(r.data)) {
+				if err := r.remap(size); err != nil {
+					return reader.Message{}, err
+				}
+			}
+			r.size = size
+			r.read()
+			continue
+		}
+
+		if err := r.errorChecks(info, r.offset); err != nil {
+			return reader.Message{}, err
+		}
+		// unlocked, so Close does not wait for it
+		r.mu.Unlock()
+		r.wait()
+		r.mu.Lock()
+	}
+}
+
+// message returns a line without its line ending
+func (r *mmapReader) message(line []byte) reader.Message {
+	content := line[:len(line)-1]
+	if n := len(content); n > 0 && content[n-1] == '\r' {
+		content = content[:n-1]
+	}
+	if r.maxBytes > 0 && len(content) > r.maxBytes {
+		content = content[:r.maxBytes]
+	}
+	return reader.Message{
+		Ts:      time.Now(),
+		Content: content,
+		Bytes:   len(line),
+	}
+}
+
+// release unmaps the superseded mappings whose lines all end by offset,
+// once the lines up to offset are no longer used
+func (r *mmapReader) release(offset int64) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	n := 0
+	for ; n < len(r.old) && r.old[n].until <= offset; n++ {
+		unmapFile(r.old[n].data)
+	}
+	if n > 0 {
+		r.old = append(r.old[:0], r.old[n:]...)
+	}
+}
+
+// Close unmaps the file. Lines handed out must not be used afterwards.
+func (r *mmapReader) Close() {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if r.closed {
+		return
+	}
+	r.closed = true
+	for _, old := range r.old {
+		unmapFile(old.data)
+	}
+	if r.data != nil {
+		unmapFile(r.data)
+	}
+	r.old, r.data = nil, nil
+}
@@ -0,0 +1,13 @@
+package log
+
+import (
+	"errors"
+	"os"
+)
+
+// mapFile fails, lsf_mmap falls back to the reader chain here
+func mapFile(f *os.File, length int64) ([]byte, error) {
+	return nil, errors.New("lsf_mmap is not supported on windows")
+}
+
+func unmapFile(data []byte) {}
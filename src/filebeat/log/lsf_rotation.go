@@ -0,0 +1,301 @@
+package log
+
+import (
+	"bytes"
+	"io"
+	"os"
+	"sync"
+	"time"
+
+	"github.com/elastic/beats/filebeat/harvester"
+	"github.com/elastic/beats/filebeat/input/file"
+	. "github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/filebeat/reader"
+	"github.com/elastic/beats/libbeat/common"
+	file_helper "github.com/elastic/beats/libbeat/common/file"
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// mbatchd rotates lsb.stream by renaming it to lsb.stream.N and goes on
+// in a new lsb.stream. Files are told apart by inode: the harvester of
+// the renamed file reads it to its end and stops (ErrRotated), and the
+// harvester of the new file, under the same name, waits for it before
+// reading, so no event is lost and their order is kept. A renamed file
+// left with unread records, as by a rotation while lsfeventsbeat was
+// down, is read to its end first by the harvester of the new file.
+
+// lsfHandoffs holds the latest harvester of each LSF file name
+var lsfHandoffs = struct {
+	sync.Mutex
+	m map[string]*lsfHandoff
+}{m: make(map[string]*lsfHandoff)}
+
+type lsfHandoff struct {
+	fileOS file_helper.StateOS
+	// the harvester of the file which had the name before, until it stopped
+	prev *lsfHandoff
+	// closed once the harvester stopped
+	drained chan struct{}
+}
+
+const (
+	// records of a rotated file parsed in one round trip
+	lsfDrainBatch = 256
+)
+
+// lsfRegister makes the harvester the latest of its file name. It is done
+// on setup, as the input finds the files under the name in their order,
+// while harvesters may start running in any order.
+func (h *Harvester) lsfRegister() {
+	mine := &lsfHandoff{fileOS: h.state.FileStateOS, drained: make(chan struct{})}
+	lsfHandoffs.Lock()
+	if prev := lsfHandoffs.m[h.state.Source]; prev != nil && !prev.fileOS.IsSame(mine.fileOS) {
+		mine.prev = prev
+	}
+	lsfHandoffs.m[h.state.Source] = mine
+	lsfHandoffs.Unlock()
+	h.lsfHandoff = mine
+}
+
+// lsfTakeOver waits for the harvester of the file which had the name
+// before to read it to its end. Returns false if the harvester is to stop.
+func (h *Harvester) lsfTakeOver() bool {
+	prev := h.lsfHandoff.prev
+	if prev == nil {
+		return true
+	}
+	logp.Info("Waiting for the harvester of the file rotated from %s", h.state.Source)
+	select {
+	case <-prev.drained:
+		h.lsfHandoff.prev = nil
+		return true
+	case <-h.done:
+		return false
+	}
+}
+
+// lsfRelease lets the harvester of the next file under the name go on
+func (h *Harvester) lsfRelease() {
+	mine := h.lsfHandoff
+	if mine == nil {
+		return
+	}
+	close(mine.drained)
+	lsfHandoffs.Lock()
+	if lsfHandoffs.m[h.state.Source] == mine {
+		delete(lsfHandoffs.m, h.state.Source)
+	}
+	lsfHandoffs.Unlock()
+}
+
+// lsfRotated returns the states of the files which had the name of the
+// harvester's file before, no longer harvested
+func (h *Harvester) lsfRotated() []file.State {
+	var states []file.State
+	for _, st := range h.states.GetStates() {
+		if st.Source == h.state.Source && st.Finished && !st.FileStateOS.IsSame(h.state.FileStateOS) {
+			states = append(states, st)
+		}
+	}
+	return states
+}
+
+// lsfCatchUp reads the files rotated from the harvester's file before it
+// with records left unread to their end, oldest first. Files rotated after
+// the first such file without having been harvested at all, as when
+// rotated again before the next scan, are read from their start. Returns
+// false if the harvester is to stop.
+func (h *Harvester) lsfCatchUp(forwarder *harvester.Forwarder, rotated []file.State) bool {
+	if len(rotated) == 0 {
+		return true
+	}
+	files, ok := h.lsfRotatedFiles()
+	defer closeFiles(files)
+	if !ok {
+		return false
+	}
+	states := h.states.GetStates()
+	known := false
+	for _, f := range files {
+		info, err := f.Stat()
+		if err != nil {
+			continue
+		}
+		st := file.State{
+			Source:      h.state.Source,
+			Finished:    true,
+			Fileinfo:    info,
+			FileStateOS: file_helper.GetOSState(info),
+			TTL:         h.state.TTL,
+			Type:        h.state.Type,
+		}
+		found := false
+		for _, s := range states {
+			if s.FileStateOS.IsSame(st.FileStateOS) {
+				st, found = s, true
+				break
+			}
+		}
+		if found {
+			// files harvested under another name, or still harvested,
+			// are left alone
+			if st.Source != h.state.Source || !st.Finished {
+				continue
+			}
+			known = true
+		} else if !known {
+			continue
+		}
+		if st.Offset < info.Size() && !h.drainRotated(forwarder, st, f) {
+			return false
+		}
+	}
+	return true
+}
+
+// lsfRotatedFiles opens the files rotated from the harvester's file before
+// it, oldest first. They are listed again until no file was rotated in
+// between, as names shift on each rotation. Returns false if the harvester
+// is to stop.
+func (h *Harvester) lsfRotatedFiles() ([]*os.File, bool) {
+	files, fileOS := h.openRotated()
+	for {
+		again, againOS := h.openRotated()
+		closeFiles(files)
+		files = again
+		same := len(againOS) == len(fileOS)
+		for i := 0; same && i < len(fileOS); i++ {
+			same = fileOS[i].IsSame(againOS[i])
+		}
+		if same {
+			return files, true
+		}
+		fileOS = againOS
+		select {
+		case <-h.done:
+			return files, false
+		default:
+		}
+	}
+}
+
+// openRotated opens the files rotated from the harvester's file before it,
+// oldest first, with the state of each
+func (h *Harvester) openRotated() ([]*os.File, []file_helper.StateOS) {
+	var files []*os.File
+	var fileOS []file_helper.StateOS
+	for _, name := range rotatedFiles([]string{h.state.Source + ".*"}, h.state.Source) {
+		f, err := os.Open(name)
+		if err != nil {
+			continue
+		}
+		info, err := f.Stat()
+		if err != nil {
+			f.Close()
+			continue
+		}
+		fos := file_helper.GetOSState(info)
+		if fos.IsSame(h.state.FileStateOS) {
+			// rotated itself since, the files after it are newer
+			f.Close()
+			break
+		}
+		files, fileOS = append(files, f), append(fileOS, fos)
+	}
+	return files, fileOS
+}
+
+func closeFiles(files []*os.File) {
+	for _, f := range files {
+		f.Close()
+	}
+}
+
+// drainRotated publishes the records of f, the file of st, from the offset
+// of st to its end. Their events carry the state of the file.
+func (h *Harvester) drainRotated(forwarder *harvester.Forwarder, st file.State, f *os.File) bool {
+	fileID := st.FileStateOS.String()
+	if st.Offset == 0 {
+		lsfDedup.forget(fileID)
+	}
+	logp.Info("Reading %s rotated from %s, from offset %d", f.Name(), st.Source, st.Offset)
+	return h.readLsfFile(forwarder, f, fileID, st.Offset, &st)
+}
+
+// readLsfFile publishes the records of f, an LSF file other than the
+// harvester's, from offset to its end. Lines are decoded, and dropped by
+// include_lines and exclude_lines, as those of the harvester's file. With
+// st, their events carry the state of the file. Returns false if the
+// harvester is to stop.
+func (h *Harvester) readLsfFile(forwarder *harvester.Forwarder, f *os.File, fileID string, offset int64, st *file.State) bool {
+	name := f.Name()
+	r, offset, err := h.lsfFileReader(f, offset)
+	if err != nil {
+		logp.Err("Fail reading %s: %s", name, err.Error())
+		return true
+	}
+
+	parser := NewLsbParser()
+	retChan := make(chan [][]MessageWithTopic)
+	recs := make([]LsfRec, 0, lsfDrainBatch)
+	// offset of each record, and after the last
+	offsets := make([]int64, 0, lsfDrainBatch+1)
+	for {
+		select {
+		case <-h.done:
+			return false
+		default:
+		}
+
+		recs, offsets = recs[:0], append(offsets[:0], offset)
+		for err == nil && len(recs) < lsfDrainBatch {
+			var message reader.Message
+			message, err = r.Next()
+			if offset == 0 {
+				message.Content = bytes.Trim(message.Content, "\xef\xbb\xbf")
+			}
+			offset += int64(message.Bytes)
+			if !message.IsEmpty() && h.exportContent(message.Content) {
+				recs = append(recs, LsfRec{Type: h.lsfFileType, RawContent: append([]byte(nil), message.Content...), Topics: h.config.LsfTopics})
+				offsets = append(offsets, offset)
+			} else {
+				offsets[len(offsets)-1] = offset
+			}
+		}
+
+		var results [][]MessageWithTopic
+		if len(recs) > 0 {
+			parser.PostBatch(recs, retChan)
+			results = <-retChan
+		}
+		ts := time.Now()
+		for i, msgs := range results {
+			fields := common.MapStr{
+				"source": name,
+				"offset": offsets[i],
+			}
+			for j := range msgs {
+				data := lsfEvent(&msgs[j], fields, ts, fileID, offsets[i])
+				if st != nil && j == len(msgs)-1 {
+					st.Offset = offsets[i+1]
+					data.SetState(*st)
+				}
+				if !h.sendEvent(data, forwarder) {
+					return false
+				}
+			}
+		}
+		if st != nil {
+			st.Offset = offset
+			h.states.Update(*st)
+		}
+
+		if err == io.EOF {
+			return true
+		}
+		if err != nil {
+			logp.Err("Fail reading %s: %s", name, err.Error())
+			return true
+		}
+	}
+}
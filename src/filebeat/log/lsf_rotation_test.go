@@ -0,0 +1,332 @@
+package log
+
+import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"regexp"
+	"strconv"
+	"strings"
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/elastic/beats/filebeat/channel"
+	"github.com/elastic/beats/filebeat/harvester"
+	"github.com/elastic/beats/filebeat/input/file"
+	"github.com/elastic/beats/filebeat/parselsb"
+	"github.com/elastic/beats/filebeat/reader/encode/encoding"
+	"github.com/elastic/beats/filebeat/util"
+	file_helper "github.com/elastic/beats/libbeat/common/file"
+	"github.com/elastic/beats/libbeat/common/match"
+)
+
+var rotationJobId = regexp.MustCompile(`"job_id":(\d+)`)
+
+func rotationRec(id int) string {
+	return fmt.Sprintf("\"JOB_STATUS\" \"10.1\" %d %d 4 0 0 0.0620 %d 0 0 0 0 \"\" -1 \"\" -1 -1 0 0\n", 1539856000+id, id, 1539856000+id)
+}
+
+// lsfStreamLibrary skips the test unless the parser loads the LSF stream
+// library: liblsbstream.so from the library path or $LSF_STREAM_LIBRARY,
+// such as the mock built by make mocktest under lsfeventsparser
+func lsfStreamLibrary(t *testing.T) {
+	retChan := make(chan [][]parselsb.MessageWithTopic)
+	rec := parselsb.LsfRec{
+		Type:       parselsb.StreamFile,
+		RawContent: []byte(strings.TrimSpace(rotationRec(1))),
+		Topics:     []parselsb.Topic{{TopicName: "raw", Type: "job.raw", IncludeFields: []string{"job_id"}}},
+	}
+	parselsb.NewLsbParser().PostBatch([]parselsb.LsfRec{rec}, retChan)
+	if res := <-retChan; len(res) == 0 || len(res[0]) == 0 || !rotationJobId.MatchString(res[0][0].Text) {
+		t.Skip("no LSF stream library, set LSF_STREAM_LIBRARY")
+	}
+}
+
+// rotationOutlet keeps the job ids of the events published, and the
+// offsets of the state-only updates
+type rotationOutlet struct {
+	mu     sync.Mutex
+	ids    []int
+	states []int64
+	err    error
+}
+
+func (o *rotationOutlet) Close() error { return nil }
+
+func (o *rotationOutlet) OnEvent(d *util.Data) bool {
+	o.mu.Lock()
+	defer o.mu.Unlock()
+	if d.Event.Fields == nil {
+		o.states = append(o.states, d.GetState().Offset)
+		return true
+	}
+	message, _ := d.Event.Fields["message"].(string)
+	m := rotationJobId.FindStringSubmatch(message)
+	if m == nil {
+		o.err = fmt.Errorf("no job id in %q", message)
+		return true
+	}
+	id, _ := strconv.Atoi(m[1])
+	o.ids = append(o.ids, id)
+	return true
+}
+
+// wait returns the job ids once there are n of them, or after a timeout
+func (o *rotationOutlet) wait(t *testing.T, n int) []int {
+	for deadline := time.Now().Add(60 * time.Second); time.Now().Before(deadline); time.Sleep(50 * time.Millisecond) {
+		o.mu.Lock()
+		done := len(o.ids) >= n
+		o.mu.Unlock()
+		if done {
+			// more would be duplicates
+			time.Sleep(200 * time.Millisecond)
+			break
+		}
+	}
+	o.mu.Lock()
+	defer o.mu.Unlock()
+	if o.err != nil {
+		t.Fatal(o.err)
+	}
+	return append([]int(nil), o.ids...)
+}
+
+// rotationInput starts a harvester for each file found under name, as the
+// log input does on a scan
+type rotationInput struct {
+	name    string
+	inotify bool
+	exclude []match.Matcher
+	states  *file.States
+	out     *rotationOutlet
+
+	mu      sync.Mutex
+	running map[file_helper.StateOS]*Harvester
+}
+
+func newRotationInput(name string, inotify bool, states *file.States) *rotationInput {
+	return &rotationInput{
+		name:    name,
+		inotify: inotify,
+		states:  states,
+		out:     &rotationOutlet{},
+		running: make(map[file_helper.StateOS]*Harvester),
+	}
+}
+
+func (in *rotationInput) scan() {
+	info, err := os.Stat(in.name)
+	if err != nil {
+		return
+	}
+	fileOS := file_helper.GetOSState(info)
+	in.mu.Lock()
+	defer in.mu.Unlock()
+	if in.running[fileOS] != nil {
+		return
+	}
+	state := file.State{Source: in.name, Fileinfo: info, FileStateOS: fileOS}
+	for _, st := range in.states.GetStates() {
+		if st.FileStateOS.IsSame(fileOS) {
+			state.Offset = st.Offset
+		}
+	}
+	factory, _ := encoding.FindEncoding("plain")
+	h := &Harvester{
+		config:          defaultConfig,
+		state:           state,
+		states:          in.states,
+		done:            make(chan struct{}),
+		stopWg:          &sync.WaitGroup{},
+		outletFactory:   func() channel.Outleter { return in.out },
+		publishState:    func(*util.Data) bool { return true },
+		encodingFactory: factory,
+	}
+	h.config.Type = harvester.LogType
+	h.config.LsfTopics = []parselsb.Topic{{TopicName: "raw", Type: "job.raw", IncludeFields: []string{"job_id"}}}
+	h.config.LsfInotify = in.inotify
+	h.config.ExcludeLines = in.exclude
+	h.config.Backoff = 10 * time.Millisecond
+	h.config.MaxBackoff = 100 * time.Millisecond
+	h.lsfFileType = parselsb.GetFileType(in.name)
+	if err := h.Setup(); err != nil {
+		// renamed since, as the input does it is harvested on a later scan
+		return
+	}
+	in.states.Update(h.state)
+	in.running[fileOS] = h
+	go h.Run()
+}
+
+func (in *rotationInput) stop() {
+	in.mu.Lock()
+	defer in.mu.Unlock()
+	for _, h := range in.running {
+		h.Stop()
+	}
+}
+
+// rotateLsf renames name to name.1 as mbatchd does, shifting the n files
+// rotated before
+func rotateLsf(name string, n int) {
+	for k := n; k >= 1; k-- {
+		os.Rename(fmt.Sprintf("%s.%d", name, k), fmt.Sprintf("%s.%d", name, k+1))
+	}
+	os.Rename(name, name+".1")
+}
+
+func checkJobIds(t *testing.T, ids []int, from, n int) {
+	for i, id := range ids {
+		if id != from+i {
+			t.Fatalf("event %d is job %d, want job %d", i, id, from+i)
+		}
+	}
+	if len(ids) != n {
+		t.Fatalf("%d events, want %d", len(ids), n)
+	}
+}
+
+func lsfTempDir(t *testing.T) string {
+	dir, err := ioutil.TempDir("", "lsfrotation")
+	if err != nil {
+		t.Fatal(err)
+	}
+	os.Setenv("LSF_BAK_PATH", dir)
+	return dir
+}
+
+// Records written as fast as possible across rotations are all published
+// once, in order, whether the end of a file is watched or polled
+func TestLsfRotationHandoff(t *testing.T) {
+	lsfStreamLibrary(t)
+	for _, inotify := range []bool{true, false} {
+		dir := lsfTempDir(t)
+		defer os.RemoveAll(dir)
+		name := filepath.Join(dir, "lsb.stream")
+		in := newRotationInput(name, inotify, &file.States{})
+		total, every := 30000, 2500
+
+		w, err := os.Create(name)
+		if err != nil {
+			t.Fatal(err)
+		}
+		in.scan()
+		stopScan := make(chan struct{})
+		go func() {
+			for {
+				select {
+				case <-stopScan:
+					return
+				case <-time.After(20 * time.Millisecond):
+					in.scan()
+				}
+			}
+		}()
+		for id := 0; id < total; id++ {
+			if id > 0 && id%every == 0 {
+				// mbatchd may still write to the file it renamed
+				rotateLsf(name, id/every-1)
+				w.WriteString(rotationRec(id))
+				w.Close()
+				id++
+				w, _ = os.Create(name)
+			}
+			w.WriteString(rotationRec(id))
+		}
+		w.Close()
+
+		ids := in.out.wait(t, total)
+		close(stopScan)
+		in.stop()
+		checkJobIds(t, ids, 0, total)
+	}
+}
+
+// After a restart the records left in rotated files are published before
+// those of the new file, but for those exclude_lines drops
+func TestLsfRotationCatchUp(t *testing.T) {
+	lsfStreamLibrary(t)
+	dir := lsfTempDir(t)
+	defer os.RemoveAll(dir)
+	name := filepath.Join(dir, "lsb.stream")
+	write := func(from, to int) {
+		var b []byte
+		for id := from; id < to; id++ {
+			b = append(b, rotationRec(id)...)
+		}
+		if err := ioutil.WriteFile(name, b, 0644); err != nil {
+			t.Fatal(err)
+		}
+	}
+
+	// read up to job 100, then rotated twice while stopped
+	write(0, 300)
+	read := 0
+	for id := 0; id < 100; id++ {
+		read += len(rotationRec(id))
+	}
+	info, _ := os.Stat(name)
+	states := &file.States{}
+	states.Update(file.State{Source: name, Finished: true, Offset: int64(read), FileStateOS: file_helper.GetOSState(info)})
+	rotateLsf(name, 0)
+	write(300, 500)
+	rotateLsf(name, 1)
+	write(500, 600)
+
+	// jobs 150 to 159 of lsb.stream.2, and 550 to 559 of lsb.stream
+	in := newRotationInput(name, true, states)
+	in.exclude = []match.Matcher{match.MustCompile(` 153985615\d `), match.MustCompile(` 153985655\d `)}
+	in.scan()
+	ids := in.out.wait(t, 480)
+	in.stop()
+	if len(ids) != 480 {
+		t.Fatalf("%d events, want 480", len(ids))
+	}
+	// lsb.stream.1 was never harvested, it is read from its start
+	checkJobIds(t, ids[:50], 100, 50)
+	checkJobIds(t, ids[50:440], 160, 390)
+	checkJobIds(t, ids[440:], 560, 40)
+}
+
+// lsf_backfill is done once, for the first file under the name of an
+// input with no registry state
+func TestLsfBackfillOnce(t *testing.T) {
+	dir := lsfTempDir(t)
+	defer os.RemoveAll(dir)
+	name := filepath.Join(dir, "lsb.acct")
+	newHarvester := func(states *file.States, patterns ...string) *Harvester {
+		if err := ioutil.WriteFile(name, nil, 0644); err != nil {
+			t.Fatal(err)
+		}
+		info, _ := os.Stat(name)
+		h := &Harvester{config: defaultConfig, states: states, lsfFileType: parselsb.AcctFile}
+		h.state = file.State{Source: name, Fileinfo: info, FileStateOS: file_helper.GetOSState(info)}
+		h.config.LsfBackfill = patterns
+		states.Update(h.state)
+		return h
+	}
+
+	states := &file.States{}
+	if !newHarvester(states, name+".*").lsfShouldBackfill() {
+		t.Fatal("first file not backfilled")
+	}
+	if newHarvester(&file.States{}, name+".*").lsfShouldBackfill() {
+		t.Fatal("backfilled twice")
+	}
+	// rotated, as with lsf_rotation: false
+	rotateLsf(name, 0)
+	if newHarvester(states, name+".[0-9]").lsfShouldBackfill() {
+		t.Fatal("rotated file backfilled")
+	}
+	// restarted at the start of the file, with a state of an older one
+	restarted := &file.States{}
+	restarted.Update(states.GetStates()[0])
+	lsfBackfills.Lock()
+	lsfBackfills.m = make(map[string]bool)
+	lsfBackfills.Unlock()
+	if newHarvester(restarted, name+".*").lsfShouldBackfill() {
+		t.Fatal("backfilled after a restart")
+	}
+}
@@ -0,0 +1,171 @@
+package log
+
+import (
+	"io"
+	"os"
+	"time"
+
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// tail is what the LSF readers do at the end of a file: the close_*
+// checks, and the wait for more data. With a watch the wait ends as soon
+// as the file is written to, the backoff is only a fallback.
+type tail struct {
+	file   *os.File
+	config LogConfig
+	done   <-chan struct{}
+	tailOptions
+
+	backoff  time.Duration
+	lastRead time.Time
+}
+
+// tailOptions are the lsf_* options of the end of a file
+type tailOptions struct {
+	// changes of the file, nil to poll it
+	watch *fileWatch
+	// stop at the end of the file once it was rotated
+	rotation bool
+}
+
+func newTail(f *os.File, config LogConfig, done <-chan struct{}, opts tailOptions) tail {
+	return tail{
+		file:        f,
+		config:      config,
+		done:        done,
+		tailOptions: opts,
+		backoff:     config.Backoff,
+		lastRead:    time.Now(),
+	}
+}
+
+// read notes that data was read
+func (t *tail) read() {
+	t.backoff = t.config.Backoff
+	t.lastRead = time.Now()
+}
+
+// errorChecks tells why to stop reading at offset, the end of the file,
+// if so
+func (t *tail) errorChecks(info os.FileInfo, offset int64) error {
+	if t.rotation && t.rotated(offset) {
+		return ErrRotated
+	}
+	if t.config.CloseEOF {
+		return io.EOF
+	}
+	if time.Since(t.lastRead) > t.config.CloseInactive {
+		return ErrInactive
+	}
+	if t.config.CloseRenamed {
+		if now, err := os.Stat(t.file.Name()); err != nil || !os.SameFile(info, now) {
+			return ErrRenamed
+		}
+	}
+	if t.config.CloseRemoved {
+		if _, err := os.Stat(t.file.Name()); err != nil {
+			return ErrRemoved
+		}
+	}
+	return nil
+}
+
+// rotated tells if the name of the file now names another file, and the
+// file was read to its end after the rotation. The name is looked up
+// first, so writes made before the rotation are seen in the size.
+func (t *tail) rotated(offset int64) bool {
+	now, err := os.Stat(t.file.Name())
+	if err != nil {
+		return false
+	}
+	info, err := t.file.Stat()
+	if err != nil || os.SameFile(info, now) {
+		return false
+	}
+	return info.Size() <= offset
+}
+
+// wait waits for the file to change, or the backoff to pass
+func (t *tail) wait() {
+	logp.Debug("harvester", "End of file reached: %s; Backoff now.", t.file.Name())
+	var changed chan struct{}
+	if t.watch != nil {
+		changed = t.watch.C
+	}
+	select {
+	case <-t.done:
+		return
+	case <-changed:
+		return
+	case <-time.After(t.backoff):
+	}
+	if t.backoff < t.config.MaxBackoff {
+		t.backoff = t.backoff * time.Duration(t.config.BackoffFactor)
+		if t.backoff > t.config.MaxBackoff {
+			t.backoff = t.config.MaxBackoff
+		}
+	}
+}
+
+// lsfLog is the log reader of an LSF file, which reads as Log does but
+// ends its reads on the tail
+type lsfLog struct {
+	tail
+	offset int64
+}
+
+func newLsfLog(f *os.File, config LogConfig, done <-chan struct{}, opts tailOptions) (*lsfLog, error) {
+	offset, err := f.Seek(0, io.SeekCurrent)
+	if err != nil {
+		return nil, err
+	}
+	return &lsfLog{tail: newTail(f, config, done, opts), offset: offset}, nil
+}
+
+// Read reads into buf, waiting at the end of the file until there is
+// data or reading is to stop
+func (l *lsfLog) Read(buf []byte) (int, error) {
+	total := 0
+	for {
+		select {
+		case <-l.done:
+			return 0, ErrClosed
+		default:
+		}
+
+		n, err := l.file.Read(buf)
+		if n > 0 {
+			l.offset += int64(n)
+			l.lastRead = time.Now()
+		}
+		total += n
+		if err == nil {
+			l.backoff = l.config.Backoff
+			return total, nil
+		}
+		buf = buf[n:]
+		if err != io.EOF {
+			return total, err
+		}
+
+		info, err := l.file.Stat()
+		if err != nil {
+			return total, err
+		}
+		if info.Size() < l.offset {
+			return total, ErrFileTruncate
+		}
+		if len(buf) == 0 {
+			return total, nil
+		}
+		if err := l.errorChecks(info, l.offset); err != nil {
+			// the data read comes first, the error with the next read
+			if total > 0 {
+				return total, nil
+			}
+			return 0, err
+		}
+		l.wait()
+	}
+}
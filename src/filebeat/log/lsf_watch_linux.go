@@ -0,0 +1,49 @@
+package log
+
+import (
+	"fmt"
+	"os"
+	"syscall"
+)
+
+// fileWatch tells when a file is written to, moved or removed, through
+// inotify. The watch is on the open file, through its /proc/self/fd link,
+// so it follows the file when LSF renames it on rotation.
+type fileWatch struct {
+	inotify *os.File
+	C       chan struct{}
+}
+
+func newFileWatch(f *os.File) (*fileWatch, error) {
+	fd, err := syscall.InotifyInit1(syscall.IN_NONBLOCK | syscall.IN_CLOEXEC)
+	if err != nil {
+		return nil, err
+	}
+	mask := uint32(syscall.IN_MODIFY | syscall.IN_ATTRIB | syscall.IN_MOVE_SELF | syscall.IN_DELETE_SELF)
+	if _, err := syscall.InotifyAddWatch(fd, fmt.Sprintf("/proc/self/fd/%d", f.Fd()), mask); err != nil {
+		syscall.Close(fd)
+		return nil, err
+	}
+	// non-blocking, so reads wait in the runtime poller and end on Close
+	w := &fileWatch{inotify: os.NewFile(uintptr(fd), "inotify"), C: make(chan struct{}, 1)}
+	go w.run()
+	return w, nil
+}
+
+// run turns the events into wakeups of C, coalescing those not yet taken
+func (w *fileWatch) run() {
+	buf := make([]byte, 64*(syscall.SizeofInotifyEvent+syscall.NAME_MAX+1))
+	for {
+		if _, err := w.inotify.Read(buf); err != nil {
+			return
+		}
+		select {
+		case w.C <- struct{}{}:
+		default:
+		}
+	}
+}
+
+func (w *fileWatch) Close() {
+	w.inotify.Close()
+}
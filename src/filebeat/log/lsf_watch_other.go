@@ -0,0 +1,20 @@
+//go:build !linux
+// +build !linux
+
+package log
+
+import (
+	"errors"
+	"os"
+)
+
+// fileWatch needs inotify, LSF files are polled with backoff elsewhere
+type fileWatch struct {
+	C chan struct{}
+}
+
+func newFileWatch(f *os.File) (*fileWatch, error) {
+	return nil, errors.New("lsf_inotify is only supported on linux")
+}
+
+func (w *fileWatch) Close() {}
@@ -0,0 +1,274 @@
+package parselsb
+
+import (
+	"bufio"
+	"container/heap"
+	"io"
+	"os"
+	"runtime"
+	"sort"
+	"sync/atomic"
+
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// Rotated LSF files (lsb.acct.N ... lsb.acct.1) are backfilled in
+// parallel. Every file is cut into line aligned chunks, which a pool of
+// workers parses with one parser context each, and a k-way merge by event
+// time, then file order, feeds the records to the parser goroutine for
+// their topic messages. Chunks are parsed in the order the merge needs
+// them, by the time of their first record, and only a few ahead of it, so
+// memory stays bounded however long the history is.
+const (
+	// records handed to the parser goroutine at once
+	backfillBatch = 256
+	// bytes of a chunk, some 10 times that once parsed
+	backfillChunkSize = 4 << 20
+)
+
+// parsedRec is a record parsed ahead of its topic messages
+type parsedRec struct {
+	offset int64
+	time   int64
+	ev     jobEvent
+	event  map[string]interface{}
+}
+
+// BackfillFunc receives the messages of a backfilled record at offset of
+// file. It returns false to stop the backfill.
+type BackfillFunc func(file string, offset int64, msgs []MessageWithTopic) bool
+
+type backfillChunk struct {
+	rebuildChunk
+	seq int
+	// event time of its first record, not before that of the chunk
+	// before it in the file
+	time int64
+	// set once a worker or the merge took the chunk
+	claimed int32
+	recs    chan []*parsedRec
+}
+
+// backfillFile is a file in the merge: the records of its loaded chunk,
+// or none if its next chunk is still to be loaded
+type backfillFile struct {
+	name   string
+	chunks []*backfillChunk
+	recs   []*parsedRec
+}
+
+func (f *backfillFile) key() (int64, int) {
+	if len(f.recs) > 0 {
+		return f.recs[0].time, f.chunks[0].seq
+	}
+	return f.chunks[0].time, f.chunks[0].seq
+}
+
+type backfillHeap []*backfillFile
+
+func (h backfillHeap) Len() int { return len(h) }
+func (h backfillHeap) Less(i, j int) bool {
+	ti, si := h[i].key()
+	tj, sj := h[j].key()
+	if ti != tj {
+		return ti < tj
+	}
+	return si < sj
+}
+func (h backfillHeap) Swap(i, j int)       { h[i], h[j] = h[j], h[i] }
+func (h *backfillHeap) Push(x interface{}) { *h = append(*h, x.(*backfillFile)) }
+func (h *backfillHeap) Pop() interface{} {
+	old := *h
+	f := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return f
+}
+
+// Backfill publishes the messages of files of a file type, oldest file
+// first, for topics. Records of the same time keep the order of the
+// files. Records keep returns false for, if not nil, are skipped; it is
+// called from several goroutines. It returns once all records were
+// published, or publish returned false.
+func (p *parser) Backfill(files []string, fileType int, topics []Topic, keep func(rec []byte) bool, publish BackfillFunc) {
+	workers := runtime.NumCPU()
+	var merge backfillHeap
+	var all []*backfillChunk
+	for seq, name := range files {
+		f := &backfillFile{name: name}
+		info, err := os.Stat(name)
+		var chunks []rebuildChunk
+		if err == nil {
+			chunks, err = planChunks(name, fileType, 0, int(info.Size()/backfillChunkSize)+1)
+		}
+		if err == nil {
+			f.chunks, err = timeChunks(chunks, seq)
+		}
+		if err != nil {
+			logp.Err("Fail reading backfill file %s: %s", name, err.Error())
+			continue
+		}
+		if len(f.chunks) > 0 {
+			merge = append(merge, f)
+			all = append(all, f.chunks...)
+		}
+	}
+	heap.Init(&merge)
+	sort.SliceStable(all, func(i, j int) bool {
+		if all[i].time != all[j].time {
+			return all[i].time < all[j].time
+		}
+		return all[i].seq < all[j].seq
+	})
+
+	// up to two chunks per worker are parsed ahead of the merge; a slot is
+	// given back when the merge loads the chunk
+	slots := make(chan struct{}, 2*workers)
+	jobs := make(chan *backfillChunk)
+	done := make(chan struct{})
+	defer close(done)
+	go func() {
+		defer close(jobs)
+		for _, c := range all {
+			select {
+			case slots <- struct{}{}:
+			case <-done:
+				return
+			}
+			if !atomic.CompareAndSwapInt32(&c.claimed, 0, 1) {
+				<-slots
+				continue
+			}
+			select {
+			case jobs <- c:
+			case <-done:
+				return
+			}
+		}
+	}()
+	// lsb.acct and lsb.events records go through an LSF call the C parser
+	// serializes, the workers still convert them to JSON in parallel
+	for w := 0; w < workers; w++ {
+		go func() {
+			rp := new(recordParser)
+			for c := range jobs {
+				c.recs <- parseChunk(rp, c, keep)
+			}
+		}()
+	}
+
+	rp := new(recordParser)
+	retChan := make(chan [][]MessageWithTopic)
+	batch := make([]*parsedRec, 0, backfillBatch)
+	from := make([]string, 0, backfillBatch)
+	flush := func() bool {
+		if len(batch) == 0 {
+			return true
+		}
+		p.post(lsfBatch{parsed: batch, topics: topics, retChan: retChan})
+		res := <-retChan
+		for i, msgs := range res {
+			if !publish(from[i], batch[i].offset, msgs) {
+				return false
+			}
+		}
+		batch, from = batch[:0], from[:0]
+		return true
+	}
+
+	for merge.Len() > 0 {
+		f := merge[0]
+		if len(f.recs) == 0 {
+			// load the next chunk, parsing it here if no worker took it
+			// yet, as chunks of a file out of time order could otherwise
+			// wait behind the chunks parsed ahead
+			c := f.chunks[0]
+			if atomic.CompareAndSwapInt32(&c.claimed, 0, 1) {
+				f.recs = parseChunk(rp, c, keep)
+			} else {
+				f.recs = <-c.recs
+				<-slots
+			}
+		} else {
+			batch = append(batch, f.recs[0])
+			from = append(from, f.name)
+			f.recs = f.recs[1:]
+			if len(batch) == cap(batch) && !flush() {
+				return
+			}
+		}
+		if len(f.recs) == 0 {
+			if f.chunks = f.chunks[1:]; len(f.chunks) == 0 {
+				heap.Pop(&merge)
+				continue
+			}
+		}
+		heap.Fix(&merge, 0)
+	}
+	flush()
+}
+
+// timeChunks returns the chunks of a file with the event times of their
+// first records
+func timeChunks(chunks []rebuildChunk, seq int) ([]*backfillChunk, error) {
+	if len(chunks) == 0 {
+		return nil, nil
+	}
+	f, err := os.Open(chunks[0].file)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	var res []*backfillChunk
+	var last int64
+	for _, c := range chunks {
+		r := bufio.NewReader(io.NewSectionReader(f, c.from, c.to-c.from))
+		for {
+			line, err := r.ReadSlice('\n')
+			if t, ok := eventTime(line); ok {
+				if t > last {
+					last = t
+				}
+				break
+			}
+			if err != nil && err != bufio.ErrBufferFull {
+				break
+			}
+		}
+		res = append(res, &backfillChunk{rebuildChunk: c, seq: seq, time: last, recs: make(chan []*parsedRec, 1)})
+	}
+	return res, nil
+}
+
+// parseChunk parses the records of a chunk keep returns true for. Records
+// without an event time take that of the record before them, to keep their
+// place in the merge.
+func parseChunk(rp *recordParser, c *backfillChunk, keep func([]byte) bool) []*parsedRec {
+	var recs []*parsedRec
+	f, err := os.Open(c.file)
+	if err != nil {
+		logp.Err("Fail reading backfill file %s: %s", c.file, err.Error())
+		return recs
+	}
+	defer f.Close()
+
+	rr := NewRecordReader(bufio.NewReaderSize(io.NewSectionReader(f, c.from, c.to-c.from), 64<<10), maxRebuildLine)
+	offset := c.from
+	last := c.time
+	for {
+		line, n, err := rr.Next()
+		if len(line) > 0 && (keep == nil || keep(line)) {
+			rec := &parsedRec{offset: offset, time: last}
+			if t, ok := eventTime(line); ok {
+				rec.time, last = t, t
+			}
+			res, ev := rp.parse(c.fileType, line)
+			rec.ev, rec.event = ev, stringToJson(&res)
+			recs = append(recs, rec)
+		}
+		offset += int64(n)
+		if err != nil {
+			return recs
+		}
+	}
+}
@@ -0,0 +1,62 @@
+package parselsb
+
+import (
+	"io/ioutil"
+	"os"
+	"testing"
+)
+
+// Records of overlapping files come out by event time, then in file
+// order, the records of each file in the order of the file
+func TestBackfillMergeOrder(t *testing.T) {
+	dir, err := ioutil.TempDir("", "backfill")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	os.Setenv("LSF_BAK_PATH", dir)
+	defer os.Unsetenv("LSF_BAK_PATH")
+
+	tm := int64(1500000000)
+	older := writeHistory(t, dir, "lsb.stream.2", []string{
+		streamStatus(tm, 1, jobStatRun),
+		streamStatus(tm+2, 2, jobStatRun),
+		streamStatus(tm+4, 3, jobStatRun),
+		streamStatus(tm+4, 4, jobStatRun),
+	})
+	newer := writeHistory(t, dir, "lsb.stream.1", []string{
+		streamStatus(tm+1, 5, jobStatRun),
+		streamStatus(tm+2, 6, jobStatRun),
+		streamStatus(tm+3, 7, jobStatRun),
+		streamStatus(tm+5, 8, jobStatRun),
+	})
+	rec := int64(len(streamStatus(tm, 1, jobStatRun)))
+	type published struct {
+		file   string
+		offset int64
+	}
+	want := []published{
+		{older, 0}, {newer, 0}, {older, rec}, {newer, rec},
+		{newer, 2 * rec}, {older, 2 * rec}, {older, 3 * rec}, {newer, 3 * rec},
+	}
+
+	var got []published
+	parsed := 0
+	topics := []Topic{{TopicName: "raw", Type: "job.raw", IncludeFields: []string{"job_id"}}}
+	NewLsbParser().Backfill([]string{older, newer}, StreamFile, topics, nil, func(file string, offset int64, msgs []MessageWithTopic) bool {
+		got = append(got, published{file, offset})
+		parsed += len(msgs)
+		return true
+	})
+	if parsed == 0 {
+		t.Skip("no LSF stream library, set LSF_STREAM_LIBRARY")
+	}
+	if len(got) != len(want) {
+		t.Fatalf("%d records published, want %d", len(got), len(want))
+	}
+	for i := range want {
+		if got[i] != want[i] {
+			t.Fatalf("record %d is %+v, want %+v", i, got[i], want[i])
+		}
+	}
+}
@@ -0,0 +1,369 @@
+package parselsb
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"sort"
+	"strconv"
+	"strings"
+	"unicode/utf8"
+
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// Job status messages are encoded straight into a reusable buffer by a
+// statusEncoder planned once per topic: the fields a message can carry
+// are known from the topic, so their order and quoted names are worked
+// out up front. The output is the same as json.Marshal of the former
+// message map, keys sorted and HTML characters escaped.
+
+// fields of the state message itself
+const (
+	fixedNone = iota
+	fixedCluster
+	fixedJobId
+	fixedJobIdx
+	fixedLastStatus
+	fixedCurStatus
+	fixedReason
+)
+
+var fixedFields = map[string]int{
+	ClusterKey:    fixedCluster,
+	JobIdKey:      fixedJobId,
+	JobIdxKey:     fixedJobIdx,
+	LastStatusKey: fixedLastStatus,
+	CurStatusKey:  fixedCurStatus,
+	ChangeReason:  fixedReason,
+}
+
+// statusField is a field of the message, taken from the event if it is
+// an included field and else from the state message
+type statusField struct {
+	name string
+	// quoted name and colon
+	key     []byte
+	fixed   int
+	include bool
+	// index in extraFields, -1 if not a job property
+	extra int
+}
+
+type statusEncoder struct {
+	// fields of the message text, sorted by name
+	fields []statusField
+	// fields of the routing keys, in order
+	routes  []statusField
+	include []string
+	buf     []byte
+}
+
+func newStatusEncoder(topic *Topic) *statusEncoder {
+	e := &statusEncoder{include: topic.IncludeFields}
+	byName := make(map[string]int)
+	add := func(name string, fixed int, include bool) {
+		if i, ok := byName[name]; ok {
+			e.fields[i].include = e.fields[i].include || include
+			return
+		}
+		byName[name] = len(e.fields)
+		e.fields = append(e.fields, statusField{name: name, fixed: fixed, include: include, extra: -1})
+	}
+	for name, fixed := range fixedFields {
+		add(name, fixed, false)
+	}
+	for _, name := range topic.IncludeFields {
+		add(name, fixedFields[name], true)
+	}
+	sort.Slice(e.fields, func(i, j int) bool { return e.fields[i].name < e.fields[j].name })
+	for i := range e.fields {
+		f := &e.fields[i]
+		f.key = append(appendJSONString(nil, f.name), ':')
+		byName[f.name] = i
+	}
+
+	for _, name := range topic.RoutingKeys {
+		f := statusField{name: name, extra: -1}
+		if i, ok := byName[name]; ok {
+			f = e.fields[i]
+		}
+		for i, efld := range extraFields {
+			if efld == name {
+				f.extra = i
+			}
+		}
+		e.routes = append(e.routes, f)
+	}
+	return e
+}
+
+// plannedFor reports whether e was planned for the fields of topic
+func (e *statusEncoder) plannedFor(topic *Topic) bool {
+	if len(e.include) != len(topic.IncludeFields) || len(e.routes) != len(topic.RoutingKeys) {
+		return false
+	}
+	for i, name := range topic.IncludeFields {
+		if e.include[i] != name {
+			return false
+		}
+	}
+	for i, name := range topic.RoutingKeys {
+		if e.routes[i].name != name {
+			return false
+		}
+	}
+	return true
+}
+
+// included returns the value of an included field: the event field, or
+// else the add_fields value
+func included(event map[string]interface{}, topic *Topic, name string) (interface{}, bool) {
+	if v, ok := event[name]; ok {
+		return v, true
+	}
+	if topic.AddFields != nil {
+		v, ok := topic.AddFields[name]
+		return v, ok
+	}
+	return nil, false
+}
+
+// encode returns the message text of sm. The text is empty if a value
+// cannot be encoded, as it was with json.Marshal.
+func (e *statusEncoder) encode(sm *stateMessage, event map[string]interface{}, topic *Topic) string {
+	b := append(e.buf[:0], '{')
+	for i := range e.fields {
+		f := &e.fields[i]
+		mark := len(b)
+		if len(b) > 1 {
+			b = append(b, ',')
+		}
+		b = append(b, f.key...)
+
+		ok := false
+		if f.include {
+			var v interface{}
+			if v, ok = included(event, topic, f.name); ok {
+				var err error
+				if b, err = appendJSONValue(b, v); err != nil {
+					e.buf = b
+					return ""
+				}
+			}
+		}
+		if !ok && f.fixed != fixedNone {
+			b, ok = appendFixed(b, f.fixed, sm, true)
+		}
+		if !ok {
+			b = b[:mark]
+		}
+	}
+	b = append(b, '}')
+	e.buf = b
+	return string(b)
+}
+
+// route returns the routing key and properties of sm. The property values
+// are cut from the routing key, so only the key and the map allocate.
+func (e *statusEncoder) route(sm *stateMessage, event map[string]interface{}, topic *Topic,
+	prop []uint32, jobs *jobtable.Table) (string, map[string]string) {
+	var key strings.Builder
+	key.Grow(64)
+	var ends [16]int
+	spans := ends[:0]
+	for i := range e.routes {
+		if i > 0 {
+			key.WriteByte('.')
+		}
+		b, ok := e.appendRoute(e.buf[:0], &e.routes[i], sm, event, topic, prop, jobs)
+		e.buf = b
+		key.Write(b)
+		if !ok {
+			spans = append(spans, -1, -1)
+			continue
+		}
+		spans = append(spans, key.Len()-len(b), key.Len())
+	}
+
+	routingKey := key.String()
+	props := make(map[string]string, len(e.routes))
+	for i := range e.routes {
+		if spans[2*i] >= 0 {
+			props[e.routes[i].name] = routingKey[spans[2*i]:spans[2*i+1]]
+		}
+	}
+	return checkRoutingKey(routingKey), props
+}
+
+// appendRoute appends the text of routing key field r, job properties
+// first. Returns false if the message has no such field.
+func (e *statusEncoder) appendRoute(b []byte, r *statusField, sm *stateMessage, event map[string]interface{},
+	topic *Topic, prop []uint32, jobs *jobtable.Table) ([]byte, bool) {
+	if r.extra >= 0 && prop != nil {
+		return append(b, jobs.Symbol(prop[r.extra])...), true
+	}
+	if r.include {
+		if v, ok := included(event, topic, r.name); ok {
+			return appendText(b, v), true
+		}
+	}
+	if r.fixed != fixedNone {
+		return appendFixed(b, r.fixed, sm, false)
+	}
+	return b, false
+}
+
+// checkRoutingKey drops a routing key longer than the 255 bytes AMQP
+// allows
+func checkRoutingKey(routingKey string) string {
+	if len(routingKey) > 255 {
+		logp.Warn("lsf", "routingKey [%v] is too long [%v]", routingKey, len(routingKey))
+		return ""
+	}
+	return routingKey
+}
+
+// appendFixed appends a field of the state message, as JSON or as text
+func appendFixed(b []byte, fixed int, sm *stateMessage, quote bool) ([]byte, bool) {
+	var s string
+	switch fixed {
+	case fixedJobId:
+		return strconv.AppendInt(b, int64(sm.jobId), 10), true
+	case fixedJobIdx:
+		return strconv.AppendInt(b, int64(sm.jobIdx), 10), true
+	case fixedCluster:
+		s = sm.cluster
+	case fixedLastStatus:
+		if sm.lastState <= 0 {
+			return b, false
+		}
+		s = getStateName(sm.lastState)
+	case fixedCurStatus:
+		s = getStateName(sm.currentState)
+	case fixedReason:
+		s = sm.reason
+	}
+	if quote {
+		return appendJSONString(b, s), true
+	}
+	return append(b, s...), true
+}
+
+// appendText appends v formatted as fmt's %v would
+func appendText(b []byte, v interface{}) []byte {
+	switch x := v.(type) {
+	case string:
+		return append(b, x...)
+	case float64:
+		if math.IsInf(x, 0) || math.IsNaN(x) {
+			break
+		}
+		return strconv.AppendFloat(b, x, 'g', -1, 64)
+	case int:
+		return strconv.AppendInt(b, int64(x), 10)
+	case int64:
+		return strconv.AppendInt(b, x, 10)
+	case uint64:
+		return strconv.AppendUint(b, x, 10)
+	case bool:
+		return strconv.AppendBool(b, x)
+	}
+	return append(b, fmt.Sprintf("%v", v)...)
+}
+
+// appendJSONValue appends v encoded as json.Marshal would
+func appendJSONValue(b []byte, v interface{}) ([]byte, error) {
+	switch x := v.(type) {
+	case string:
+		return appendJSONString(b, x), nil
+	case float64:
+		if math.IsInf(x, 0) || math.IsNaN(x) {
+			break
+		}
+		return appendJSONFloat(b, x), nil
+	case int:
+		return strconv.AppendInt(b, int64(x), 10), nil
+	case int64:
+		return strconv.AppendInt(b, x, 10), nil
+	case uint64:
+		return strconv.AppendUint(b, x, 10), nil
+	case bool:
+		return strconv.AppendBool(b, x), nil
+	case nil:
+		return append(b, "null"...), nil
+	}
+	val, err := json.Marshal(v)
+	return append(b, val...), err
+}
+
+// appendJSONFloat formats f like encoding/json: the shortest
+// representation, in exponent form only for very small or large values
+func appendJSONFloat(b []byte, f float64) []byte {
+	format := byte('f')
+	if abs := math.Abs(f); abs != 0 && (abs < 1e-6 || abs >= 1e21) {
+		format = 'e'
+	}
+	b = strconv.AppendFloat(b, f, format, -1, 64)
+	if format == 'e' {
+		// clean up e-09 to e-9
+		if n := len(b); n >= 4 && b[n-4] == 'e' && b[n-3] == '-' && b[n-2] == '0' {
+			b[n-2] = b[n-1]
+			b = b[:n-1]
+		}
+	}
+	return b
+}
+
+const hexDigits = "0123456789abcdef"
+
+// appendJSONString appends s quoted like encoding/json, which escapes
+// <, > and & as well as control characters, U+2028 and U+2029, and
+// replaces invalid UTF-8 with U+FFFD
+func appendJSONString(b []byte, s string) []byte {
+	b = append(b, '"')
+	start := 0
+	for i := 0; i < len(s); {
+		if c := s[i]; c < utf8.RuneSelf {
+			if c >= 0x20 && c != '"' && c != '\\' && c != '<' && c != '>' && c != '&' {
+				i++
+				continue
+			}
+			b = append(b, s[start:i]...)
+			switch c {
+			case '"', '\\':
+				b = append(b, '\\', c)
+			case '\n':
+				b = append(b, '\\', 'n')
+			case '\r':
+				b = append(b, '\\', 'r')
+			case '\t':
+				b = append(b, '\\', 't')
+			default:
+				b = append(b, '\\', 'u', '0', '0', hexDigits[c>>4], hexDigits[c&0xF])
+			}
+			i++
+			start = i
+			continue
+		}
+		r, size := utf8.DecodeRuneInString(s[i:])
+		if r == utf8.RuneError && size == 1 {
+			b = append(b, s[start:i]...)
+			b = append(b, `\ufffd`...)
+			i += size
+			start = i
+			continue
+		}
+		if r == '\u2028' || r == '\u2029' {
+			b = append(b, s[start:i]...)
+			b = append(b, '\\', 'u', '2', '0', '2', hexDigits[r&0xF])
+			i += size
+			start = i
+			continue
+		}
+		i += size
+	}
+	b = append(b, s[start:]...)
+	return append(b, '"')
+}
@@ -0,0 +1,150 @@
+package parselsb
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"math/rand"
+	"testing"
+
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
+)
+
+func TestAppendJSONString(t *testing.T) {
+	for _, s := range []string{
+		"",
+		"plain",
+		"a<b>c&d",
+		"</script>",
+		"quote\" back\\slash",
+		"tab\tnl\nret\r",
+		"ctl\x00\x01\x1f\x7f",
+		"bs\bff\f",
+		"line\u2028para\u2029",
+		"ünïcødé 日本 😀",
+		"bad\xff\xfeutf",
+		"cut \xe6\x97",
+		"surrogate \xed\xa0\x80",
+		"\xff",
+	} {
+		want, err := json.Marshal(s)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if got := appendJSONString(nil, s); string(got) != string(want) {
+			t.Fatalf("%q: got %s, want %s", s, got, want)
+		}
+	}
+}
+
+func TestAppendJSONFloat(t *testing.T) {
+	for _, f := range []float64{
+		0, 1, -1.5, 0.1, 1.7e9, 123456789012,
+		1e-6, -1e-6, 9.999999e-7, 1.0000001e-6, 1e-7, 3e-5, 1.5e-10,
+		1e20, 9.99999999e20, 1e21, -1e21, 1.5e21, 1e100,
+		math.MaxFloat64, math.SmallestNonzeroFloat64, math.Copysign(0, -1),
+	} {
+		want, err := json.Marshal(f)
+		if err != nil {
+			t.Fatal(err)
+		}
+		if got := appendJSONFloat(nil, f); string(got) != string(want) {
+			t.Fatalf("%v: got %s, want %s", f, got, want)
+		}
+	}
+}
+
+// marshalStatus is the status message as built before the encoder: the
+// message map marshaled, routed on the map with the job properties added
+func marshalStatus(sm *stateMessage, event map[string]interface{}, topic *Topic, props []string) *MessageWithTopic {
+	m := map[string]interface{}{
+		ClusterKey:   sm.cluster,
+		JobIdKey:     sm.jobId,
+		JobIdxKey:    sm.jobIdx,
+		CurStatusKey: getStateName(sm.currentState),
+		ChangeReason: sm.reason,
+	}
+	if sm.lastState > 0 {
+		m[LastStatusKey] = getStateName(sm.lastState)
+	}
+	for _, fld := range topic.IncludeFields {
+		if v, ok := event[fld]; ok {
+			m[fld] = v
+		} else if v, ok := topic.AddFields[fld]; ok {
+			m[fld] = v
+		}
+	}
+	text, _ := json.Marshal(m)
+	if props != nil {
+		for i, fld := range extraFields {
+			m[fld] = props[i]
+		}
+	}
+	return &MessageWithTopic{Text: string(text), Topic: topic.TopicName,
+		RoutingKey: getRoutingKey(m, topic), Props: getProperties(m, topic)}
+}
+
+var encodeStrings = []string{"", "plain", "a<b>&c", "quote\"back\\slash", "tab\tnl\nret\r",
+	"ctl\x01\x1f\x7f", "line\u2028", "ünïcødé 日本", "bad\xff\xfeutf", "/path/to/x"}
+
+var encodeNames = []string{"event_type", "version", "job_id", "cluster_name", "user_name",
+	"queue_name", "job_name", "current_status", "host", "a<b", "ünï", "zz"}
+
+func encodeValue(r *rand.Rand) interface{} {
+	switch r.Intn(8) {
+	case 0, 1, 2:
+		return encodeStrings[r.Intn(len(encodeStrings))]
+	case 3:
+		return []float64{0, 1.5, -2.25, 1e-7, 1e21, 1e20, 3e-5, 1.7e9}[r.Intn(8)]
+	case 4:
+		return r.Intn(2) == 0
+	case 5:
+		return nil
+	case 6:
+		return map[string]interface{}{"x": encodeStrings[r.Intn(len(encodeStrings))]}
+	}
+	return int64(r.Intn(1000))
+}
+
+// The encoded text, routing key and properties of status messages are
+// those of the marshaled message map
+func TestStatusEncoderMatchesMarshal(t *testing.T) {
+	r := rand.New(rand.NewSource(1))
+	mt := &mapTransfer{jobs: jobtable.New(0, len(extraFields)), encoders: make(map[string]*statusEncoder)}
+	for i := 0; i < 5000; i++ {
+		topic := &Topic{TopicName: fmt.Sprint("topic", r.Intn(4))}
+		for n := r.Intn(5); n > 0; n-- {
+			topic.IncludeFields = append(topic.IncludeFields, encodeNames[r.Intn(len(encodeNames))])
+		}
+		if r.Intn(2) == 0 {
+			topic.AddFields = map[string]interface{}{encodeNames[r.Intn(len(encodeNames))]: encodeValue(r)}
+		}
+		for n := r.Intn(4); n > 0; n-- {
+			topic.RoutingKeys = append(topic.RoutingKeys, encodeNames[r.Intn(len(encodeNames))])
+		}
+		event := map[string]interface{}{}
+		for n := r.Intn(8); n > 0; n-- {
+			event[encodeNames[r.Intn(len(encodeNames))]] = encodeValue(r)
+		}
+		sm := &stateMessage{cluster: encodeStrings[r.Intn(len(encodeStrings))], jobId: r.Intn(1 << 30),
+			jobIdx: r.Intn(3), lastState: r.Intn(16) - 1, currentState: r.Intn(15),
+			reason: encodeStrings[r.Intn(len(encodeStrings))]}
+		var props []string
+		var ids []uint32
+		if r.Intn(2) == 0 {
+			for range extraFields {
+				props = append(props, encodeStrings[r.Intn(len(encodeStrings))])
+			}
+			k := jobtable.MakeKey(0, i, 0)
+			mt.jobs.SetProps(k, props)
+			_, ids, _ = mt.jobs.Get(k, nil)
+		}
+		want := marshalStatus(sm, event, topic, props)
+		got := mt.stateToMessageWithTopic(sm, event, topic, ids)
+		if got.Text != want.Text || got.RoutingKey != want.RoutingKey || got.Topic != want.Topic ||
+			fmt.Sprint(got.Props) != fmt.Sprint(want.Props) {
+			t.Fatalf("message %d of topic %+v, event %v:\ngot  %q %q %v\nwant %q %q %v", i, topic, event,
+				got.Text, got.RoutingKey, got.Props, want.Text, want.RoutingKey, want.Props)
+		}
+	}
+}
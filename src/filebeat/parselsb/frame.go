@@ -0,0 +1,88 @@
+package parselsb
+
+import (
+	"bufio"
+	"bytes"
+)
+
+// An LSF record is one line, unless a quoted field such as a job command
+// holds line breaks; the record then goes on until the quote is closed.
+// Quotes within a quoted field are doubled, so the number of quotes of a
+// record is even, and an odd count tells that a line is not the end of one.
+
+var quote = []byte{'"'}
+
+// QuoteOpen tells if a quoted field is open after line, given if one was
+// open before it
+func QuoteOpen(line []byte, open bool) bool {
+	return open != (bytes.Count(line, quote)&1 == 1)
+}
+
+// RecordHead tells if line looks like the start of a record: the quoted
+// event type and version, and the event time. A line following an
+// unclosed quote which looks like one starts a new record, so a broken
+// record does not swallow those after it.
+func RecordHead(line []byte) bool {
+	_, ok := eventTime(line)
+	return ok
+}
+
+// RecordReader reads the records of a file from the start of a record
+type RecordReader struct {
+	r   *bufio.Reader
+	max int
+	buf []byte
+	// a line read past the end of a broken record, and its error
+	next    []byte
+	nextErr error
+}
+
+func NewRecordReader(r *bufio.Reader, max int) *RecordReader {
+	return &RecordReader{r: r, max: max}
+}
+
+// Next returns the next record without its line ending, only valid until
+// the next call, and the bytes it takes in the file. The error ending
+// reading comes with the last record, if any.
+func (rr *RecordReader) Next() ([]byte, int, error) {
+	line, err := rr.line()
+	n := len(line)
+	if err != nil || !QuoteOpen(line, false) {
+		return bytes.TrimRight(line, "\r\n"), n, err
+	}
+
+	// a quoted field goes on in the next lines
+	rr.buf = append(rr.buf[:0], line...)
+	for err == nil && len(rr.buf) < rr.max {
+		if line, err = rr.line(); len(line) > 0 && RecordHead(line) {
+			rr.next, rr.nextErr = append([]byte(nil), line...), err
+			err = nil
+			break
+		}
+		rr.buf = append(rr.buf, line...)
+		n += len(line)
+		if !QuoteOpen(line, true) {
+			break
+		}
+	}
+	return bytes.TrimRight(rr.buf, "\r\n"), n, err
+}
+
+// line returns the next line with its line ending, however long it is
+func (rr *RecordReader) line() ([]byte, error) {
+	if rr.next != nil {
+		line, err := rr.next, rr.nextErr
+		rr.next, rr.nextErr = nil, nil
+		return line, err
+	}
+	line, err := rr.r.ReadSlice('\n')
+	if err != bufio.ErrBufferFull {
+		return line, err
+	}
+	long := append([]byte(nil), line...)
+	for err == bufio.ErrBufferFull {
+		line, err = rr.r.ReadSlice('\n')
+		long = append(long, line...)
+	}
+	return long, err
+}
@@ -0,0 +1,187 @@
+package jobtable
+
+import (
+	"encoding/binary"
+)
+
+// Jobs of a mapped checkpoint are served straight from the mapping until
+// they are written. Each shard owns the section of the checkpoint holding
+// its jobs as fixed size records sorted by (cluster, job):
+//
+// job u64 | cluster u32 | state u8 | hour last written u24 | numProps
+// property symbol ids u32
+//
+// The hour counts from the Unix epoch and feeds the expiry of jobs loaded
+// from a checkpoint, see evict.go. All ids 0 means no properties.
+const (
+	recHeaderLen  = 16
+	recClusterOff = 8
+	recStateOff   = 12
+	recHourOff    = 13
+)
+
+// recLen returns the record length for numProps properties
+func recLen(numProps int) int {
+	return recHeaderLen + 4*numProps
+}
+
+func recKey(rec []byte) Key {
+	return Key{
+		Job:     binary.LittleEndian.Uint64(rec),
+		Cluster: binary.LittleEndian.Uint32(rec[recClusterOff:]),
+	}
+}
+
+// recTouched returns the time a record was last written, in Unix seconds
+func recTouched(rec []byte) uint32 {
+	return readHour(rec[recHourOff:])
+}
+
+func putRecTouched(rec []byte, touched uint32) {
+	h := touched / 3600
+	rec[recHourOff], rec[recHourOff+1], rec[recHourOff+2] = byte(h), byte(h>>8), byte(h>>16)
+}
+
+// recProp returns property id i of a record
+func recProp(rec []byte, i int) uint32 {
+	return binary.LittleEndian.Uint32(rec[recHeaderLen+4*i:])
+}
+
+// appendRecProps appends the property ids of a record to props, nothing
+// if it has none
+func appendRecProps(props []uint32, rec []byte, numProps int) []uint32 {
+	for i := 0; i < numProps; i++ {
+		if recProp(rec, i) != 0 {
+			for i = 0; i < numProps; i++ {
+				props = append(props, recProp(rec, i))
+			}
+			break
+		}
+	}
+	return props
+}
+
+func keyLess(a, b Key) bool {
+	if a.Cluster != b.Cluster {
+		return a.Cluster < b.Cluster
+	}
+	return a.Job < b.Job
+}
+
+// rec returns base record i
+func (s *shard) rec(i int) []byte {
+	n := recLen(s.numProps)
+	return s.base[i*n : (i+1)*n]
+}
+
+// findBase returns the index of the base record of k, -1 if there is
+// none or it was promoted. Called with the shard lock held.
+func (s *shard) findBase(k Key) int {
+	lo, hi := 0, s.baseN
+	for lo < hi {
+		mid := int(uint(lo+hi) >> 1)
+		if keyLess(recKey(s.rec(mid)), k) {
+			lo = mid + 1
+		} else {
+			hi = mid
+		}
+	}
+	if lo == s.baseN || recKey(s.rec(lo)) != k {
+		return -1
+	}
+	if s.gone[lo>>6]&(1<<uint(lo&63)) != 0 {
+		return -1
+	}
+	return lo
+}
+
+// promote retires the base record of k, if any, before k is written to
+// the live map. Returns the record as an entry, its properties copied to
+// a slot of the shard; an empty entry if there is no record. Called with
+// the shard write lock held.
+func (s *shard) promote(k Key) (entry, bool) {
+	if s.baseN == s.nGone {
+		return entry{state: NoState}, false
+	}
+	i := s.findBase(k)
+	if i < 0 {
+		return entry{state: NoState}, false
+	}
+	s.retire(i)
+	return s.recEntry(s.rec(i)), true
+}
+
+// recEntry turns a base record into an entry of the live map. Called with
+// the shard write lock held.
+func (s *shard) recEntry(rec []byte) entry {
+	e := entry{state: rec[recStateOff], touched: recTouched(rec)}
+	for i := 0; i < s.numProps; i++ {
+		if recProp(rec, i) != 0 {
+			// the checkpoint references count for the promoted job
+			e.props = s.allocProps()
+			ids := s.propsOf(e)
+			for i := range ids {
+				ids[i] = recProp(rec, i)
+			}
+			break
+		}
+	}
+	return e
+}
+
+// eachBase calls fn for every base record not promoted yet. Called with
+// the shard lock held.
+func (s *shard) eachBase(fn func(rec []byte)) {
+	for i := 0; i < s.baseN; i++ {
+		if s.gone[i>>6]&(1<<uint(i&63)) == 0 {
+			fn(s.rec(i))
+		}
+	}
+}
+
+// retire marks base record i promoted or deleted. Called with the shard
+// write lock held.
+func (s *shard) retire(i int) {
+	s.gone[i>>6] |= 1 << uint(i&63)
+	s.nGone++
+}
+
+// attachBase hands a checkpoint section of num records to the shard
+func (s *shard) attachBase(section []byte, num int) {
+	s.Lock()
+	s.base = section
+	s.baseN = num
+	s.gone = make([]uint64, (num+63)/64)
+	s.nGone = 0
+	s.Unlock()
+}
+
+// releaseBase unmaps the checkpoint once no shard needs it any more, or
+// unconditionally if force is set, after moving the remaining records
+// into the live maps
+func (t *Table) releaseBase(force bool) {
+	if t.mapping == nil {
+		return
+	}
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.RLock()
+		live := s.baseN - s.nGone
+		s.RUnlock()
+		if live > 0 && !force {
+			return
+		}
+	}
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.Lock()
+		s.eachBase(func(rec []byte) {
+			s.jobs[recKey(rec)] = s.recEntry(rec)
+		})
+		s.base, s.gone = nil, nil
+		s.baseN, s.nGone = 0, 0
+		s.Unlock()
+	}
+	t.mapping.release()
+	t.mapping = nil
+}
@@ -0,0 +1,411 @@
+package jobtable
+
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash"
+	"hash/crc32"
+	"io"
+	"os"
+	"path/filepath"
+	"sort"
+
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// Checkpoint layout, little endian:
+//
+// magic "LSFJSCKP" | version u32 | shard count u32 | log generation u64
+// | property count u32 | cluster count u32 | cluster names (length u16 +
+// bytes) | zero padding to a multiple of 16 | the jobs of each shard in
+// turn, as fixed size records sorted by key (see base.go) | symbol count
+// u32 | symbols (id u32, reference count u32, length u16 + bytes) | job
+// count of each shard u64 | crc32 u32 of everything before it
+//
+// The symbols are the property strings the records refer to by id, with
+// the number of records referring to each.
+//
+// The record sections are used in place from a read-only mapping, so a
+// restart only reads the file once to check it. Jobs are promoted into
+// the live table as they change.
+//
+// A checkpoint is written to <name>.tmp, synced, and renamed over the
+// current one, which is kept as <name>.prev. A checkpoint that fails its
+// checksum is never loaded; the previous one is used instead, together
+// with the log segments kept since its generation.
+const (
+	ckptMagic   = "LSFJSCKP"
+	ckptVersion = 4
+
+	ckptFixedLen = len(ckptMagic) + 24
+)
+
+// ckptWriter tracks the checksum and size of everything written
+type ckptWriter struct {
+	w    *bufio.Writer
+	crc  hash.Hash32
+	size int64
+}
+
+func (cw *ckptWriter) Write(b []byte) (int, error) {
+	cw.crc.Write(b)
+	cw.size += int64(len(b))
+	return cw.w.Write(b)
+}
+
+// writeCheckpoint writes every job with a state to f.tmp, then moves the
+// current checkpoint to f.prev and renames f.tmp to f. Returns the
+// checkpoint size.
+func (t *Table) writeCheckpoint(f string, gen uint64) (int64, error) {
+	tmp := f + ".tmp"
+	file, err := os.OpenFile(tmp, os.O_WRONLY|os.O_CREATE|os.O_TRUNC, 0644)
+	if err != nil {
+		return 0, err
+	}
+	size, err := t.writeCheckpointTo(file, gen)
+	if err == nil {
+		err = file.Sync()
+	}
+	if cerr := file.Close(); err == nil {
+		err = cerr
+	}
+	if err != nil {
+		os.Remove(tmp)
+		return 0, err
+	}
+
+	if _, err := os.Stat(f); err == nil {
+		if err := os.Rename(f, f+".prev"); err != nil {
+			os.Remove(tmp)
+			return 0, err
+		}
+	}
+	if err := os.Rename(tmp, f); err != nil {
+		return 0, err
+	}
+	syncDir(filepath.Dir(f))
+	return size, nil
+}
+
+type ckptRec struct {
+	k       Key
+	state   uint8
+	touched uint32
+	// offset of the property ids in the shard id buffer, -1 if none
+	props int
+}
+
+// ckptSymbol is a symbol referenced by the jobs of a checkpoint
+type ckptSymbol struct {
+	id   uint32
+	refs uint32
+	name string
+}
+
+func (t *Table) writeCheckpointTo(file io.Writer, gen uint64) (int64, error) {
+	w := &ckptWriter{w: bufio.NewWriterSize(file, 1<<16), crc: crc32.NewIEEE()}
+
+	t.clusterLock.RLock()
+	clusters := t.clusters
+	t.clusterLock.RUnlock()
+
+	buf := []byte(ckptMagic)
+	buf = appendUint32(buf, ckptVersion)
+	buf = appendUint32(buf, numShards)
+	buf = appendUint64(buf, gen)
+	buf = appendUint32(buf, uint32(t.numProps))
+	buf = appendUint32(buf, uint32(len(clusters)))
+	for _, name := range clusters {
+		buf = appendString(buf, name)
+	}
+	for len(buf)%recHeaderLen != 0 {
+		buf = append(buf, 0)
+	}
+	w.Write(buf)
+
+	var counts [numShards]uint64
+	var recs []ckptRec
+	var ids []uint32
+	syms := make(map[uint32]*ckptSymbol)
+	// keep the ids of a record, resolving new ones while the shard lock
+	// keeps them referenced
+	addProps := func(r *ckptRec, props func(i int) uint32) {
+		r.props = len(ids)
+		for i := 0; i < t.numProps; i++ {
+			id := props(i)
+			ids = append(ids, id)
+			if id == 0 {
+				continue
+			}
+			sym := syms[id]
+			if sym == nil {
+				sym = &ckptSymbol{id: id, name: t.syms.name(id)}
+				syms[id] = sym
+			}
+			sym.refs++
+		}
+	}
+	rec := make([]byte, recLen(t.numProps))
+	for i := range t.shards {
+		s := &t.shards[i]
+		recs, ids = recs[:0], ids[:0]
+		s.RLock()
+		for k, e := range s.jobs {
+			// a cluster added since the names were written only has
+			// jobs changed after the segment switch, they are in the log
+			if (e.state == NoState && e.props == noProps) || int(k.Cluster) >= len(clusters) {
+				continue
+			}
+			r := ckptRec{k, e.state, e.touched, -1}
+			if e.props != noProps {
+				slot := s.propsOf(e)
+				addProps(&r, func(i int) uint32 { return slot[i] })
+			}
+			recs = append(recs, r)
+		}
+		s.eachBase(func(b []byte) {
+			r := ckptRec{recKey(b), b[recStateOff], recTouched(b), -1}
+			addProps(&r, func(i int) uint32 { return recProp(b, i) })
+			recs = append(recs, r)
+		})
+		s.RUnlock()
+
+		sort.Slice(recs, func(a, b int) bool { return keyLess(recs[a].k, recs[b].k) })
+		for _, r := range recs {
+			binary.LittleEndian.PutUint64(rec, r.k.Job)
+			binary.LittleEndian.PutUint32(rec[recClusterOff:], r.k.Cluster)
+			rec[recStateOff] = r.state
+			putRecTouched(rec, r.touched)
+			for p := 0; p < t.numProps; p++ {
+				var id uint32
+				if r.props >= 0 {
+					id = ids[r.props+p]
+				}
+				binary.LittleEndian.PutUint32(rec[recHeaderLen+4*p:], id)
+			}
+			w.Write(rec)
+		}
+		counts[i] = uint64(len(recs))
+	}
+
+	buf = appendUint32(buf[:0], uint32(len(syms)))
+	for _, sym := range syms {
+		buf = appendUint32(buf, sym.id)
+		buf = appendUint32(buf, sym.refs)
+		buf = appendString(buf, sym.name)
+		if len(buf) >= 1<<16 {
+			w.Write(buf)
+			buf = buf[:0]
+		}
+	}
+	w.Write(buf)
+
+	buf = buf[:0]
+	for _, n := range counts {
+		buf = appendUint64(buf, n)
+	}
+	w.Write(buf)
+	if _, err := w.w.Write(appendUint32(buf[:0], w.crc.Sum32())); err != nil {
+		return 0, err
+	}
+	return w.size + 4, w.w.Flush()
+}
+
+// checkpointFile is a mapped and verified checkpoint
+type checkpointFile struct {
+	*mappedFile
+	gen      uint64
+	numProps int
+	clusters []string
+	syms     []ckptSymbol
+	// offset of the first job record
+	recOff int
+	counts [numShards]int
+}
+
+// openCheckpoint maps checkpoint f and checks its header and checksum
+func openCheckpoint(f string) (*checkpointFile, error) {
+	m, err := mapFile(f)
+	if err != nil {
+		return nil, err
+	}
+	c, err := parseCheckpoint(m.data)
+	if err != nil {
+		m.release()
+		return nil, fmt.Errorf("%s: %s", f, err.Error())
+	}
+	c.mappedFile = m
+	return c, nil
+}
+
+func parseCheckpoint(d []byte) (*checkpointFile, error) {
+	trailerLen := numShards*8 + 4
+	if len(d) < ckptFixedLen+trailerLen {
+		return nil, errors.New("truncated checkpoint")
+	}
+	if string(d[:len(ckptMagic)]) != ckptMagic {
+		return nil, errors.New("not a job state checkpoint")
+	}
+	le := binary.LittleEndian
+	p := len(ckptMagic)
+	if v := le.Uint32(d[p:]); v != ckptVersion {
+		return nil, fmt.Errorf("unsupported checkpoint version %d", v)
+	}
+	if n := le.Uint32(d[p+4:]); n != numShards {
+		return nil, fmt.Errorf("checkpoint of %d shards, expect %d", n, numShards)
+	}
+	if le.Uint32(d[len(d)-4:]) != crc32.ChecksumIEEE(d[:len(d)-4]) {
+		return nil, errors.New("checksum mismatch")
+	}
+
+	c := &checkpointFile{gen: le.Uint64(d[p+8:])}
+	c.numProps = int(le.Uint32(d[p+16:]))
+	numClusters := int(le.Uint32(d[p+20:]))
+	p = ckptFixedLen
+	for i := 0; i < numClusters; i++ {
+		if p+2 > len(d) {
+			return nil, errCorrupt
+		}
+		l := int(le.Uint16(d[p:]))
+		if p+2+l > len(d) {
+			return nil, errCorrupt
+		}
+		c.clusters = append(c.clusters, string(d[p+2:p+2+l]))
+		p += 2 + l
+	}
+	c.recOff = (p + recHeaderLen - 1) / recHeaderLen * recHeaderLen
+
+	total := 0
+	trailer := d[len(d)-trailerLen:]
+	for i := range c.counts {
+		c.counts[i] = int(le.Uint64(trailer[i*8:]))
+		total += c.counts[i]
+	}
+	p = c.recOff + total*recLen(c.numProps)
+	end := len(d) - trailerLen
+	if total < 0 || p+4 > end {
+		return nil, errors.New("job count mismatch")
+	}
+
+	numSyms := int(le.Uint32(d[p:]))
+	p += 4
+	for i := 0; i < numSyms; i++ {
+		if p+10 > end {
+			return nil, errCorrupt
+		}
+		l := int(le.Uint16(d[p+8:]))
+		if p+10+l > end {
+			return nil, errCorrupt
+		}
+		c.syms = append(c.syms, ckptSymbol{
+			id:   le.Uint32(d[p:]),
+			refs: le.Uint32(d[p+4:]),
+			name: string(d[p+10 : p+10+l]),
+		})
+		p += 10 + l
+	}
+	if p != end {
+		return nil, errors.New("symbol table mismatch")
+	}
+	return c, nil
+}
+
+// openBestCheckpoint opens f, or f.prev if f is missing or damaged. A
+// damaged f is moved aside to f.bad so the next checkpoint keeps f.prev.
+func openBestCheckpoint(f string) (*checkpointFile, error) {
+	c, err := openCheckpoint(f)
+	if err == nil {
+		return c, nil
+	}
+	if !os.IsNotExist(err) {
+		logp.Err("Skip job state checkpoint: %s", err.Error())
+	}
+
+	prev := f + ".prev"
+	c, perr := openCheckpoint(prev)
+	if perr != nil {
+		if os.IsNotExist(perr) {
+			// no usable checkpoint at all, report why f failed
+			return nil, err
+		}
+		logp.Err("Skip job state checkpoint: %s", perr.Error())
+		return nil, perr
+	}
+	if !os.IsNotExist(err) {
+		os.Rename(f, f+".bad")
+	}
+	logp.Info("Fall back to job state checkpoint %s", prev)
+	return c, nil
+}
+
+// loadCheckpoint makes the jobs of checkpoint c the base of the empty
+// table. If the cluster ids of c cannot be kept the jobs are copied into
+// the table instead. Returns the first log generation to replay.
+func (t *Table) loadCheckpoint(c *checkpointFile) uint64 {
+	identity := c.numProps == t.numProps
+	for i, name := range c.clusters {
+		if t.ClusterID(name) != uint32(i) {
+			identity = false
+		}
+	}
+	if identity {
+		t.syms.restore(c.syms)
+	}
+
+	names := make(map[uint32]string, len(c.syms))
+	for _, sym := range c.syms {
+		names[sym.id] = sym.name
+	}
+	n := recLen(c.numProps)
+	props := make([]string, t.numProps)
+	off := c.recOff
+	num := 0
+	for i := range t.shards {
+		section := c.data[off : off+c.counts[i]*n]
+		off += len(section)
+		num += c.counts[i]
+		if identity {
+			t.shards[i].attachBase(section, c.counts[i])
+			continue
+		}
+		for r := 0; r < len(section); r += n {
+			rec := section[r : r+n]
+			k := recKey(rec)
+			if int(k.Cluster) >= len(c.clusters) {
+				continue
+			}
+			k.Cluster = t.ClusterID(c.clusters[k.Cluster])
+			t.set(k, rec[recStateOff], recTouched(rec))
+			if ids := appendRecProps(nil, rec, c.numProps); len(ids) > 0 {
+				// properties added or dropped since stay empty
+				for p := range props {
+					props[p] = ""
+					if p < len(ids) {
+						props[p] = names[ids[p]]
+					}
+				}
+				s := t.shardOf(k)
+				s.Lock()
+				t.setProps(s, k, props, recTouched(rec))
+				s.Unlock()
+			}
+		}
+	}
+	if identity {
+		t.mapping = c.mappedFile
+	} else {
+		c.release()
+	}
+	logp.Info("Loaded %d job states, generation %d", num, c.gen)
+	return c.gen
+}
+
+// syncDir makes renames in dir durable, where the platform allows it
+func syncDir(dir string) {
+	if d, err := os.Open(dir); err == nil {
+		d.Sync()
+		d.Close()
+	}
+}
@@ -0,0 +1,146 @@
+package jobtable
+
+import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+const faultJobs = 2000
+
+// writeRounds sets every job to the number of the round, syncing the log
+// after each round and writing a checkpoint after the rounds in ckpt. The
+// table is left open, as by a crash; before is called ahead of each
+// checkpoint and after behind it.
+func writeRounds(t *testing.T, base string, rounds int, ckpt map[int]bool, before, after func(round int)) {
+	tb := New(faultJobs, 7)
+	if err := tb.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	c := tb.ClusterID("cl")
+	for round := 1; round <= rounds; round++ {
+		for i := 0; i < faultJobs; i++ {
+			tb.Set(MakeKey(c, i, 0), uint8(round))
+		}
+		if err := tb.Sync(); err != nil {
+			t.Fatal(err)
+		}
+		if ckpt[round] {
+			if before != nil {
+				before(round)
+			}
+			if err := tb.checkpoint(); err != nil {
+				t.Fatal(err)
+			}
+			if after != nil {
+				after(round)
+			}
+		}
+	}
+}
+
+// checkRound restores the table under base and checks every job is in
+// the state of round
+func checkRound(t *testing.T, base string, round int) {
+	tb := New(faultJobs, 7)
+	if err := tb.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	defer tb.Close()
+	if tb.Len() != faultJobs {
+		t.Fatalf("%d jobs restored, want %d", tb.Len(), faultJobs)
+	}
+	c := tb.ClusterID("cl")
+	for i := 0; i < faultJobs; i++ {
+		if st, _, _ := tb.Get(MakeKey(c, i, 0), nil); int(st) != round {
+			t.Fatalf("job %d in state %d, want %d", i, st, round)
+		}
+	}
+}
+
+// A checkpoint torn while written to .tmp is ignored
+func TestCheckpointTornTmp(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	writeRounds(t, base, 4, map[int]bool{2: true}, nil, nil)
+	b, err := ioutil.ReadFile(base + ".ckpt")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := ioutil.WriteFile(base+".ckpt.tmp", b[:len(b)/2], 0644); err != nil {
+		t.Fatal(err)
+	}
+	checkRound(t, base, 4)
+	// and overwritten by the next checkpoint
+	checkRound(t, base, 4)
+}
+
+// A checkpoint failing its checksum falls back to the previous one and
+// the log kept since
+func TestCheckpointBadCRC(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	writeRounds(t, base, 5, map[int]bool{2: true, 4: true}, nil, nil)
+	b, err := ioutil.ReadFile(base + ".ckpt")
+	if err != nil {
+		t.Fatal(err)
+	}
+	b[len(b)/2] ^= 0xFF
+	if err := ioutil.WriteFile(base+".ckpt", b, 0644); err != nil {
+		t.Fatal(err)
+	}
+	checkRound(t, base, 5)
+	if _, err := os.Stat(base + ".ckpt.bad"); err != nil {
+		t.Fatal("damaged checkpoint not moved aside:", err)
+	}
+}
+
+// A crash after the current checkpoint became .prev but before the new
+// one was renamed in place restores from .prev
+func TestCheckpointCrashBetweenRenames(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	writeRounds(t, base, 5, map[int]bool{2: true, 4: true}, nil, nil)
+	b, err := ioutil.ReadFile(base + ".ckpt")
+	if err != nil {
+		t.Fatal(err)
+	}
+	if err := os.Rename(base+".ckpt", base+".ckpt.prev"); err != nil {
+		t.Fatal(err)
+	}
+	if err := ioutil.WriteFile(base+".ckpt.tmp", b, 0644); err != nil {
+		t.Fatal(err)
+	}
+	checkRound(t, base, 5)
+}
+
+// A crash after a checkpoint was renamed in place but before the
+// segments it covers were dropped does not replay them over it
+func TestCheckpointCrashBeforeCleanup(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	segs := make(map[string][]byte)
+	before := func(round int) {
+		names, _ := filepath.Glob(base + ".wal.*")
+		for _, name := range names {
+			if b, err := ioutil.ReadFile(name); err == nil {
+				segs[name] = b
+			}
+		}
+	}
+	restored := 0
+	after := func(round int) {
+		for name, b := range segs {
+			if _, err := os.Stat(name); os.IsNotExist(err) {
+				ioutil.WriteFile(name, b, 0644)
+				restored++
+			}
+		}
+	}
+	writeRounds(t, base, 7, map[int]bool{2: true, 4: true, 6: true}, before, after)
+	if restored == 0 {
+		t.Fatal("no segment was dropped")
+	}
+	checkRound(t, base, 7)
+}
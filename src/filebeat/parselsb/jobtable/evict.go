@@ -0,0 +1,172 @@
+package jobtable
+
+import (
+	"math"
+	"sort"
+	"sync/atomic"
+	"time"
+
+	"github.com/elastic/beats/libbeat/logp"
+	"github.com/elastic/beats/libbeat/monitoring"
+)
+
+// A job whose finish event is never seen would stay in the table for
+// good. Expire bounds the table two ways: jobs not written within the TTL
+// are dropped, and while the estimated heap use is over the budget the
+// least recently written jobs are evicted, picked by sampling the touch
+// times of each shard. Dropped jobs are logged as deletes so they do not
+// come back on restart.
+const (
+	// estimated heap bytes of a map entry and of a property id
+	entryCost = 48
+	propCost  = 4
+	// shards swept for expired jobs per call of Expire
+	sweepShards = 1
+	// touch times sampled per shard to find the eviction cutoff
+	evictSamples = 64
+	// eviction goes down to this share of the budget, so that it does not
+	// run again on the next call
+	lowWater = 0.9
+)
+
+var (
+	tableMetrics = monitoring.Default.NewRegistry("parselsb.job_states")
+
+	metricJobs    = monitoring.NewInt(tableMetrics, "jobs")
+	metricMemory  = monitoring.NewInt(tableMetrics, "memory_bytes")
+	metricSymbols = monitoring.NewInt(tableMetrics, "symbols")
+	metricExpired = monitoring.NewInt(tableMetrics, "expired")
+	metricEvicted = monitoring.NewInt(tableMetrics, "evicted")
+)
+
+type limits struct {
+	// seconds, 0 if jobs never expire
+	ttl uint32
+	// heap budget in bytes, 0 if unlimited
+	maxBytes int64
+	// next shard to sweep for expired jobs
+	sweep int
+}
+
+// SetLimits sets how long a job is kept without being written and the
+// heap budget of the table. 0 disables either.
+func (t *Table) SetLimits(ttl time.Duration, maxBytes int64) {
+	t.ttl = uint32(ttl / time.Second)
+	t.maxBytes = maxBytes
+}
+
+// Expire advances the table clock to now, drops the expired jobs of the
+// next shard in turn and evicts jobs while the table is over budget.
+// Returns the number of jobs expired and evicted. Meant to be called
+// periodically, from one goroutine.
+func (t *Table) Expire(now time.Time) (expired int, evicted int) {
+	sec := uint32(now.Unix())
+	atomic.StoreUint32(&t.now, sec)
+
+	if t.ttl > 0 && sec > t.ttl {
+		for i := 0; i < sweepShards; i++ {
+			expired += t.expireShard(&t.shards[t.sweep], sec-t.ttl)
+			t.sweep = (t.sweep + 1) % numShards
+		}
+	}
+	mem := t.MemoryBytes()
+	if t.maxBytes > 0 && mem > t.maxBytes {
+		evicted = t.evict(mem)
+		mem = t.MemoryBytes()
+		logp.Info("Evicted %d job states over the memory budget of %d bytes", evicted, t.maxBytes)
+	}
+	if expired > 0 {
+		logp.Info("Expired %d job states not changed since %v", expired,
+			time.Unix(int64(sec-t.ttl), 0))
+	}
+
+	metricExpired.Add(int64(expired))
+	metricEvicted.Add(int64(evicted))
+	metricJobs.Set(int64(t.Len()))
+	metricMemory.Set(mem)
+	syms, _ := t.syms.stats()
+	metricSymbols.Set(int64(syms))
+	return expired, evicted
+}
+
+// MemoryBytes estimates the heap held by the live jobs, their properties
+// and the property symbols. Jobs still served from the mapped checkpoint
+// are not counted, the page cache holds them.
+func (t *Table) MemoryBytes() int64 {
+	var n int64
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.RLock()
+		n += int64(len(s.jobs)) * entryCost
+		if t.numProps > 0 {
+			slots := len(s.slab)/t.numProps - 1 - len(s.free)
+			n += int64(slots*t.numProps) * propCost
+		}
+		s.RUnlock()
+	}
+	_, symBytes := t.syms.stats()
+	return n + symBytes
+}
+
+// expireShard drops the jobs of s last written before cutoff
+func (t *Table) expireShard(s *shard, cutoff uint32) int {
+	n := 0
+	s.Lock()
+	for k, e := range s.jobs {
+		if e.touched < cutoff {
+			t.drop(s, k)
+			n++
+		}
+	}
+	for i := 0; i < s.baseN; i++ {
+		rec := s.rec(i)
+		if s.gone[i>>6]&(1<<uint(i&63)) == 0 && recTouched(rec) < cutoff {
+			t.drop(s, recKey(rec))
+			n++
+		}
+	}
+	s.Unlock()
+	return n
+}
+
+// evict drops the least recently written jobs until the estimate is back
+// under the low water mark. Every shard gives up the same share of its
+// live jobs, those touched at or before the matching quantile of a sample
+// of its touch times.
+func (t *Table) evict(mem int64) int {
+	share := 1 - float64(t.maxBytes)*lowWater/float64(mem)
+	samples := make([]uint32, 0, evictSamples)
+	n := 0
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.Lock()
+		quota := int(math.Ceil(share * float64(len(s.jobs))))
+		if quota > 0 {
+			// map iteration starts at a random place, good enough a sample
+			samples = samples[:0]
+			for _, e := range s.jobs {
+				if samples = append(samples, e.touched); len(samples) == evictSamples {
+					break
+				}
+			}
+			sort.Slice(samples, func(a, b int) bool { return samples[a] < samples[b] })
+			q := int(share * float64(len(samples)))
+			if q >= len(samples) {
+				q = len(samples) - 1
+			}
+			cutoff := samples[q]
+			for k, e := range s.jobs {
+				if quota == 0 {
+					break
+				}
+				if e.touched <= cutoff {
+					t.drop(s, k)
+					quota--
+					n++
+				}
+			}
+		}
+		s.Unlock()
+	}
+	return n
+}
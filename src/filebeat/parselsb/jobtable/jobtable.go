@@ -0,0 +1,394 @@
+package jobtable
+
+import (
+	"bufio"
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+	"strconv"
+	"strings"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+const (
+	shardBits = 6
+	numShards = 1 << shardBits
+
+	// NoState marks an entry which only holds job properties so far
+	NoState uint8 = 0xFF
+
+	noProps uint32 = 0
+)
+
+// Key identifies a job array element: Cluster is an id returned by
+// Table.ClusterID, Job packs the job id (high 32 bits) and the array
+// index (low 32 bits).
+type Key struct {
+	Job     uint64
+	Cluster uint32
+}
+
+// MakeKey packs a cluster id, job id and array index into a Key
+func MakeKey(cluster uint32, jobId, jobIdx int) Key {
+	return Key{Job: uint64(uint32(jobId))<<32 | uint64(uint32(jobIdx)), Cluster: cluster}
+}
+
+// JobId returns the job id packed in the key
+func (k Key) JobId() int {
+	return int(int32(k.Job >> 32))
+}
+
+// JobIdx returns the array index packed in the key
+func (k Key) JobIdx() int {
+	return int(int32(k.Job))
+}
+
+type entry struct {
+	state uint8
+	// 1-based slot in the shard property slab, noProps if none
+	props uint32
+	// Unix seconds of the last write, drives expiry and eviction
+	touched uint32
+}
+
+type shard struct {
+	sync.RWMutex
+	jobs map[Key]entry
+	// symbol ids of the job properties, numProps per slot, slot 0 unused
+	slab     []uint32
+	free     []uint32
+	numProps int
+
+	// read-only jobs of the mapped checkpoint, sorted by key. A job is
+	// promoted into jobs when it is first written; gone marks promoted
+	// or deleted records.
+	base  []byte
+	gone  []uint64
+	baseN int
+	nGone int
+}
+
+// Table keeps the state and properties of every live job. It is split
+// into shards by key so that readers and writers of different jobs do
+// not contend on one lock.
+type Table struct {
+	shards   [numShards]shard
+	numProps int
+	modified int32
+	// write-ahead log of state changes, nil until Open
+	log *stateLog
+	// Open found saved job states
+	restored bool
+	// mapped checkpoint backing the shard base records
+	mapping *mappedFile
+	// property strings by id
+	syms symbols
+	// Unix seconds stamped on writes, advanced by Expire
+	now uint32
+	// expiry settings and progress, see evict.go
+	limits
+
+	clusterLock sync.RWMutex
+	clusterIds  map[string]uint32
+	clusters    []string
+}
+
+// New creates a table sized for about size jobs, each carrying numProps
+// property strings
+func New(size int, numProps int) *Table {
+	t := new(Table)
+	t.numProps = numProps
+	t.now = uint32(time.Now().Unix())
+	t.syms.init()
+	t.clusterIds = make(map[string]uint32)
+	for i := range t.shards {
+		t.shards[i].jobs = make(map[Key]entry, size/numShards)
+		t.shards[i].slab = make([]uint32, numProps)
+		t.shards[i].numProps = numProps
+	}
+	return t
+}
+
+// ClusterID returns the id of a cluster name, assigning one on first use
+func (t *Table) ClusterID(name string) uint32 {
+	t.clusterLock.RLock()
+	id, ok := t.clusterIds[name]
+	t.clusterLock.RUnlock()
+	if ok {
+		return id
+	}
+
+	t.clusterLock.Lock()
+	defer t.clusterLock.Unlock()
+	if id, ok = t.clusterIds[name]; !ok {
+		id = uint32(len(t.clusters))
+		t.clusters = append(t.clusters, name)
+		t.clusterIds[name] = id
+	}
+	return id
+}
+
+// ClusterName returns the cluster name of an id from ClusterID
+func (t *Table) ClusterName(id uint32) string {
+	t.clusterLock.RLock()
+	defer t.clusterLock.RUnlock()
+	if int(id) < len(t.clusters) {
+		return t.clusters[id]
+	}
+	return ""
+}
+
+func (t *Table) shardOf(k Key) *shard {
+	h := (k.Job ^ uint64(k.Cluster)<<48) * 0x9E3779B97F4A7C15
+	return &t.shards[h>>(64-shardBits)]
+}
+
+// Get returns the state of a job and appends the symbol ids of its
+// properties to props, see Symbol. ok is false if the job has no state
+// recorded.
+func (t *Table) Get(k Key, props []uint32) (state uint8, outProps []uint32, ok bool) {
+	s := t.shardOf(k)
+	s.RLock()
+	e, found := s.jobs[k]
+	if found && e.props != noProps {
+		props = append(props, s.propsOf(e)...)
+	} else if !found {
+		if i := s.findBase(k); i >= 0 {
+			rec := s.rec(i)
+			e, found = entry{state: rec[recStateOff]}, true
+			props = appendRecProps(props, rec, s.numProps)
+		}
+	}
+	s.RUnlock()
+	if !found || e.state == NoState {
+		return NoState, props, false
+	}
+	return e.state, props, true
+}
+
+// Set records the state of a job
+func (t *Table) Set(k Key, state uint8) {
+	s := t.shardOf(k)
+	s.Lock()
+	now := t.clock()
+	s.set(k, state, now)
+	if t.log != nil {
+		t.logSet(k, state, now)
+	}
+	s.Unlock()
+	atomic.StoreInt32(&t.modified, 1)
+}
+
+// set records a state without logging it, used while replaying
+func (t *Table) set(k Key, state uint8, touched uint32) {
+	s := t.shardOf(k)
+	s.Lock()
+	s.set(k, state, touched)
+	s.Unlock()
+}
+
+func (s *shard) set(k Key, state uint8, touched uint32) {
+	e, found := s.jobs[k]
+	if !found {
+		e, _ = s.promote(k)
+	}
+	e.state = state
+	e.touched = touched
+	s.jobs[k] = e
+}
+
+// clock returns the time stamped on writes
+func (t *Table) clock() uint32 {
+	return atomic.LoadUint32(&t.now)
+}
+
+// SetProps records the properties of a job, keeping its state. props
+// must hold the numProps strings given to New; they are stored as symbol
+// ids.
+func (t *Table) SetProps(k Key, props []string) {
+	s := t.shardOf(k)
+	s.Lock()
+	now := t.clock()
+	ids := t.setProps(s, k, props, now)
+	if t.log != nil {
+		t.logProps(k, ids, now)
+	}
+	s.Unlock()
+	atomic.StoreInt32(&t.modified, 1)
+}
+
+// setProps records properties with the write lock of s held, returns the
+// ids stored
+func (t *Table) setProps(s *shard, k Key, props []string, touched uint32) []uint32 {
+	e, found := s.jobs[k]
+	if !found {
+		e, _ = s.promote(k)
+	}
+	if e.props == noProps {
+		e.props = s.allocProps()
+	}
+	ids := s.propsOf(e)
+	t.syms.swap(ids, props)
+	e.touched = touched
+	s.jobs[k] = e
+	return ids
+}
+
+// allocProps returns a free property slot. Called with the write lock
+// held.
+func (s *shard) allocProps() uint32 {
+	if n := len(s.free); n > 0 {
+		slot := s.free[n-1]
+		s.free = s.free[:n-1]
+		return slot
+	}
+	slot := uint32(len(s.slab) / s.numProps)
+	s.slab = append(s.slab, make([]uint32, s.numProps)...)
+	return slot
+}
+
+func (s *shard) propsOf(e entry) []uint32 {
+	off := int(e.props) * s.numProps
+	return s.slab[off : off+s.numProps]
+}
+
+// Delete drops a job and its properties
+func (t *Table) Delete(k Key) {
+	s := t.shardOf(k)
+	s.Lock()
+	t.drop(s, k)
+	s.Unlock()
+}
+
+// delete drops a job without logging it, used while replaying
+func (t *Table) delete(k Key) {
+	s := t.shardOf(k)
+	s.Lock()
+	t.deleteLocked(s, k)
+	s.Unlock()
+}
+
+// drop deletes k from s, whose write lock is held, and logs the delete
+func (t *Table) drop(s *shard, k Key) {
+	if t.deleteLocked(s, k) {
+		if t.log != nil {
+			t.logDelete(k)
+		}
+		atomic.StoreInt32(&t.modified, 1)
+	}
+}
+
+// deleteLocked drops k from shard s, whose write lock is held. Returns
+// whether there was such a job.
+func (t *Table) deleteLocked(s *shard, k Key) bool {
+	e, found := s.jobs[k]
+	if found {
+		delete(s.jobs, k)
+	} else if e, found = s.promote(k); !found {
+		return false
+	}
+	if e.props != noProps {
+		t.syms.swap(s.propsOf(e), nil)
+		s.free = append(s.free, e.props)
+	}
+	return true
+}
+
+// Len returns the number of jobs in the table
+func (t *Table) Len() int {
+	n := 0
+	for i := range t.shards {
+		s := &t.shards[i]
+		s.RLock()
+		n += len(s.jobs) + s.baseN - s.nGone
+		s.RUnlock()
+	}
+	return n
+}
+
+// GetModifiedFlag reports whether any state changed since UnsetModified
+func (t *Table) GetModifiedFlag() bool {
+	return atomic.LoadInt32(&t.modified) != 0
+}
+
+// UnsetModified clears the modified flag
+func (t *Table) UnsetModified() {
+	atomic.StoreInt32(&t.modified, 0)
+}
+
+// LoadFile loads a JSON job state snapshot keyed by "cluster_jobid_idx",
+// the format written by the former SafeMap, merging it into the table
+func (t *Table) LoadFile(f string) {
+	file, err := os.Open(f)
+	if err != nil {
+		logp.Err("Fail loading data from file %s, error is %s", f, err.Error())
+		return
+	}
+	defer file.Close()
+
+	n, err := t.readJSON(bufio.NewReader(file))
+	if err != nil {
+		logp.Err("Invalid job state snapshot %s after %d jobs: %s", f, n, err.Error())
+	}
+	t.UnsetModified()
+}
+
+func (t *Table) readJSON(r io.Reader) (int, error) {
+	dec := json.NewDecoder(r)
+	n := 0
+
+	if tok, err := dec.Token(); err != nil {
+		if err == io.EOF {
+			return 0, nil
+		}
+		return 0, err
+	} else if d, ok := tok.(json.Delim); !ok || d != '{' {
+		return 0, fmt.Errorf("expect an object, got %v", tok)
+	}
+	for dec.More() {
+		tok, err := dec.Token()
+		if err != nil {
+			return n, err
+		}
+		name, _ := tok.(string)
+		var state float64
+		if err := dec.Decode(&state); err != nil {
+			return n, err
+		}
+		k, ok := t.parseName(name)
+		if !ok || state < 0 || state >= float64(NoState) {
+			logp.Err("Skip invalid job state %s: %v", name, state)
+			continue
+		}
+		t.Set(k, uint8(state))
+		n++
+	}
+	return n, nil
+}
+
+// parseName parses a "cluster_jobid_idx" snapshot key, the cluster name
+// may itself contain '_'
+func (t *Table) parseName(name string) (Key, bool) {
+	i := strings.LastIndexByte(name, '_')
+	if i < 0 {
+		return Key{}, false
+	}
+	idx, err := strconv.Atoi(name[i+1:])
+	if err != nil {
+		return Key{}, false
+	}
+	j := strings.LastIndexByte(name[:i], '_')
+	if j < 0 {
+		return Key{}, false
+	}
+	id, err := strconv.Atoi(name[j+1 : i])
+	if err != nil {
+		return Key{}, false
+	}
+	return MakeKey(t.ClusterID(name[:j]), id, idx), true
+}
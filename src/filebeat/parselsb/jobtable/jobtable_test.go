@@ -0,0 +1,137 @@
+package jobtable
+
+import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"sync"
+	"testing"
+)
+
+// lockedMap keeps job states as SafeMap did before the table: one lock
+// over a map keyed by "cluster_jobid_idx"
+type lockedMap struct {
+	sync.RWMutex
+	m map[string]interface{}
+}
+
+func benchKey(n, i int) (int, int) {
+	i %= n
+	return i/1000 + 1, i % 1000
+}
+
+// benchTable does a Get and a Set of a job per op, over n live jobs
+func benchTable(b *testing.B, n int) {
+	t := New(n, 7)
+	c := t.ClusterID("cluster1")
+	for i := 0; i < n; i++ {
+		id, idx := benchKey(n, i)
+		t.Set(MakeKey(c, id, idx), uint8(i%6))
+	}
+	b.ReportAllocs()
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		var props []uint32
+		for i := 0; pb.Next(); i += 7919 {
+			id, idx := benchKey(n, i)
+			k := MakeKey(c, id, idx)
+			st, p, _ := t.Get(k, props[:0])
+			props = p
+			t.Set(k, (st+1)%6)
+		}
+	})
+}
+
+func benchLockedMap(b *testing.B, n int) {
+	m := &lockedMap{m: make(map[string]interface{}, n)}
+	for i := 0; i < n; i++ {
+		id, idx := benchKey(n, i)
+		m.m[fmt.Sprintf("%v_%v_%v", "cluster1", id, idx)] = float64(i % 6)
+	}
+	b.ReportAllocs()
+	b.ResetTimer()
+	b.RunParallel(func(pb *testing.PB) {
+		for i := 0; pb.Next(); i += 7919 {
+			id, idx := benchKey(n, i)
+			uid := fmt.Sprintf("%v_%v_%v", "cluster1", id, idx)
+			m.RLock()
+			st, _ := m.m[uid].(float64)
+			m.RUnlock()
+			m.Lock()
+			m.m[uid] = float64((int(st) + 1) % 6)
+			m.Unlock()
+		}
+	})
+}
+
+func BenchmarkTable1M(b *testing.B)      { benchTable(b, 1000000) }
+func BenchmarkTable10M(b *testing.B)     { benchTable(b, 10000000) }
+func BenchmarkLockedMap1M(b *testing.B)  { benchLockedMap(b, 1000000) }
+func BenchmarkLockedMap10M(b *testing.B) { benchLockedMap(b, 10000000) }
+
+// crash drops a table without the final checkpoint of Close
+func crash(t *Table) {
+	t.log.ioLock.Lock()
+	if t.log.file != nil {
+		t.log.file.Close()
+		t.log.file = nil
+	}
+	t.log.ioLock.Unlock()
+	if t.mapping != nil {
+		t.mapping.release()
+	}
+}
+
+// benchRestart times Open of a checkpoint of n jobs with properties plus
+// a log of changes to a tenth of them made after the checkpoint
+func benchRestart(b *testing.B, n int) {
+	dir, err := ioutil.TempDir("", "jobtable")
+	if err != nil {
+		b.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	base := filepath.Join(dir, "job.states")
+
+	t := New(n, 7)
+	if err := t.Open(base, ""); err != nil {
+		b.Fatal(err)
+	}
+	c := t.ClusterID("cluster1")
+	props := make([]string, 7)
+	for i := 0; i < n; i++ {
+		id, idx := benchKey(n, i)
+		k := MakeKey(c, id, idx)
+		props[0], props[1], props[2] = fmt.Sprint("user", i%1000), fmt.Sprint("queue", i%20), fmt.Sprint("job", i%5000)
+		t.SetProps(k, props)
+		t.Set(k, uint8(i%6))
+	}
+	if err := t.checkpoint(); err != nil {
+		b.Fatal(err)
+	}
+	for i := 0; i < n/10; i++ {
+		id, idx := benchKey(n, i*7919)
+		t.Set(MakeKey(c, id, idx), uint8((i+1)%6))
+	}
+	if err := t.Sync(); err != nil {
+		b.Fatal(err)
+	}
+	crash(t)
+
+	b.ReportAllocs()
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		t := New(n, 7)
+		if err := t.Open(base, ""); err != nil {
+			b.Fatal(err)
+		}
+		b.StopTimer()
+		if t.Len() != n {
+			b.Fatalf("%d jobs restored, want %d", t.Len(), n)
+		}
+		crash(t)
+		b.StartTimer()
+	}
+}
+
+func BenchmarkRestart5M(b *testing.B) { benchRestart(b, 5000000) }
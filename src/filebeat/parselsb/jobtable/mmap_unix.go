@@ -0,0 +1,41 @@
+//go:build !windows
+// +build !windows
+
+package jobtable
+
+import (
+	"os"
+	"syscall"
+)
+
+type mappedFile struct {
+	data []byte
+}
+
+// mapFile maps f read-only
+func mapFile(f string) (*mappedFile, error) {
+	file, err := os.Open(f)
+	if err != nil {
+		return nil, err
+	}
+	defer file.Close()
+	info, err := file.Stat()
+	if err != nil {
+		return nil, err
+	}
+	if info.Size() == 0 {
+		return &mappedFile{}, nil
+	}
+	data, err := syscall.Mmap(int(file.Fd()), 0, int(info.Size()), syscall.PROT_READ, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, err
+	}
+	return &mappedFile{data: data}, nil
+}
+
+func (m *mappedFile) release() {
+	if m.data != nil {
+		syscall.Munmap(m.data)
+		m.data = nil
+	}
+}
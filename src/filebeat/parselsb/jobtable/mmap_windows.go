@@ -0,0 +1,22 @@
+package jobtable
+
+import (
+	"io/ioutil"
+)
+
+type mappedFile struct {
+	data []byte
+}
+
+// mapFile reads f into memory, there is no read-only mapping here
+func mapFile(f string) (*mappedFile, error) {
+	data, err := ioutil.ReadFile(f)
+	if err != nil {
+		return nil, err
+	}
+	return &mappedFile{data: data}, nil
+}
+
+func (m *mappedFile) release() {
+	m.data = nil
+}
@@ -0,0 +1,122 @@
+package jobtable
+
+import (
+	"sync"
+)
+
+// symbols interns job property strings into small integer ids. Property
+// values (users, queues, projects) repeat across almost every job, so
+// jobs, checkpoints and the log hold 4 byte ids, and the strings are only
+// looked up when a message is built. Ids are reference counted and reused
+// once no job refers to them. Id 0 means no properties; the empty string
+// gets an id like any other value.
+type symbols struct {
+	sync.RWMutex
+	ids   map[string]uint32
+	names []string
+	refs  []int32
+	free  []uint32
+	// estimated bytes of the names and the id map
+	bytes int64
+}
+
+// rough cost of a symbol on top of its bytes
+const symbolCost = 64
+
+func (y *symbols) init() {
+	y.ids = make(map[string]uint32)
+	y.names = []string{""}
+	y.refs = []int32{0}
+}
+
+// swap stores the ids of values in slot and releases the ids slot held
+// before. A nil values only releases them.
+func (y *symbols) swap(slot []uint32, values []string) {
+	y.Lock()
+	for i := range slot {
+		var id uint32
+		if values != nil {
+			id = y.acquire(values[i])
+		}
+		y.release(slot[i])
+		slot[i] = id
+	}
+	y.Unlock()
+}
+
+func (y *symbols) acquire(s string) uint32 {
+	id, ok := y.ids[s]
+	if !ok {
+		if n := len(y.free); n > 0 {
+			id = y.free[n-1]
+			y.free = y.free[:n-1]
+		} else {
+			id = uint32(len(y.names))
+			y.names = append(y.names, "")
+			y.refs = append(y.refs, 0)
+		}
+		y.names[id] = s
+		y.ids[s] = id
+		y.bytes += int64(len(s)) + symbolCost
+	}
+	y.refs[id]++
+	return id
+}
+
+func (y *symbols) release(id uint32) {
+	if id == 0 {
+		return
+	}
+	if y.refs[id]--; y.refs[id] > 0 {
+		return
+	}
+	s := y.names[id]
+	delete(y.ids, s)
+	y.names[id] = ""
+	y.free = append(y.free, id)
+	y.bytes -= int64(len(s)) + symbolCost
+}
+
+// name returns the string of id, "" for id 0 or a released id
+func (y *symbols) name(id uint32) string {
+	y.RLock()
+	defer y.RUnlock()
+	if int(id) < len(y.names) {
+		return y.names[id]
+	}
+	return ""
+}
+
+// restore sets up the symbols of a checkpoint with their ids and counts.
+// Only used on an empty table.
+func (y *symbols) restore(syms []ckptSymbol) {
+	y.Lock()
+	defer y.Unlock()
+	for _, sym := range syms {
+		for uint32(len(y.names)) <= sym.id {
+			y.names = append(y.names, "")
+			y.refs = append(y.refs, 0)
+		}
+		y.names[sym.id] = sym.name
+		y.refs[sym.id] = int32(sym.refs)
+		y.ids[sym.name] = sym.id
+		y.bytes += int64(len(sym.name)) + symbolCost
+	}
+	for id := len(y.names) - 1; id > 0; id-- {
+		if y.refs[id] == 0 {
+			y.free = append(y.free, uint32(id))
+		}
+	}
+}
+
+// stats returns the number of symbols in use and their estimated bytes
+func (y *symbols) stats() (int, int64) {
+	y.RLock()
+	defer y.RUnlock()
+	return len(y.ids), y.bytes
+}
+
+// Symbol returns the property string of an id returned by Get
+func (t *Table) Symbol(id uint32) string {
+	return t.syms.name(id)
+}
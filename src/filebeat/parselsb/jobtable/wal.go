@@ -0,0 +1,564 @@
+package jobtable
+
+import (
+	"bufio"
+	"encoding/binary"
+	"errors"
+	"hash/crc32"
+	"io"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// Job states are persisted as a binary checkpoint plus a write-ahead log
+// of the state changes made since. Each sync only appends the changes of
+// the last interval to the log; once the log outgrows the checkpoint the
+// table is compacted into a new checkpoint and the old log is dropped.
+//
+// <base>.ckpt holds the checkpoint and the generation of the first log
+// segment to replay on top of it, see checkpoint.go. <base>.wal.<gen> are
+// the log segments, each a sequence of blocks: magic u32, payload length
+// u32, crc32 u32, then the payload records. Segments are kept back to the
+// generation of the previous checkpoint, so either one can be restored.
+//
+// Log records are absolute (set state, set properties, delete job), so
+// replaying a record already covered by the checkpoint is harmless. Set
+// records carry the hour the job was written, as checkpoint records do,
+// so a restart does not renew the expiry of the jobs it replays. Like
+// cluster names, the property symbols a segment refers to are defined in
+// the segment itself.
+const (
+	walMagic = 0x4C57534A
+
+	opSet     = 1
+	opDelete  = 2
+	opCluster = 3
+	opProps   = 4
+	opSymbol  = 5
+
+	blockHeaderLen = 12
+	// compact once the log reaches the checkpoint size, but not before
+	minCompactBytes = 8 << 20
+)
+
+var errCorrupt = errors.New("corrupt record")
+
+type stateLog struct {
+	sync.Mutex
+	// encoded records not written yet
+	pending []byte
+	// clusters and symbols defined in the current segment
+	defined map[uint32]bool
+	symbols map[uint32]string
+
+	// below only used by the sync goroutine
+	ioLock   sync.Mutex
+	base     string
+	gen      uint64
+	file     *os.File
+	fileSize int64
+	logBytes int64
+	ckptSize int64
+	// log generation of the current and the previous checkpoint
+	ckptGen uint64
+	prevGen uint64
+}
+
+// Open restores the table from the checkpoint and log under base, or
+// from the legacy JSON snapshot if there is no checkpoint yet, then
+// starts logging changes. The table must be empty. The checkpoint is
+// mapped rather than read into the table, see checkpoint.go.
+func (t *Table) Open(base string, legacy string) error {
+	l := &stateLog{base: base}
+	converted := false
+
+	var gen uint64
+	c, err := openBestCheckpoint(base + ".ckpt")
+	if err == nil {
+		gen = t.loadCheckpoint(c)
+		l.ckptSize = int64(len(c.data))
+		t.restored = true
+	} else if os.IsNotExist(err) {
+		if _, serr := os.Stat(legacy); serr == nil {
+			logp.Info("Convert job state snapshot %s", legacy)
+			t.LoadFile(legacy)
+			converted = true
+			t.restored = true
+		}
+	} else if _, perr := os.Stat(base + ".ckpt.prev"); os.IsNotExist(perr) {
+		// the first checkpoint is damaged, but no segment has been
+		// dropped yet, so the whole log can be replayed instead
+		logp.Err("Rebuild job states from the log, checkpoint is damaged: %s", err.Error())
+		os.Rename(base+".ckpt", base+".ckpt.bad")
+	} else {
+		return err
+	}
+
+	segs, err := l.segments()
+	if err != nil {
+		return err
+	}
+	for _, seg := range segs {
+		if seg >= gen {
+			name := l.segmentName(seg)
+			n, err := t.replay(name)
+			logp.Info("Replayed %d job state changes from %s", n, name)
+			t.restored = t.restored || n > 0
+			if err != nil {
+				logp.Err("Stop replaying %s: %s", name, err.Error())
+			}
+			if info, err := os.Stat(name); err == nil {
+				l.logBytes += info.Size()
+			}
+		}
+		if seg >= l.gen {
+			l.gen = seg + 1
+		}
+	}
+	if gen > l.gen {
+		l.gen = gen
+	}
+	l.ckptGen = gen
+
+	t.log = l
+	if converted {
+		// the JSON snapshot is dropped once it is in a checkpoint
+		err = t.checkpoint()
+		if err == nil {
+			os.Remove(legacy)
+		}
+	} else {
+		// keep the checkpoint and replayed segments, log to a new one
+		err = l.startSegment()
+	}
+	if err != nil {
+		t.log = nil
+		return err
+	}
+	t.UnsetModified()
+	return nil
+}
+
+// Restored reports whether Open found job states saved by an earlier run
+func (t *Table) Restored() bool {
+	return t.restored
+}
+
+// Sync writes the changes logged since the last call and compacts the
+// log into a new checkpoint when it has grown past the checkpoint size
+func (t *Table) Sync() error {
+	l := t.log
+	if l == nil {
+		return nil
+	}
+	l.ioLock.Lock()
+	err := l.flush()
+	compact := l.logBytes >= l.ckptSize && l.logBytes >= minCompactBytes
+	l.ioLock.Unlock()
+	if err != nil {
+		return err
+	}
+	if compact {
+		return t.checkpoint()
+	}
+	return nil
+}
+
+// Close writes a final checkpoint and stops logging
+func (t *Table) Close() error {
+	if t.log == nil {
+		return nil
+	}
+	err := t.checkpoint()
+	l := t.log
+	l.ioLock.Lock()
+	if l.file != nil {
+		l.file.Close()
+		l.file = nil
+	}
+	l.ioLock.Unlock()
+	t.releaseBase(true)
+	return err
+}
+
+// logSet, logProps and logDelete are called with the shard lock of k
+// held, so the records of one job reach the log in the order they were
+// applied
+func (t *Table) logSet(k Key, state uint8, touched uint32) {
+	l := t.log
+	l.Lock()
+	t.defineCluster(l, k.Cluster)
+	l.pending = append(l.pending, opSet)
+	l.pending = appendKey(l.pending, k)
+	l.pending = appendHour(l.pending, touched)
+	l.pending = append(l.pending, state)
+	l.Unlock()
+}
+
+func (t *Table) logProps(k Key, ids []uint32, touched uint32) {
+	l := t.log
+	l.Lock()
+	t.defineCluster(l, k.Cluster)
+	for _, id := range ids {
+		t.defineSymbol(l, id)
+	}
+	l.pending = append(l.pending, opProps)
+	l.pending = appendKey(l.pending, k)
+	l.pending = appendHour(l.pending, touched)
+	l.pending = append(l.pending, byte(len(ids)))
+	for _, id := range ids {
+		l.pending = appendUint32(l.pending, id)
+	}
+	l.Unlock()
+}
+
+func (t *Table) logDelete(k Key) {
+	l := t.log
+	l.Lock()
+	t.defineCluster(l, k.Cluster)
+	l.pending = append(l.pending, opDelete)
+	l.pending = appendKey(l.pending, k)
+	l.Unlock()
+}
+
+// defineCluster logs the name of a cluster id the first time a segment
+// refers to it. Called with the log lock held.
+func (t *Table) defineCluster(l *stateLog, id uint32) {
+	if l.defined[id] {
+		return
+	}
+	name := t.ClusterName(id)
+	l.pending = append(l.pending, opCluster)
+	l.pending = appendUint32(l.pending, id)
+	l.pending = appendString(l.pending, name)
+	l.defined[id] = true
+}
+
+// defineSymbol logs the string of a symbol id the first time a segment
+// refers to it, or again if the id was reused for another string. Called
+// with the log lock held.
+func (t *Table) defineSymbol(l *stateLog, id uint32) {
+	if id == 0 {
+		return
+	}
+	name := t.syms.name(id)
+	if def, ok := l.symbols[id]; ok && def == name {
+		return
+	}
+	l.pending = append(l.pending, opSymbol)
+	l.pending = appendUint32(l.pending, id)
+	l.pending = appendString(l.pending, name)
+	l.symbols[id] = name
+}
+
+// flush writes the pending records as one block. Called with ioLock held.
+func (l *stateLog) flush() error {
+	l.Lock()
+	buf := l.pending
+	l.pending = nil
+	l.Unlock()
+	if l.file == nil {
+		return nil
+	}
+	return l.write(l.file, buf)
+}
+
+// write appends buf to file as one block. Called with ioLock held.
+func (l *stateLog) write(file *os.File, buf []byte) error {
+	if len(buf) == 0 {
+		return nil
+	}
+	block := make([]byte, 0, blockHeaderLen+len(buf))
+	block = appendUint32(block, walMagic)
+	block = appendUint32(block, uint32(len(buf)))
+	block = appendUint32(block, crc32.ChecksumIEEE(buf))
+	block = append(block, buf...)
+	if _, err := file.Write(block); err != nil {
+		// cut a partly written block so later blocks stay replayable
+		file.Truncate(l.fileSize)
+		file.Seek(l.fileSize, io.SeekStart)
+		return err
+	}
+	l.fileSize += int64(len(block))
+	l.logBytes += int64(len(block))
+	return file.Sync()
+}
+
+// checkpoint switches to a new log segment, writes the whole table as
+// the checkpoint of that segment and drops the older segments. Changes
+// made while the table is written land in the new segment.
+func (t *Table) checkpoint() error {
+	l := t.log
+	l.ioLock.Lock()
+	defer l.ioLock.Unlock()
+
+	if err := l.startSegment(); err != nil {
+		return err
+	}
+	l.logBytes = 0
+
+	size, err := t.writeCheckpoint(l.base+".ckpt", l.gen)
+	if err != nil {
+		return err
+	}
+	l.ckptSize = size
+	l.prevGen = l.ckptGen
+	l.ckptGen = l.gen
+
+	// the previous checkpoint needs the segments since its generation
+	segs, err := l.segments()
+	if err != nil {
+		return err
+	}
+	for _, seg := range segs {
+		if seg < l.prevGen {
+			os.Remove(l.segmentName(seg))
+		}
+	}
+	// everything of the mapped checkpoint may have been rewritten by now
+	t.releaseBase(false)
+	return nil
+}
+
+// startSegment switches logging to a new segment. The records pending
+// are taken out with the definitions they rely on under the log lock, so
+// a record logged meanwhile lands in the new segment along with its own
+// definitions; the records taken out end the old segment. Called with
+// ioLock held.
+func (l *stateLog) startSegment() error {
+	file, err := os.OpenFile(l.segmentName(l.gen+1), os.O_WRONLY|os.O_CREATE|os.O_TRUNC, 0644)
+	if err != nil {
+		return err
+	}
+	l.Lock()
+	buf := l.pending
+	l.pending = nil
+	old := l.file
+	l.gen++
+	l.file = file
+	l.defined = make(map[uint32]bool)
+	l.symbols = make(map[uint32]string)
+	l.Unlock()
+	if old != nil {
+		if err := l.write(old, buf); err != nil {
+			// the checkpoint written next holds these changes
+			logp.Err("Failed to write job state changes: %s", err.Error())
+		}
+		old.Close()
+	}
+	l.fileSize = 0
+	syncDir(filepath.Dir(l.base))
+	return nil
+}
+
+func (l *stateLog) segmentName(gen uint64) string {
+	return l.base + ".wal." + strconv.FormatUint(gen, 10)
+}
+
+// segments returns the generations of the log segments on disk, oldest
+// first
+func (l *stateLog) segments() ([]uint64, error) {
+	names, err := filepath.Glob(l.base + ".wal.*")
+	if err != nil {
+		return nil, err
+	}
+	var segs []uint64
+	prefix := l.base + ".wal."
+	for _, name := range names {
+		gen, err := strconv.ParseUint(strings.TrimPrefix(name, prefix), 10, 64)
+		if err == nil {
+			segs = append(segs, gen)
+		}
+	}
+	sort.Slice(segs, func(i, j int) bool { return segs[i] < segs[j] })
+	return segs, nil
+}
+
+// replay applies the records of log segment f. A torn or corrupt block
+// ends the replay; the segment is cut back to the last good block.
+func (t *Table) replay(f string) (int, error) {
+	file, err := os.OpenFile(f, os.O_RDWR, 0)
+	if err != nil {
+		return 0, err
+	}
+	defer file.Close()
+	r := bufio.NewReaderSize(file, 1<<16)
+
+	var hdr [blockHeaderLen]byte
+	var good int64
+	n := 0
+	seg := &segmentIds{clusters: make(map[uint32]uint32), symbols: make(map[uint32]string)}
+	for {
+		if _, err = io.ReadFull(r, hdr[:]); err != nil {
+			break
+		}
+		size := binary.LittleEndian.Uint32(hdr[4:])
+		if binary.LittleEndian.Uint32(hdr[0:]) != walMagic {
+			err = errCorrupt
+			break
+		}
+		payload := make([]byte, size)
+		if _, err = io.ReadFull(r, payload); err != nil {
+			break
+		}
+		if crc32.ChecksumIEEE(payload) != binary.LittleEndian.Uint32(hdr[8:]) {
+			err = errCorrupt
+			break
+		}
+		var m int
+		if m, err = t.applyBlock(payload, seg); err != nil {
+			break
+		}
+		n += m
+		good += int64(blockHeaderLen) + int64(size)
+	}
+	if err == io.EOF {
+		return n, nil
+	}
+	file.Truncate(good)
+	if err == io.ErrUnexpectedEOF {
+		err = errors.New("torn block at end of log")
+	}
+	return n, err
+}
+
+// segmentIds maps the cluster ids of a segment to table ids and its
+// symbol ids to their strings
+type segmentIds struct {
+	clusters map[uint32]uint32
+	symbols  map[uint32]string
+	props    []string
+}
+
+func (t *Table) applyBlock(b []byte, seg *segmentIds) (int, error) {
+	n := 0
+	for len(b) > 0 {
+		op := b[0]
+		b = b[1:]
+		switch op {
+		case opCluster, opSymbol:
+			if len(b) < 6 {
+				return n, errCorrupt
+			}
+			id := binary.LittleEndian.Uint32(b)
+			l := int(binary.LittleEndian.Uint16(b[4:]))
+			if len(b) < 6+l {
+				return n, errCorrupt
+			}
+			if op == opCluster {
+				seg.clusters[id] = t.ClusterID(string(b[6 : 6+l]))
+			} else {
+				seg.symbols[id] = string(b[6 : 6+l])
+			}
+			b = b[6+l:]
+		case opSet, opDelete, opProps:
+			need := keyLen
+			if op == opSet {
+				need += hourLen + 1
+			} else if op == opProps {
+				need += hourLen
+				if len(b) > need {
+					need += 1 + 4*int(b[need])
+				}
+			}
+			if len(b) < need {
+				return n, errCorrupt
+			}
+			k := readKey(b)
+			id, ok := seg.clusters[k.Cluster]
+			if !ok {
+				return n, errCorrupt
+			}
+			k.Cluster = id
+			switch op {
+			case opSet:
+				t.set(k, b[keyLen+hourLen], readHour(b[keyLen:]))
+			case opDelete:
+				t.delete(k)
+			case opProps:
+				touched := readHour(b[keyLen:])
+				if err := t.replayProps(k, b[keyLen+hourLen+1:need], touched, seg); err != nil {
+					return n, err
+				}
+			}
+			b = b[need:]
+			n++
+		default:
+			return n, errCorrupt
+		}
+	}
+	return n, nil
+}
+
+// replayProps applies the property ids of a segment, properties added or
+// dropped since stay empty
+func (t *Table) replayProps(k Key, b []byte, touched uint32, seg *segmentIds) error {
+	if seg.props == nil {
+		seg.props = make([]string, t.numProps)
+	}
+	for i := range seg.props {
+		seg.props[i] = ""
+		if 4*i >= len(b) {
+			continue
+		}
+		name, ok := seg.symbols[binary.LittleEndian.Uint32(b[4*i:])]
+		if !ok && binary.LittleEndian.Uint32(b[4*i:]) != 0 {
+			return errCorrupt
+		}
+		seg.props[i] = name
+	}
+	s := t.shardOf(k)
+	s.Lock()
+	t.setProps(s, k, seg.props, touched)
+	s.Unlock()
+	return nil
+}
+
+const (
+	keyLen = 12
+	// hour last written u24, as in checkpoint records
+	hourLen = 3
+)
+
+func appendKey(b []byte, k Key) []byte {
+	b = appendUint32(b, k.Cluster)
+	return appendUint64(b, k.Job)
+}
+
+func readKey(b []byte) Key {
+	return Key{Cluster: binary.LittleEndian.Uint32(b), Job: binary.LittleEndian.Uint64(b[4:])}
+}
+
+func appendUint32(b []byte, v uint32) []byte {
+	return append(b, byte(v), byte(v>>8), byte(v>>16), byte(v>>24))
+}
+
+// appendHour appends the hour of touched, a time in Unix seconds
+func appendHour(b []byte, touched uint32) []byte {
+	h := touched / 3600
+	return append(b, byte(h), byte(h>>8), byte(h>>16))
+}
+
+// readHour returns the time of an hour written by appendHour
+func readHour(b []byte) uint32 {
+	return (uint32(b[0]) | uint32(b[1])<<8 | uint32(b[2])<<16) * 3600
+}
+
+func appendUint64(b []byte, v uint64) []byte {
+	return appendUint32(appendUint32(b, uint32(v)), uint32(v>>32))
+}
+
+// appendString appends s with a u16 length, cut to the first 64k bytes
+func appendString(b []byte, s string) []byte {
+	if len(s) > 0xFFFF {
+		s = s[:0xFFFF]
+	}
+	b = append(b, byte(len(s)), byte(len(s)>>8))
+	return append(b, s...)
+}
@@ -0,0 +1,124 @@
+package jobtable
+
+import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"sync"
+	"sync/atomic"
+	"testing"
+	"time"
+)
+
+func walTempBase(t *testing.T) (string, func()) {
+	dir, err := ioutil.TempDir("", "jobtable")
+	if err != nil {
+		t.Fatal(err)
+	}
+	return filepath.Join(dir, "job.states"), func() { os.RemoveAll(dir) }
+}
+
+// Jobs set while checkpoints switch log segments are all restored, each
+// record landing in a segment along with the clusters and symbols it
+// refers to
+func TestCheckpointConcurrentSet(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	const writers, jobs = 4, 5000
+
+	tb := New(0, 2)
+	if err := tb.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	var wg sync.WaitGroup
+	var written int32
+	for w := 0; w < writers; w++ {
+		wg.Add(1)
+		go func(w int) {
+			defer wg.Done()
+			for i := 0; i < jobs; i++ {
+				// a new cluster every few jobs, a new symbol every job
+				k := MakeKey(tb.ClusterID(fmt.Sprint("cluster", w, "_", i/10)), i, w)
+				tb.SetProps(k, []string{fmt.Sprint("job", w, "_", i), "normal"})
+				tb.Set(k, uint8(i%6))
+				atomic.AddInt32(&written, 1)
+			}
+		}(w)
+	}
+	// the jobs set after the last checkpoint are only in its segment
+	checkpoints := 0
+	for atomic.LoadInt32(&written) < writers*jobs/2 {
+		if err := tb.checkpoint(); err != nil {
+			t.Fatal(err)
+		}
+		checkpoints++
+	}
+	wg.Wait()
+	// restart without a final checkpoint, as after a crash
+	if err := tb.Sync(); err != nil {
+		t.Fatal(err)
+	}
+
+	tb2 := New(0, 2)
+	if err := tb2.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	defer tb2.Close()
+	if tb2.Len() != writers*jobs {
+		t.Fatalf("%d jobs restored after %d checkpoints, want %d", tb2.Len(), checkpoints, writers*jobs)
+	}
+	for w := 0; w < writers; w++ {
+		for i := 0; i < jobs; i++ {
+			k := MakeKey(tb2.ClusterID(fmt.Sprint("cluster", w, "_", i/10)), i, w)
+			st, ids, ok := tb2.Get(k, nil)
+			if !ok || st != uint8(i%6) {
+				t.Fatalf("job %d of writer %d: state %d, %v", i, w, st, ok)
+			}
+			if name := tb2.Symbol(ids[0]); name != fmt.Sprint("job", w, "_", i) {
+				t.Fatalf("job %d of writer %d: name %q", i, w, name)
+			}
+		}
+	}
+}
+
+// Replayed jobs keep the hour they were written, so a restart does not
+// renew their expiry
+func TestReplayKeepsTouched(t *testing.T) {
+	base, cleanup := walTempBase(t)
+	defer cleanup()
+	start := time.Unix(1500000000, 0)
+
+	tb := New(0, 1)
+	if err := tb.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	c := tb.ClusterID("cluster1")
+	tb.Expire(start)
+	tb.Set(MakeKey(c, 1, 0), 1)
+	tb.SetProps(MakeKey(c, 2, 0), []string{"normal"})
+	tb.Expire(start.Add(3 * time.Hour))
+	tb.Set(MakeKey(c, 3, 0), 1)
+	// restart without a final checkpoint, as after a crash
+	if err := tb.Sync(); err != nil {
+		t.Fatal(err)
+	}
+
+	tb2 := New(0, 1)
+	tb2.SetLimits(2*time.Hour, 0)
+	if err := tb2.Open(base, ""); err != nil {
+		t.Fatal(err)
+	}
+	defer tb2.Close()
+	expired := 0
+	for i := 0; i < numShards; i++ {
+		n, _ := tb2.Expire(start.Add(4 * time.Hour))
+		expired += n
+	}
+	if expired != 2 || tb2.Len() != 1 {
+		t.Fatalf("%d jobs expired, %d left, want 2 and 1", expired, tb2.Len())
+	}
+	if _, _, ok := tb2.Get(MakeKey(c, 3, 0), nil); !ok {
+		t.Fatal("job written within the TTL expired")
+	}
+}
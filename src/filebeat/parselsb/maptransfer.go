@@ -1,13 +1,14 @@
 package parselsb
 
 import (
-	"fmt"
 	"os"
 	"os/exec"
+	"strconv"
 	"strings"
+	"sync"
 	"time"
 
-	"github.com/elastic/beats/filebeat/parselsb/safemap"
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
 	"github.com/elastic/beats/libbeat/logp"
 	"github.com/robfig/cron"
 )
@@ -21,35 +22,78 @@ const (
 	LastStatusKey = "last_status"
 	CurStatusKey  = "current_status"
 	ChangeReason  = "change_reason"
+	QueueKey      = "queue_name"
+	BakFileName   = "job.states.snapshot"
+	StateFileBase = "job.states"
+
+	// jobs not changed for LSF_JOB_STATE_TTL (e.g. "720h") are dropped, and
+	// the least recently changed ones once the job states take more than
+	// LSF_JOB_STATE_MAX_MB of memory; "0" disables either
+	StateTTLKey     = "LSF_JOB_STATE_TTL"
+	StateMaxMBKey   = "LSF_JOB_STATE_MAX_MB"
+	DefaultStateTTL = 30 * 24 * time.Hour
+	DefaultMaxMB    = 1024
 )
 
 var extraFields = []string{"user_name", "queue_name", "job_name", "project_name", "user_group_name", "job_group", "app_profile"}
 
 type mapTransfer struct {
 	bakFile string
-	mmap    *safemap.SafeMap
-	c       *cron.Cron
-	pmap    *safemap.SafeMap
+	// job states and the extraFields of each job, in extraFields order,
+	// kept as symbol ids of the table
+	jobs *jobtable.Table
+	c    *cron.Cron
+	// harvesters running, the sync task runs while there are any
+	syncLock  sync.Mutex
+	syncUsers int
+	// scratch for property ids and values, only used by processJobEvent
+	propBuf []uint32
+	valBuf  []string
+	// status message encoders by topic name
+	encoders map[string]*statusEncoder
+	// history to rebuild the job states from on a cold start, see
+	// rebuild.go; rebuilt once done or if states were restored
+	rebuildFiles []string
+	rebuildSince time.Duration
+	rebuilt      bool
 }
 
 func newMapTransfer() *mapTransfer {
-	path := getFilePath()
 	mt := new(mapTransfer)
-	mt.bakFile = path
-	mt.mmap = safemap.NewSafeMap(MapSize, path)
-	mt.pmap = safemap.NewSafeMap(MapSize, "")
+	mt.bakFile = getFilePath(BakFileName)
+	mt.jobs = jobtable.New(MapSize, len(extraFields))
+	mt.propBuf = make([]uint32, 0, len(extraFields))
+	mt.valBuf = make([]string, 0, len(extraFields))
+	mt.encoders = make(map[string]*statusEncoder)
+	ttl, maxMB := getStateLimits()
+	mt.jobs.SetLimits(ttl, int64(maxMB)<<20)
+	// job states are kept in <bak path>/job.states.ckpt and .wal.*, the
+	// JSON job.states.snapshot of older versions is converted once
+	if err := mt.jobs.Open(getFilePath(StateFileBase), mt.bakFile); err != nil {
+		logp.Err("Fail opening job state log, job states will not be saved: %s", err.Error())
+	}
+	mt.rebuildFiles, mt.rebuildSince = getRebuildOptions(ttl)
+	mt.rebuilt = mt.jobs.Restored()
 	return mt
 }
 
 func (t *mapTransfer) registerSyncTask() {
+	t.syncLock.Lock()
+	defer t.syncLock.Unlock()
+	if t.syncUsers++; t.syncUsers > 1 {
+		return
+	}
 	t.c = cron.New()
 	spec := "*/1 * * * * ?"
 
 	t.c.AddFunc(spec, func() {
-		if flg := t.mmap.GetModifiedFlag(); flg {
+		t.jobs.Expire(time.Now())
+		if flg := t.jobs.GetModifiedFlag(); flg {
 			logp.Info("Run sync task at %v", time.Now())
-			t.mmap.UnsetModified()
-			t.mmap.SyncFile(t.bakFile)
+			t.jobs.UnsetModified()
+			if err := t.jobs.Sync(); err != nil {
+				logp.Err("Fail saving job states, error is %s", err.Error())
+			}
 		} else {
 			logp.Info("Job state snapshot is not changed at %v", time.Now())
 		}
@@ -60,75 +104,78 @@ func (t *mapTransfer) registerSyncTask() {
 }
 
 func (t *mapTransfer) stopSyncTask() {
-	if t.c != nil {
-		t.mmap.SyncFile(t.bakFile)
-		logp.Info("Stop sync task at %v\n", time.Now())
-		t.c.Stop()
-	} else {
+	t.syncLock.Lock()
+	defer t.syncLock.Unlock()
+	if t.syncUsers == 0 {
 		logp.Info("There is no active cron job\n")
+		return
+	}
+	if t.syncUsers--; t.syncUsers > 0 {
+		return
 	}
+	// the last harvester stopped, the log stays open for those started
+	// later and is synced so no change is lost if the beat exits now
+	t.c.Stop()
+	t.c = nil
+	if err := t.jobs.Sync(); err != nil {
+		logp.Err("Fail saving job states, error is %s", err.Error())
+	}
+	logp.Info("Stop sync task at %v\n", time.Now())
 }
 
-// ProcessJobEvent processes raw job event and generate job status info if possible
-func (t *mapTransfer) processJobEvent(event map[string]interface{}, topic *Topic) *MessageWithTopic {
+// ProcessJobEvent processes raw job event and generate job status info if possible.
+// The state is tracked from the typed view ev, event is only read for the
+// job properties and the included fields of the message.
+func (t *mapTransfer) processJobEvent(ev *jobEvent, event map[string]interface{}, topic *Topic) *MessageWithTopic {
 
 	// record job properties from JOB_NEW event
-	t.recordJobProperty(event)
+	t.recordJobProperty(ev, event)
 
 	var ret *MessageWithTopic = nil
 
-	state := getState(event)
-	if state == nil {
+	state, changed := getState(ev)
+	if !changed {
 		return nil
 	}
 
-	uid := getUid(event)
-
-	var prop map[string]string
+	key := t.getJobKey(ev)
 
-	propRaw, propOK := t.pmap.ReadMap(uid)
-	if propOK {
-		prop = propRaw.(map[string]string)
+	stateVal, prop, ok := t.jobs.Get(key, t.propBuf[:0])
+	if len(prop) == 0 {
+		prop = nil
 	}
 
-	val, ok := t.mmap.ReadMap(uid)
 	if ok == false {
-		if state.state < 6 {
-			t.mmap.WriteMap(uid, state.state)
-		}
 		sm := new(stateMessage)
-		sm.cluster = getString(event, ClusterKey)
-		sm.jobId = getInt(event, JobIdKey)
-		sm.jobIdx = getInt(event, JobIdxKey)
+		sm.cluster = ev.cluster
+		sm.jobId = ev.jobId
+		sm.jobIdx = ev.jobIdx
 		sm.lastState = -1
 		sm.currentState = state.state
 		sm.reason = state.reason
-		ret = stateToMessageWithTopic(sm, event, topic, prop)
-	} else {
-		var stateVal = -1
-		if intVal, isInt := val.(int); isInt {
-			stateVal = intVal
-		} else if floatVal, isFloat := val.(float64); isFloat {
-			stateVal = int(floatVal)
-		} else if floatVal, isFloat := val.(float32); isFloat {
-			stateVal = int(floatVal)
-		}
+		ret = t.stateToMessageWithTopic(sm, event, topic, prop)
 
-		if state.state != stateVal {
-			t.mmap.WriteMap(uid, state.state)
+		if state.state < 6 {
+			t.jobs.Set(key, uint8(state.state))
+		} else {
+			// finished before we saw it, drop any recorded properties
+			t.jobs.Delete(key)
+		}
+	} else {
+		if state.state != int(stateVal) {
+			t.jobs.Set(key, uint8(state.state))
 			sm := new(stateMessage)
-			sm.cluster = getString(event, ClusterKey)
-			sm.jobId = getInt(event, JobIdKey)
-			sm.jobIdx = getInt(event, JobIdxKey)
-			sm.lastState = stateVal
+			sm.cluster = ev.cluster
+			sm.jobId = ev.jobId
+			sm.jobIdx = ev.jobIdx
+			sm.lastState = int(stateVal)
 			sm.currentState = state.state
 			sm.reason = state.reason
-			ret = stateToMessageWithTopic(sm, event, topic, prop)
+			ret = t.stateToMessageWithTopic(sm, event, topic, prop)
 
 			// delete finished job from status snapshot
 			if state.state >= 6 {
-				t.mmap.DelMap(uid)
-				t.pmap.DelMap(uid)
+				t.jobs.Delete(key)
 			}
 		}
 	}
@@ -136,76 +183,91 @@ func (t *mapTransfer) processJobEvent(event map[string]interface{}, topic *Topic
 	return ret
 }
 
-func (t *mapTransfer) recordJobProperty(event map[string]interface{}) {
-	eventType := getString(event, "event_type")
-	if eventType == "JOB_NEW" {
-		uid := getUid(event)
-		prop := make(map[string]string)
+func (t *mapTransfer) recordJobProperty(ev *jobEvent, event map[string]interface{}) {
+	switch ev.eventType {
+	case jobEventNew:
+		prop := t.valBuf[:0]
 		for _, fld := range extraFields {
-			prop[fld] = getString(event, fld)
+			prop = append(prop, getString(event, fld))
 		}
-		t.pmap.WriteMap(uid, prop)
+		t.jobs.SetProps(t.getJobKey(ev), prop)
+	case jobEventSwitch:
+		// keep the queue of the routing keys up to date
+		t.setJobProperty(t.getJobKey(ev), QueueKey, getString(event, QueueKey))
 	}
 }
 
-func stateToMessageWithTopic(sm *stateMessage, event map[string]interface{}, topic *Topic, prop map[string]string) *MessageWithTopic {
-	topicName := topic.TopicName
-	m := make(map[string]interface{})
-	m[ClusterKey] = sm.cluster
-	m[JobIdKey] = sm.jobId
-	m[JobIdxKey] = sm.jobIdx
-	if sm.lastState > 0 {
-		m[LastStatusKey] = getStateName(sm.lastState)
-	}
-	m[CurStatusKey] = getStateName(sm.currentState)
-	m[ChangeReason] = sm.reason
-
-	// add user specified fields
-	if topic.IncludeFields != nil && len(topic.IncludeFields) > 0 {
-		// add user specified fields
-		for _, fld := range topic.IncludeFields {
-			if v, ok := event[fld]; ok {
-				m[fld] = v
-			} else if topic.AddFields != nil {
-				if addedVal, addedOK := topic.AddFields[fld]; addedOK {
-					m[fld] = addedVal
-				}
-			} else {
-				// skip the invalid field name
-			}
+// setJobProperty changes one of the extraFields of a job whose properties
+// were recorded
+func (t *mapTransfer) setJobProperty(key jobtable.Key, name string, value string) {
+	_, ids, ok := t.jobs.Get(key, t.propBuf[:0])
+	if !ok || len(ids) == 0 {
+		return
+	}
+	prop := t.valBuf[:0]
+	for i, fld := range extraFields {
+		if fld == name {
+			prop = append(prop, value)
+		} else {
+			prop = append(prop, t.jobs.Symbol(ids[i]))
 		}
 	}
+	t.jobs.SetProps(key, prop)
+}
 
-	txt := jsonToString(m)
-
-	// add job property from JOB_NEW event
-	if prop != nil {
-		for _, efld := range extraFields {
-			m[efld] = prop[efld]
-		}
+// stateToMessageWithTopic builds the message of a state change with the
+// encoder of the topic. prop holds the symbol ids of the extraFields of
+// the job, which only feed the routing key and properties.
+func (t *mapTransfer) stateToMessageWithTopic(sm *stateMessage, event map[string]interface{}, topic *Topic, prop []uint32) *MessageWithTopic {
+	enc := t.encoders[topic.TopicName]
+	if enc == nil || !enc.plannedFor(topic) {
+		enc = newStatusEncoder(topic)
+		t.encoders[topic.TopicName] = enc
 	}
 
-	return &MessageWithTopic{
-		Text:       txt,
-		Topic:      topicName,
-		RoutingKey: getRoutingKey(m, topic),
-		Props:      getProperties(m, topic),
+	msg := &MessageWithTopic{
+		Text:  enc.encode(sm, event, topic),
+		Topic: topic.TopicName,
 	}
+	if len(enc.routes) > 0 {
+		msg.RoutingKey, msg.Props = enc.route(sm, event, topic, prop, t.jobs)
+	}
+	return msg
+}
+
+func (t *mapTransfer) getJobKey(ev *jobEvent) jobtable.Key {
+	cluster := t.jobs.ClusterID(ev.cluster)
+	return jobtable.MakeKey(cluster, ev.jobId, ev.jobIdx)
 }
 
-func getUid(event map[string]interface{}) string {
-	cluster := getString(event, ClusterKey)
-	id := getInt(event, JobIdKey)
-	idx := getInt(event, JobIdxKey)
-	uid := fmt.Sprintf("%v_%v_%v", cluster, id, idx)
-	return uid
+// getStateLimits returns the job state TTL and memory budget from the
+// environment, or their defaults
+func getStateLimits() (time.Duration, int) {
+	ttl := DefaultStateTTL
+	if v := os.Getenv(StateTTLKey); len(v) > 0 {
+		if d, err := time.ParseDuration(v); err == nil && d >= 0 {
+			ttl = d
+		} else {
+			logp.Err("Fail parsing %s=%s, use %v", StateTTLKey, v, ttl)
+		}
+	}
+
+	maxMB := DefaultMaxMB
+	if v := os.Getenv(StateMaxMBKey); len(v) > 0 {
+		if n, err := strconv.Atoi(v); err == nil && n >= 0 {
+			maxMB = n
+		} else {
+			logp.Err("Fail parsing %s=%s, use %d", StateMaxMBKey, v, maxMB)
+		}
+	}
+	logp.Info("Job state TTL %v, memory budget %d MB", ttl, maxMB)
+	return ttl, maxMB
 }
 
-func getFilePath() string {
+func getFilePath(name string) string {
 	var prefix string = ""
 
 	BAK_PATH_KEY := "LSF_BAK_PATH"
-	BAK_FILE_NAME := "job.states.snapshot"
 	bakPath := os.Getenv(BAK_PATH_KEY)
 
 	if len(bakPath) > 0 {
@@ -220,5 +282,5 @@ func getFilePath() string {
 			prefix = string(path[0:(idx + 1)])
 		}
 	}
-	return prefix + BAK_FILE_NAME
+	return prefix + name
 }
@@ -0,0 +1,91 @@
+package parselsb
+
+import (
+	"sync/atomic"
+	"time"
+
+	"github.com/elastic/beats/libbeat/monitoring"
+)
+
+// The parser stage is measured by how long batches wait in its queue and
+// how long they take to parse. Batches waiting long behind others, or
+// parsed slowly, make the parser the stage holding events back.
+var (
+	parserMetrics = monitoring.Default.NewRegistry("parselsb.parser")
+
+	metricQueueCapacity = monitoring.NewInt(parserMetrics, "queue.capacity")
+	metricQueueDepth    = monitoring.NewInt(parserMetrics, "queue.depth")
+	metricBatches       = monitoring.NewInt(parserMetrics, "batches")
+	metricRecords       = monitoring.NewInt(parserMetrics, "records")
+	metricQueueWait     = NewHistogram(parserMetrics, "queue_wait")
+	metricParse         = NewHistogram(parserMetrics, "parse")
+)
+
+// upper bounds of the buckets of a histogram, the last bucket holds the
+// longer durations
+var histogramBounds = []struct {
+	name  string
+	bound time.Duration
+}{
+	{"le_10us", 10 * time.Microsecond},
+	{"le_100us", 100 * time.Microsecond},
+	{"le_1ms", time.Millisecond},
+	{"le_10ms", 10 * time.Millisecond},
+	{"le_100ms", 100 * time.Millisecond},
+	{"le_1s", time.Second},
+	{"le_10s", 10 * time.Second},
+}
+
+// Histogram counts durations in decade buckets, with their count, sum and
+// maximum, as monitoring values under its name
+type Histogram struct {
+	count   *monitoring.Int
+	sum     *monitoring.Int
+	max     *monitoring.Int
+	buckets []*monitoring.Int
+	// max in ns, as monitoring.Int has no compare and swap
+	maxNs int64
+}
+
+func NewHistogram(r *monitoring.Registry, name string) *Histogram {
+	reg := r.NewRegistry(name)
+	h := &Histogram{
+		count: monitoring.NewInt(reg, "count"),
+		sum:   monitoring.NewInt(reg, "sum_us"),
+		max:   monitoring.NewInt(reg, "max_us"),
+	}
+	buckets := reg.NewRegistry("buckets")
+	for _, b := range histogramBounds {
+		h.buckets = append(h.buckets, monitoring.NewInt(buckets, b.name))
+	}
+	h.buckets = append(h.buckets, monitoring.NewInt(buckets, "gt_10s"))
+	return h
+}
+
+// Observe counts a duration
+func (h *Histogram) Observe(d time.Duration) {
+	i := 0
+	for i < len(histogramBounds) && d > histogramBounds[i].bound {
+		i++
+	}
+	h.buckets[i].Inc()
+	h.count.Inc()
+	h.sum.Add(int64(d / time.Microsecond))
+	for {
+		max := atomic.LoadInt64(&h.maxNs)
+		if int64(d) <= max {
+			break
+		}
+		if atomic.CompareAndSwapInt64(&h.maxNs, max, int64(d)) {
+			h.max.Set(int64(d / time.Microsecond))
+			break
+		}
+	}
+}
+
+// Since counts the time since start, and returns the time now
+func (h *Histogram) Since(start time.Time) time.Time {
+	now := time.Now()
+	h.Observe(now.Sub(start))
+	return now
+}
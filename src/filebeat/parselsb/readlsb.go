@@ -9,9 +9,12 @@ package parselsb
 import "C"
 
 import (
-	"fmt"
+	"os"
+	"path/filepath"
+	"strconv"
 	"strings"
 	"sync"
+	"time"
 	"unsafe"
 
 	"github.com/elastic/beats/libbeat/logp"
@@ -24,9 +27,40 @@ const (
 	StatusFile
 )
 
+const (
+	// batches posted to the parser and not yet parsed, beyond which
+	// posters block, as set with LSF_PARSER_QUEUE
+	ParserQueueKey     = "LSF_PARSER_QUEUE"
+	DefaultParserQueue = 100
+)
+
+// FileTypes are the file types by name, as set with lsf_file_type. The
+// name is also what a file of the type is called.
+var FileTypes = map[string]int{
+	"lsb.events": EventFile,
+	"lsb.stream": StreamFile,
+	"lsb.acct":   AcctFile,
+	"lsb.status": StatusFile,
+}
+
+// GetFileType returns the type of an LSF file from its name, rotated
+// names such as lsb.stream.1 included; -1 if it is not an LSF file
+func GetFileType(source string) int {
+	name := filepath.Base(source)
+	for _, typeName := range []string{"lsb.stream", "lsb.acct", "lsb.events", "lsb.status"} {
+		if strings.Contains(name, typeName) {
+			return FileTypes[typeName]
+		}
+	}
+	return -1
+}
+
 // LsfRec contains lsf event related info
 type LsfRec struct {
-	RawContent string
+	// RawContent is the record as read by the harvester. It is handed to
+	// the C parser as (pointer, length) without a copy, so the poster must
+	// not modify it until the result is received on RetChan.
+	RawContent []byte
 	Type       int
 	RetChan    chan []MessageWithTopic
 	Topics     []Topic
@@ -38,18 +72,41 @@ type MessageWithTopic struct {
 	Topic      string
 	RoutingKey string
 	Props      map[string]string
+	// index of the topic in the topics of the record, which with the
+	// position of the record makes the id of the message
+	TopicIndex int
 }
 
 type parser struct {
 	counter int
-	rawChan chan LsfRec
+	rawChan chan lsfBatch
+}
+
+// lsfBatch is what is posted to the parser goroutine: one record from
+// Post, or the records of PostBatch whose results go back together, or
+// records parsed ahead by a backfill
+type lsfBatch struct {
+	recs    []LsfRec
+	parsed  []*parsedRec
+	topics  []Topic
+	retChan chan [][]MessageWithTopic
+	// when it was posted
+	queued time.Time
 }
 
 var singleton *parser
 var once sync.Once
 var sh StateHandler
 
-// StopSyncTask stops job status snapshot sync task
+// StartSyncTask starts the job status snapshot sync task for a harvester,
+// unless one started it already
+func StartSyncTask() {
+	NewLsbParser()
+	sh.registerSyncTask()
+}
+
+// StopSyncTask stops job status snapshot sync task once every harvester
+// which started it stopped
 func StopSyncTask() {
 	sh.stopSyncTask()
 }
@@ -59,70 +116,45 @@ func NewLsbParser() *parser {
 	once.Do(func() {
 		// initiate a mapTransfer as StateHandler
 		sh = newMapTransfer()
-		// start the scheduled sync task
-		sh.registerSyncTask()
 
 		if singleton == nil {
 			singleton = new(parser)
 			singleton.counter = 0
-			singleton.rawChan = make(chan LsfRec, 100)
+			queue := getParserQueue()
+			singleton.rawChan = make(chan lsfBatch, queue)
+			metricQueueCapacity.Set(int64(queue))
 			go func() { // listen for events on the raw channel
+				rp := new(recordParser)
 				for {
-					rec := <-singleton.rawChan
-					logp.Debug("lsf", "Parser received raw record %s", rec.RawContent)
-					singleton.counter++
-					var output *C.char
-					switch rec.Type {
-					case EventFile:
-						output = C.readlsbEvents(C.CString(rec.RawContent))
-						logp.Debug("Done parsing event %s, result is %s ", rec.RawContent, C.GoString(output))
-					case StreamFile:
-						output = C.readlsbStream(C.CString(rec.RawContent))
-						logp.Debug("lsf", "Done parsing stream")
-					case AcctFile:
-						output = C.readlsbAcct(C.CString(rec.RawContent))
-						logp.Debug("lsf", "Done parsing acct")
-					case StatusFile:
-						output = C.readlsbStatus(C.CString(rec.RawContent))
-						logp.Debug("lsf", "Done parsing event")
-					default:
-						logp.Info("lsbparser - unknown type %s", rec.Type)
+					batch := <-singleton.rawChan
+					metricQueueDepth.Set(int64(len(singleton.rawChan)))
+					start := metricQueueWait.Since(batch.queued)
+					metricBatches.Inc()
+					if batch.retChan == nil {
+						rec := batch.recs[0]
+						msgs := parseRecord(rp, &rec)
+						metricParse.Since(start)
+						metricRecords.Inc()
+						rec.RetChan <- msgs
+						continue
 					}
-					res := C.GoString(output)
-
-					var msgs []MessageWithTopic
-					// subsequent data processing
-					mjsonRaw := stringToJson(&res)
-
-					for _, tp := range rec.Topics {
-						mjson := addFields(mjsonRaw, tp.AddFields)
-						switch tp.Type {
-						case "job.raw":
-							// filter the fields by options
-							res = selectFields(mjson, &tp)
-
-							logp.Debug("lsf", "Parsed content: %s\n", res)
-							msgs = append(msgs, MessageWithTopic{
-								Text:       res,
-								Topic:      tp.TopicName,
-								RoutingKey: getRoutingKey(mjson, &tp),
-								Props:      getProperties(mjson, &tp),
-							})
-						case "job.status.trace":
-							// add job state message if needed
-							newMsg := sh.processJobEvent(mjson, &tp)
-							if newMsg != nil {
-								logp.Debug("lsf", "Added content: %s\n", newMsg.Text)
-								msgs = append(msgs, *newMsg)
-							}
-						default:
-							logp.Err("lsf", "Unsupported topic type: %s\n", tp.Type)
+					if batch.parsed != nil {
+						res := make([][]MessageWithTopic, len(batch.parsed))
+						for i, rec := range batch.parsed {
+							res[i] = recordMessages(&rec.ev, rec.event, batch.topics)
 						}
+						metricParse.Since(start)
+						metricRecords.Add(int64(len(res)))
+						batch.retChan <- res
+						continue
 					}
-
-					rec.RetChan <- msgs
-
-					C.free(unsafe.Pointer(output))
+					res := make([][]MessageWithTopic, len(batch.recs))
+					for i := range batch.recs {
+						res[i] = parseRecord(rp, &batch.recs[i])
+					}
+					metricParse.Since(start)
+					metricRecords.Add(int64(len(res)))
+					batch.retChan <- res
 				}
 			}()
 		}
@@ -130,9 +162,168 @@ func NewLsbParser() *parser {
 	return singleton
 }
 
+// parseRecord returns the messages of a record for its topics
+func parseRecord(rp *recordParser, rec *LsfRec) []MessageWithTopic {
+	logp.Debug("lsf", "Parser received raw record %s", rec.RawContent)
+	singleton.counter++
+	res, ev := rp.parse(rec.Type, rec.RawContent)
+
+	// subsequent data processing
+	mjsonRaw := stringToJson(&res)
+	return recordMessages(&ev, mjsonRaw, rec.Topics)
+}
+
+// recordMessages returns the messages of a parsed record for topics
+func recordMessages(ev *jobEvent, mjsonRaw map[string]interface{}, topics []Topic) []MessageWithTopic {
+	var msgs []MessageWithTopic
+
+	// on a cold start the job states are rebuilt from the
+	// event history before the first status message
+	if mjsonRaw != nil {
+		sh.rebuildStates(topics, mjsonRaw)
+	}
+
+	for i, tp := range topics {
+		mjson := addFields(mjsonRaw, tp.AddFields)
+		switch tp.Type {
+		case "job.raw":
+			// filter the fields by options
+			res := selectFields(mjson, &tp)
+
+			logp.Debug("lsf", "Parsed content: %s\n", res)
+			msgs = append(msgs, MessageWithTopic{
+				Text:       res,
+				Topic:      tp.TopicName,
+				RoutingKey: getRoutingKey(mjson, &tp),
+				Props:      getProperties(mjson, &tp),
+				TopicIndex: i,
+			})
+		case "job.status.trace":
+			// add job state message if needed
+			ev.cluster = getString(mjson, ClusterKey)
+			newMsg := sh.processJobEvent(ev, mjson, &tp)
+			if newMsg != nil {
+				logp.Debug("lsf", "Added content: %s\n", newMsg.Text)
+				newMsg.TopicIndex = i
+				msgs = append(msgs, *newMsg)
+			}
+		default:
+			logp.Err("lsf", "Unsupported topic type: %s\n", tp.Type)
+		}
+	}
+	return msgs
+}
+
+// recordParser runs the C parser over records, one per goroutine
+type recordParser struct {
+	// job fields of the last record, filled by the parser
+	info C.struct_lsbJobInfo
+}
+
+// parse returns the JSON text of a record of a file type, "" if it cannot
+// be parsed, and its typed job event
+func (p *recordParser) parse(fileType int, record []byte) (string, jobEvent) {
+	var output *C.char
+	raw, rawLen := cBytes(record)
+	switch fileType {
+	case EventFile:
+		output = C.readlsbEventsInfoN(raw, rawLen, &p.info)
+		logp.Debug("lsf", "Done parsing event")
+	case StreamFile:
+		output = C.readlsbStreamInfoN(raw, rawLen, &p.info)
+		logp.Debug("lsf", "Done parsing stream")
+	case AcctFile:
+		output = C.readlsbAcctInfoN(raw, rawLen, &p.info)
+		logp.Debug("lsf", "Done parsing acct")
+	case StatusFile:
+		output = C.readlsbStatusInfoN(raw, rawLen, &p.info)
+		logp.Debug("lsf", "Done parsing event")
+	default:
+		p.info = C.struct_lsbJobInfo{}
+		logp.Info("lsbparser - unknown type %s", fileType)
+	}
+	res := C.GoString(output)
+	C.free(unsafe.Pointer(output))
+
+	return res, p.event(fileType)
+}
+
+// jobInfo returns the typed job event of a record without building its
+// JSON text, false if it cannot be parsed
+func (p *recordParser) jobInfo(fileType int, record []byte) (jobEvent, bool) {
+	var ret C.int
+	raw, rawLen := cBytes(record)
+	switch fileType {
+	case EventFile:
+		ret = C.readlsbEventsJobInfoN(raw, rawLen, &p.info)
+	case StreamFile:
+		ret = C.readlsbStreamJobInfoN(raw, rawLen, &p.info)
+	case AcctFile:
+		ret = C.readlsbAcctJobInfoN(raw, rawLen, &p.info)
+	case StatusFile:
+		ret = C.readlsbStatusJobInfoN(raw, rawLen, &p.info)
+	default:
+		return jobEvent{}, false
+	}
+	return p.event(fileType), ret == 0
+}
+
+func (p *recordParser) event(fileType int) jobEvent {
+	return jobEvent{
+		eventType:  int(p.info.eventType),
+		jobId:      int(p.info.jobId),
+		jobIdx:     int(p.info.idx),
+		status:     int(p.info.jStatus),
+		exitStatus: int(p.info.exitStatus),
+		exitInfo:   int(p.info.exitInfo),
+		acct:       fileType == AcctFile,
+	}
+}
+
+// cBytes returns a (pointer, length) view of b for the length aware C
+// parser entry points. The C side copies what it needs before returning,
+// so b is only borrowed for the duration of the call.
+func cBytes(b []byte) (*C.char, C.int) {
+	if len(b) == 0 {
+		return nil, 0
+	}
+	return (*C.char)(unsafe.Pointer(&b[0])), C.int(len(b))
+}
+
 func (p *parser) Post(rec LsfRec) {
 	logp.Debug("lsf", "Parser.Post()")
-	p.rawChan <- rec
+	p.post(lsfBatch{recs: []LsfRec{rec}})
+}
+
+// PostBatch parses records in one round trip to the parser goroutine and
+// sends their messages, in order, on retChan. RetChan of the records is
+// not used. As with Post, the raw contents must not be modified until the
+// result is received.
+func (p *parser) PostBatch(recs []LsfRec, retChan chan [][]MessageWithTopic) {
+	logp.Debug("lsf", "Parser.PostBatch() %d records", len(recs))
+	p.post(lsfBatch{recs: recs, retChan: retChan})
+}
+
+// post queues a batch for the parser goroutine
+func (p *parser) post(batch lsfBatch) {
+	batch.queued = time.Now()
+	p.rawChan <- batch
+	metricQueueDepth.Set(int64(len(p.rawChan)))
+}
+
+// getParserQueue returns the capacity of the parser queue from the
+// environment, or its default
+func getParserQueue() int {
+	queue := DefaultParserQueue
+	if v := os.Getenv(ParserQueueKey); len(v) > 0 {
+		if n, err := strconv.Atoi(v); err == nil && n >= 0 {
+			queue = n
+		} else {
+			logp.Err("Fail parsing %s=%s, use %d", ParserQueueKey, v, queue)
+		}
+	}
+	logp.Info("Parser queue of %d batches", queue)
+	return queue
 }
 
 // getProperties generates rocketmq property map according to Topic.RoutingKeys
@@ -143,9 +334,11 @@ func getProperties(json map[string]interface{}, tp *Topic) map[string]string {
 
 	propMap := make(map[string]string)
 
+	var buf []byte
 	for _, key := range tp.RoutingKeys {
 		if val, ok := json[key]; ok {
-			propMap[key] = fmt.Sprintf("%v", val)
+			buf = appendText(buf[:0], val)
+			propMap[key] = string(buf)
 		}
 	}
 
@@ -158,30 +351,17 @@ func getRoutingKey(json map[string]interface{}, tp *Topic) string {
 		return ""
 	}
 
-	routingKey := ""
-
+	var routingKey strings.Builder
+	var buf []byte
 	for i, key := range tp.RoutingKeys {
+		if i > 0 {
+			routingKey.WriteByte('.')
+		}
 		if val, ok := json[key]; ok {
-			if i > 0 {
-				routingKey = routingKey + "." + fmt.Sprintf("%v", val)
-			} else {
-				routingKey = fmt.Sprintf("%v", val)
-			}
-		} else {
-			if i > 0 {
-				routingKey = routingKey + "."
-			} else {
-				routingKey = ""
-			}
+			buf = appendText(buf[:0], val)
+			routingKey.Write(buf)
 		}
 	}
 
-	length := strings.Count(routingKey, "") - 1
-
-	if length > 255 {
-		logp.Warn("lsf", "routingKey [%v] is too long [%v]", routingKey, length)
-		return ""
-	} else {
-		return routingKey
-	}
+	return checkRoutingKey(routingKey.String())
 }
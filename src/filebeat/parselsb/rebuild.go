@@ -0,0 +1,422 @@
+package parselsb
+
+import (
+	"bufio"
+	"bytes"
+	"io"
+	"os"
+	"runtime"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
+	"github.com/elastic/beats/libbeat/logp"
+)
+
+// Without saved job states every job in flight looks new, and its first
+// status message has no last_status. On such a cold start the states of
+// the unfinished jobs are rebuilt from the LSF event history before the
+// first status message is published: the files of LSF_JOB_STATE_REBUILD
+// are cut into line aligned chunks parsed in parallel, each chunk keeps
+// the last state and properties of its jobs, and the chunks are merged in
+// file order so the latest event of a job wins.
+const (
+	// comma separated lsb.stream or lsb.events files, oldest first
+	RebuildFilesKey = "LSF_JOB_STATE_REBUILD"
+	// only events of the last LSF_JOB_STATE_REBUILD_SINCE (e.g. "72h")
+	// are replayed, by default those of the job state TTL
+	RebuildSinceKey = "LSF_JOB_STATE_REBUILD_SINCE"
+	// time of a parsed record, in Unix seconds
+	EventTimeKey = "event_time_utc"
+
+	minRebuildChunk = 1 << 20
+	maxRebuildLine  = 16 << 20
+)
+
+// rebuiltJob is what a stretch of history says about a job
+type rebuiltJob struct {
+	// state after the last state change, -1 if none
+	state int
+	// extraFields of the last JOB_NEW, nil if none
+	props []string
+	// queue switched to with no JOB_NEW before it
+	queue    string
+	switched bool
+}
+
+// setQueue records a JOB_SWITCH of the job
+func (j *rebuiltJob) setQueue(queue string) {
+	if j.props != nil {
+		j.props[extraIndex(QueueKey)] = queue
+		return
+	}
+	j.queue, j.switched = queue, true
+}
+
+// merge applies what a later stretch of history says about the job
+func (j *rebuiltJob) merge(later *rebuiltJob) {
+	if later.state >= 0 {
+		j.state = later.state
+	}
+	if later.props != nil {
+		j.props, j.switched = later.props, false
+	} else if later.switched {
+		j.setQueue(later.queue)
+	}
+}
+
+// rebuildChunk is a line aligned byte range of a history file
+type rebuildChunk struct {
+	file     string
+	fileType int
+	from, to int64
+}
+
+// getRebuildOptions returns the history files and how far back to replay
+// them from the environment
+func getRebuildOptions(ttl time.Duration) ([]string, time.Duration) {
+	var files []string
+	for _, f := range strings.Split(os.Getenv(RebuildFilesKey), ",") {
+		if f = strings.TrimSpace(f); len(f) > 0 {
+			files = append(files, f)
+		}
+	}
+
+	since := ttl
+	if v := os.Getenv(RebuildSinceKey); len(v) > 0 {
+		if d, err := time.ParseDuration(v); err == nil && d >= 0 {
+			since = d
+		} else {
+			logp.Err("Fail parsing %s=%s, use %v", RebuildSinceKey, v, since)
+		}
+	}
+	return files, since
+}
+
+// rebuildStates rebuilds the job states once on a cold start, for the
+// cluster of the status topics of the first parsed record. The history is
+// replayed up to the time of that record, those from then on are read by
+// the harvesters.
+func (t *mapTransfer) rebuildStates(topics []Topic, event map[string]interface{}) {
+	if t.rebuilt {
+		return
+	}
+	cluster, found := "", false
+	for i := range topics {
+		if topics[i].Type != "job.status.trace" {
+			continue
+		}
+		c := getString(event, ClusterKey)
+		if v, ok := topics[i].AddFields[ClusterKey]; ok {
+			c = string(appendText(nil, v))
+		}
+		if found && c != cluster {
+			// the history does not tell the cluster of its jobs
+			t.rebuilt = true
+			logp.Err("Not rebuilding job states, the status topics are of clusters %s and %s", cluster, c)
+			return
+		}
+		cluster, found = c, true
+	}
+	if !found {
+		return
+	}
+	t.rebuilt = true
+	if len(t.rebuildFiles) == 0 {
+		return
+	}
+
+	start := time.Now()
+	until := start
+	if v, ok := event[EventTimeKey].(float64); ok && v > 0 {
+		until = time.Unix(int64(v), 0)
+	}
+	jobs, records := rebuildJobs(t.rebuildFiles, start.Add(-t.rebuildSince), until)
+	n := 0
+	id := t.jobs.ClusterID(cluster)
+	for k, j := range jobs {
+		// finished jobs are not kept, as in processJobEvent
+		if j.state < 0 || j.state >= 6 {
+			continue
+		}
+		key := jobtable.Key{Job: k.Job, Cluster: id}
+		t.jobs.Set(key, uint8(j.state))
+		if j.props != nil {
+			t.jobs.SetProps(key, j.props)
+		}
+		n++
+	}
+	logp.Info("Rebuilt %d job states of cluster %s from %d records of %v in %v", n, cluster, records, t.rebuildFiles, time.Since(start))
+}
+
+// rebuildJobs replays the events from since until before until of the
+// history files, in parallel chunks, and returns the jobs they leave by
+// key of cluster 0 and the number of records replayed
+func rebuildJobs(files []string, since time.Time, until time.Time) (map[jobtable.Key]*rebuiltJob, int) {
+	workers := runtime.NumCPU()
+	var chunks []rebuildChunk
+	for _, file := range files {
+		fileType := GetFileType(file)
+		if fileType != StreamFile {
+			fileType = EventFile
+		}
+		c, err := planChunks(file, fileType, since.Unix(), workers)
+		if err != nil {
+			logp.Err("Fail reading job history %s: %s", file, err.Error())
+			continue
+		}
+		chunks = append(chunks, c...)
+	}
+
+	// the C parser has already loaded LSF for the record which started
+	// the rebuild, so the workers do not race on that; it serializes the
+	// LSF calls which are not thread safe, those reading lsb.events
+	results := make([]map[jobtable.Key]*rebuiltJob, len(chunks))
+	counts := make([]int, len(chunks))
+	next := make(chan int, len(chunks))
+	for i := range chunks {
+		next <- i
+	}
+	close(next)
+	var wg sync.WaitGroup
+	for w := 0; w < workers && w < len(chunks); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			rp := new(recordParser)
+			for i := range next {
+				var err error
+				results[i], counts[i], err = scanChunk(rp, chunks[i], since.Unix(), until.Unix())
+				if err != nil {
+					logp.Err("Fail reading job history %s: %s", chunks[i].file, err.Error())
+				}
+			}
+		}()
+	}
+	wg.Wait()
+
+	records := 0
+	for _, n := range counts {
+		records += n
+	}
+	return mergeRebuilt(results), records
+}
+
+// mergeRebuilt merges what the chunks say about each job, in chunk order
+// so the latest event of a job wins
+func mergeRebuilt(results []map[jobtable.Key]*rebuiltJob) map[jobtable.Key]*rebuiltJob {
+	jobs := make(map[jobtable.Key]*rebuiltJob)
+	for _, result := range results {
+		for k, later := range result {
+			if j, ok := jobs[k]; ok {
+				j.merge(later)
+			} else {
+				jobs[k] = later
+			}
+		}
+	}
+	return jobs
+}
+
+// planChunks cuts the part of a file newer than since into up to n line
+// aligned chunks
+func planChunks(file string, fileType int, since int64, n int) ([]rebuildChunk, error) {
+	f, err := os.Open(file)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	info, err := f.Stat()
+	if err != nil {
+		return nil, err
+	}
+	size := info.Size()
+	from, err := findStart(f, size, since)
+	if err != nil {
+		return nil, err
+	}
+
+	step := (size - from + int64(n) - 1) / int64(n)
+	if step < minRebuildChunk {
+		step = minRebuildChunk
+	}
+	var chunks []rebuildChunk
+	for from < size {
+		to := size
+		if from+step < size {
+			if to, err = recordStart(f, from+step, size); err != nil {
+				return nil, err
+			}
+		}
+		chunks = append(chunks, rebuildChunk{file: file, fileType: fileType, from: from, to: to})
+		from = to
+	}
+	return chunks, nil
+}
+
+// findStart returns the start of a line at or before the first event
+// newer than since. Events are logged in time order, so this is a binary
+// search; the chunks skip older lines left after the returned offset.
+func findStart(f *os.File, size int64, since int64) (int64, error) {
+	lo, hi := int64(0), size
+	for hi-lo > minRebuildChunk {
+		mid := lo + (hi-lo)/2
+		start, err := recordStart(f, mid, hi)
+		if err != nil {
+			return 0, err
+		}
+		r := bufio.NewReader(io.NewSectionReader(f, start, hi-start))
+		for {
+			line, err := r.ReadSlice('\n')
+			n := len(line)
+			t, ok := eventTime(line)
+			for err == bufio.ErrBufferFull {
+				// the rest of a long line
+				line, err = r.ReadSlice('\n')
+				n += len(line)
+			}
+			if ok {
+				if t < since {
+					lo = start
+				} else {
+					hi = mid
+				}
+				break
+			}
+			if err != nil {
+				if err != io.EOF {
+					return 0, err
+				}
+				hi = mid
+				break
+			}
+			start += int64(n)
+		}
+	}
+	return lo, nil
+}
+
+// recordStart returns the start of the first record at or after off,
+// limit if there is none before it. Lines which do not look like the
+// start of a record are skipped, as they may go on a record with line
+// breaks in a quoted field.
+func recordStart(f *os.File, off int64, limit int64) (int64, error) {
+	if off == 0 {
+		return 0, nil
+	}
+	pos := off - 1
+	r := bufio.NewReader(io.NewSectionReader(f, pos, limit-pos))
+	// whether b starts a line, the first b ends the line at off-1
+	head := false
+	for {
+		b, err := r.ReadSlice('\n')
+		if head && RecordHead(b) {
+			return pos, nil
+		}
+		head = err == nil
+		pos += int64(len(b))
+		switch err {
+		case nil, bufio.ErrBufferFull:
+		case io.EOF:
+			return limit, nil
+		default:
+			return 0, err
+		}
+	}
+}
+
+// eventTime returns the time of an lsb.events or lsb.stream record, the
+// field after the quoted event type and version
+func eventTime(line []byte) (int64, bool) {
+	i := 0
+	for field := 0; field < 2; field++ {
+		for i < len(line) && line[i] == ' ' {
+			i++
+		}
+		if i == len(line) || line[i] != '"' {
+			return 0, false
+		}
+		end := bytes.IndexByte(line[i+1:], '"')
+		if end < 0 {
+			return 0, false
+		}
+		i += end + 2
+	}
+	for i < len(line) && line[i] == ' ' {
+		i++
+	}
+	var t int64
+	digits := 0
+	for ; i < len(line) && line[i] >= '0' && line[i] <= '9'; i++ {
+		t = t*10 + int64(line[i]-'0')
+		digits++
+	}
+	return t, digits > 0
+}
+
+// scanChunk replays the records of a chunk from since until before until,
+// returns what they say about each job and the number of records replayed
+func scanChunk(rp *recordParser, c rebuildChunk, since int64, until int64) (map[jobtable.Key]*rebuiltJob, int, error) {
+	jobs := make(map[jobtable.Key]*rebuiltJob)
+	f, err := os.Open(c.file)
+	if err != nil {
+		return jobs, 0, err
+	}
+	defer f.Close()
+
+	rr := NewRecordReader(bufio.NewReaderSize(io.NewSectionReader(f, c.from, c.to-c.from), 64<<10), maxRebuildLine)
+	records := 0
+	for {
+		line, _, err := rr.Next()
+		if err != nil {
+			if err == io.EOF {
+				err = nil
+			}
+			if len(line) == 0 {
+				return jobs, records, err
+			}
+		}
+		if t, ok := eventTime(line); !ok || t < since || t >= until {
+			continue
+		}
+		// the JSON text is only built for the events carrying properties
+		ev, ok := rp.jobInfo(c.fileType, line)
+		if !ok || ev.eventType == jobEventNone {
+			continue
+		}
+		records++
+		key := jobtable.MakeKey(0, ev.jobId, ev.jobIdx)
+		j := jobs[key]
+		if j == nil {
+			j = &rebuiltJob{state: -1}
+			jobs[key] = j
+		}
+		if state, changed := getState(&ev); changed {
+			j.state = state.state
+		}
+		switch ev.eventType {
+		case jobEventNew:
+			res, _ := rp.parse(c.fileType, line)
+			event := stringToJson(&res)
+			j.props = make([]string, len(extraFields))
+			for i, fld := range extraFields {
+				j.props[i] = getString(event, fld)
+			}
+			j.switched = false
+		case jobEventSwitch:
+			res, _ := rp.parse(c.fileType, line)
+			j.setQueue(getString(stringToJson(&res), QueueKey))
+		}
+	}
+}
+
+// extraIndex returns the index of a job property in extraFields
+func extraIndex(name string) int {
+	for i, fld := range extraFields {
+		if fld == name {
+			return i
+		}
+	}
+	return -1
+}
@@ -0,0 +1,143 @@
+package parselsb
+
+import (
+	"fmt"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
+)
+
+func streamStatus(tm int64, job int, status int) string {
+	return fmt.Sprintf("\"JOB_STATUS\" \"10.1\" %d %d %d 0 0 0.0620 %d 0 0 0 0 \"\" -1 \"\" -1 -1 0 0\n", tm, job, status, tm)
+}
+
+func streamStartAccept(tm int64, job int) string {
+	return fmt.Sprintf("\"JOB_START_ACCEPT\" \"10.1\" %d %d 16562 16562 0 \"\" -1 \"\" -1 -1\n", tm, job)
+}
+
+func streamSwitch(tm int64, job int, queue string) string {
+	return fmt.Sprintf("\"JOB_SWITCH\" \"10.1\" %d 1000 %d \"%s\" 0 \"user1\"\n", tm, job, queue)
+}
+
+// writeHistory writes the lines of a history file, returns its name
+func writeHistory(t *testing.T, dir string, name string, lines []string) string {
+	path := filepath.Join(dir, name)
+	var b []byte
+	for _, line := range lines {
+		b = append(b, line...)
+	}
+	if err := ioutil.WriteFile(path, b, 0644); err != nil {
+		t.Fatal(err)
+	}
+	return path
+}
+
+func TestRebuiltJobMerge(t *testing.T) {
+	q := extraIndex(QueueKey)
+	props := func(queue string) []string {
+		p := make([]string, len(extraFields))
+		p[q] = queue
+		return p
+	}
+	// a switch without JOB_NEW changes the queue of the earlier JOB_NEW
+	j := &rebuiltJob{state: PEND, props: props("normal")}
+	later := &rebuiltJob{state: -1}
+	later.setQueue("short")
+	j.merge(later)
+	if j.state != PEND || j.props[q] != "short" {
+		t.Fatalf("%+v", j)
+	}
+	// a later JOB_NEW replaces the properties and the switch before it
+	later = &rebuiltJob{state: RUN, props: props("night")}
+	later.setQueue("long")
+	j.merge(later)
+	if j.state != RUN || j.props[q] != "long" || j.switched {
+		t.Fatalf("%+v", j)
+	}
+	// of two switches without JOB_NEW the later wins
+	j = &rebuiltJob{state: -1}
+	j.setQueue("x")
+	later = &rebuiltJob{state: -1}
+	later.setQueue("y")
+	j.merge(later)
+	if j.props != nil || j.queue != "y" || !j.switched {
+		t.Fatalf("%+v", j)
+	}
+}
+
+// Two chunks seeing the same jobs merge into what the whole file says:
+// the later chunk wins the state and the queue
+func TestRebuildMergeOrder(t *testing.T) {
+	dir, err := ioutil.TempDir("", "rebuild")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	tm := int64(1500000000)
+	first := []string{
+		streamStatus(tm, 1, jobStatPend),
+		streamStartAccept(tm+1, 2),
+		streamSwitch(tm+2, 3, "short"),
+		streamStatus(tm+3, 5, jobStatDone),
+	}
+	second := []string{
+		streamStartAccept(tm+4, 1),
+		streamSwitch(tm+5, 3, "long"),
+		streamStatus(tm+6, 4, jobStatPsusp),
+		streamStatus(tm+7, 5, jobStatPend),
+	}
+	file := writeHistory(t, dir, "lsb.stream", append(append([]string(nil), first...), second...))
+	split := int64(0)
+	for _, line := range first {
+		split += int64(len(line))
+	}
+	info, err := os.Stat(file)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	rp := new(recordParser)
+	whole, n, err := scanChunk(rp, rebuildChunk{file: file, fileType: StreamFile, from: 0, to: info.Size()}, 0, tm+100)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if n == 0 {
+		t.Skip("no LSF stream library, set LSF_STREAM_LIBRARY")
+	}
+	var results []map[jobtable.Key]*rebuiltJob
+	records := 0
+	for _, c := range []rebuildChunk{
+		{file: file, fileType: StreamFile, from: 0, to: split},
+		{file: file, fileType: StreamFile, from: split, to: info.Size()},
+	} {
+		jobs, n, err := scanChunk(rp, c, 0, tm+100)
+		if err != nil {
+			t.Fatal(err)
+		}
+		results = append(results, jobs)
+		records += n
+	}
+	merged := mergeRebuilt(results)
+	if records != n || len(merged) != len(whole) {
+		t.Fatalf("%d records of %d jobs, want %d of %d", records, len(merged), n, len(whole))
+	}
+
+	for job, want := range map[int]rebuiltJob{
+		1: {state: RUN},
+		2: {state: RUN},
+		3: {state: -1, queue: "long", switched: true},
+		4: {state: PSUSP},
+		5: {state: PEND},
+	} {
+		k := jobtable.MakeKey(0, job, 0)
+		for name, jobs := range map[string]map[jobtable.Key]*rebuiltJob{"merged": merged, "whole": whole} {
+			got := jobs[k]
+			if got == nil || got.state != want.state || got.queue != want.queue || got.switched != want.switched {
+				t.Fatalf("%s: job %d is %+v, want %+v", name, job, got, want)
+			}
+		}
+	}
+}
@@ -22,6 +22,54 @@ const (
 	EXIT
 )
 
+// kinds of job event, as enum lsbJobEvent of lsbevent_parse.h
+const (
+	jobEventNone = iota
+	jobEventNew
+	jobEventStart
+	jobEventStartAccept
+	jobEventStatus
+	jobEventStatus2
+	jobEventSwitch
+	jobEventMove
+	jobEventSignal
+	jobEventRequeue
+	jobEventForce
+	jobEventFinish
+)
+
+// LSF job status bits, JOB_STAT_* of lsbatch.h
+const (
+	jobStatNull  = 0x00
+	jobStatPend  = 0x01
+	jobStatPsusp = 0x02
+	jobStatRun   = 0x04
+	jobStatSsusp = 0x08
+	jobStatUsusp = 0x10
+	jobStatExit  = 0x20
+	jobStatDone  = 0x40
+	jobStatPdone = 0x80
+	jobStatPerr  = 0x100
+	jobStatWait  = 0x200
+	jobStatUnkwn = 0x10000
+)
+
+// jobEvent is the typed view of a record the status tracker works on,
+// filled by the C parser along with the JSON text
+type jobEvent struct {
+	eventType int
+	jobId     int
+	jobIdx    int
+	// JOB_STAT_* bits, 0 if the event carries no status
+	status     int
+	exitStatus int
+	exitInfo   int
+	// read from lsb.acct
+	acct bool
+	// cluster_name of the record, set per topic as add_fields may add it
+	cluster string
+}
+
 type stateWithReason struct {
 	state  int
 	reason string
@@ -36,9 +84,6 @@ type stateMessage struct {
 	reason       string
 }
 
-// get static state and reason
-var eventStateMapping map[string]stateWithReason
-
 var stateNameMapping map[int]string
 
 var exitReason map[int]string
@@ -46,15 +91,85 @@ var exitReason map[int]string
 var jobPropertyMapping map[string](map[string]string)
 
 func init() {
-	initEventStateMapping()
 	initStateNameMapping()
 	initExitReasonMapping()
 }
 
-func initEventStateMapping() {
-	eventStateMapping = make(map[string]stateWithReason)
-	eventStateMapping["JOB_NEW"] = stateWithReason{state: PEND, reason: "new job submitted"}
-	eventStateMapping["JOB_START_ACCEPT"] = stateWithReason{state: RUN, reason: "job starts"}
+// fromStatus and noChange stand for the state of a transition taken from
+// the JOB_STAT_* bits of the event, and for an event leaving the state alone
+const (
+	fromStatus = -1
+	noChange   = -2
+)
+
+// transition says how an event moves a job
+type transition struct {
+	state  int
+	reason string
+	// JOB_STAT_* bits of the event the transition is for, any if 0
+	status int
+	// give the exit reason of a finished job
+	exit bool
+	// only for events of lsb.acct
+	acct bool
+}
+
+// transitions of a job by kind of event, the first matching the status of
+// the event applies. Kinds without transitions leave the state alone.
+var transitions = [...][]transition{
+	jobEventNew: {
+		{state: PSUSP, reason: "new job submitted on hold", status: jobStatPsusp},
+		{state: PEND, reason: "new job submitted"},
+	},
+	// chunk job members are dispatched to wait for their turn
+	jobEventStart: {
+		{state: WAIT, status: jobStatRun | jobStatWait},
+		{state: noChange},
+	},
+	jobEventStartAccept: {{state: RUN, reason: "job starts"}},
+	jobEventStatus:      {{state: fromStatus, exit: true}},
+	// the lsb.status snapshot of the job
+	jobEventStatus2: {{state: fromStatus}},
+	jobEventRequeue: {{state: PEND, reason: "job requeued"}},
+	jobEventForce:   {{state: RUN, reason: "job forced to run"}},
+	// lsb.stream and lsb.events log JOB_FINISH after the JOB_STATUS which
+	// finished the job, only lsb.acct has no JOB_STATUS
+	jobEventFinish: {
+		{state: fromStatus, exit: true, acct: true},
+		{state: noChange},
+	},
+	// signals only request a change, which mbatchd logs as JOB_STATUS
+	// once done; switch and move keep the state of the job
+	jobEventSignal: {{state: noChange}},
+	jobEventSwitch: {{state: noChange}},
+	jobEventMove:   {{state: noChange}},
+}
+
+// statusState is the state named by JOB_STAT_* bits, exit if a finished
+// job gets its exit reason
+type statusState struct {
+	state int
+	exit  bool
+}
+
+// states of the JOB_STAT_* bits, as transformJstatus of the parser names
+// them; other combinations are ERROR
+var jobStatStates = map[int]statusState{
+	jobStatPend:                {state: PEND},
+	jobStatPsusp:               {state: PSUSP},
+	jobStatRun:                 {state: RUN},
+	jobStatSsusp:               {state: SSUSP},
+	jobStatUsusp:               {state: USUSP},
+	jobStatWait:                {state: WAIT},
+	jobStatRun | jobStatWait:   {state: WAIT},
+	jobStatExit:                {state: EXIT, exit: true},
+	jobStatDone:                {state: DONE, exit: true},
+	jobStatPdone:               {state: PDONE, exit: true},
+	jobStatPerr:                {state: PERR, exit: true},
+	jobStatUnkwn:               {state: UNKWN, exit: true},
+	jobStatDone | jobStatPdone: {state: DONE_PDONE, exit: true},
+	jobStatDone | jobStatWait:  {state: DONE_WAIT, exit: true},
+	jobStatDone | jobStatPerr:  {state: DONE_PERR, exit: true},
 }
 
 func initStateNameMapping() {
@@ -120,65 +235,49 @@ func getStateName(enum int) string {
 	}
 }
 
-func getExitReason(event map[string]interface{}) string {
-	eventType := getString(event, "event_type")
-	if eventType == "JOB_STATUS" {
-		exitStatus := getInt(event, "exit_status")
-		exitInfo := getInt(event, "exit_info")
-		if exitStatus > 0 && exitInfo >= 0 && exitInfo <= 26 {
-			if val, ok := exitReason[exitInfo]; ok {
-				return val
-			}
+func getExitReason(ev *jobEvent) string {
+	if ev.exitStatus > 0 && ev.exitInfo >= 0 && ev.exitInfo <= 26 {
+		if val, ok := exitReason[ev.exitInfo]; ok {
+			return val
 		}
 	}
 
 	return ""
 }
 
-func getState(event map[string]interface{}) *stateWithReason {
-	eventType := getString(event, "event_type")
-	if val, ok := eventStateMapping[eventType]; ok {
-		return &val
+// getState returns the state an event moves its job to, false if the
+// event does not change the state
+func getState(ev *jobEvent) (stateWithReason, bool) {
+	if ev.eventType <= jobEventNone || ev.eventType >= len(transitions) {
+		return stateWithReason{}, false
 	}
-
-	if eventType == "JOB_STATUS" {
-		status := getString(event, "job_status")
-		exitReason := getExitReason(event)
-		switch status {
-		case "DONE":
-			return &stateWithReason{state: DONE, reason: exitReason}
-		case "EXIT":
-			return &stateWithReason{state: EXIT, reason: exitReason}
-		case "PEND":
-			return &stateWithReason{state: PEND}
-		case "PSUSP":
-			return &stateWithReason{state: PSUSP}
-		case "RUN":
-			return &stateWithReason{state: RUN}
-		case "SSUSP":
-			return &stateWithReason{state: SSUSP}
-		case "USUSP":
-			return &stateWithReason{state: USUSP}
-		case "PDONE":
-			return &stateWithReason{state: PDONE, reason: exitReason}
-		case "PERR":
-			return &stateWithReason{state: PERR, reason: exitReason}
-		case "WAIT":
-			return &stateWithReason{state: WAIT}
-		case "UNKWN":
-			return &stateWithReason{state: UNKWN, reason: exitReason}
-		case "DONE+PDONE":
-			return &stateWithReason{state: DONE_PDONE, reason: exitReason}
-		case "DONE+WAIT":
-			return &stateWithReason{state: DONE_WAIT, reason: exitReason}
-		case "DONE+PERR":
-			return &stateWithReason{state: DONE_PERR, reason: exitReason}
-		case "ERROR":
-			return &stateWithReason{state: ERROR, reason: exitReason}
-		default:
-			logp.Err("Unsupported job status - %s", status)
+	for _, tr := range transitions[ev.eventType] {
+		if tr.status != 0 && tr.status != ev.status || tr.acct && !ev.acct {
+			continue
+		}
+		switch tr.state {
+		case noChange:
+			return stateWithReason{}, false
+		case fromStatus:
+			return getStatusState(ev, tr.exit)
 		}
+		return stateWithReason{state: tr.state, reason: tr.reason}, true
 	}
+	return stateWithReason{}, false
+}
 
-	return nil
+// getStatusState returns the state of the JOB_STAT_* bits of an event
+func getStatusState(ev *jobEvent, exit bool) (stateWithReason, bool) {
+	if ev.status == jobStatNull {
+		logp.Err("Unsupported job status - %d", ev.status)
+		return stateWithReason{}, false
+	}
+	st, ok := jobStatStates[ev.status]
+	if !ok {
+		st = statusState{state: ERROR, exit: true}
+	}
+	if exit && st.exit {
+		return stateWithReason{state: st.state, reason: getExitReason(ev)}, true
+	}
+	return stateWithReason{state: st.state}, true
 }
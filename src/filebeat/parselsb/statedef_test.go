@@ -0,0 +1,96 @@
+package parselsb
+
+import (
+	"testing"
+
+	"github.com/elastic/beats/filebeat/parselsb/jobtable"
+)
+
+func TestGetState(t *testing.T) {
+	for _, c := range []struct {
+		name    string
+		ev      jobEvent
+		state   int
+		reason  string
+		changed bool
+	}{
+		{"new", jobEvent{eventType: jobEventNew}, PEND, "new job submitted", true},
+		{"new on hold", jobEvent{eventType: jobEventNew, status: jobStatPsusp}, PSUSP, "new job submitted on hold", true},
+		{"start", jobEvent{eventType: jobEventStart, status: jobStatRun}, 0, "", false},
+		{"start of chunk member", jobEvent{eventType: jobEventStart, status: jobStatRun | jobStatWait}, WAIT, "", true},
+		{"start accept", jobEvent{eventType: jobEventStartAccept}, RUN, "job starts", true},
+		{"status pend", jobEvent{eventType: jobEventStatus, status: jobStatPend}, PEND, "", true},
+		{"status ususp", jobEvent{eventType: jobEventStatus, status: jobStatUsusp}, USUSP, "", true},
+		{"status exit", jobEvent{eventType: jobEventStatus, status: jobStatExit, exitStatus: 256, exitInfo: 14}, EXIT, "job killed by owner TERM_OWNER", true},
+		{"status exit without exit status", jobEvent{eventType: jobEventStatus, status: jobStatExit, exitInfo: 14}, EXIT, "", true},
+		{"status done pdone", jobEvent{eventType: jobEventStatus, status: jobStatDone | jobStatPdone}, DONE_PDONE, "", true},
+		{"status unknown bits", jobEvent{eventType: jobEventStatus, status: jobStatRun | jobStatExit}, ERROR, "", true},
+		{"status null", jobEvent{eventType: jobEventStatus}, 0, "", false},
+		{"status2 ssusp", jobEvent{eventType: jobEventStatus2, status: jobStatSsusp}, SSUSP, "", true},
+		{"status2 exit has no reason", jobEvent{eventType: jobEventStatus2, status: jobStatExit, exitStatus: 256, exitInfo: 14}, EXIT, "", true},
+		{"switch", jobEvent{eventType: jobEventSwitch}, 0, "", false},
+		{"move", jobEvent{eventType: jobEventMove}, 0, "", false},
+		{"signal", jobEvent{eventType: jobEventSignal}, 0, "", false},
+		{"requeue", jobEvent{eventType: jobEventRequeue}, PEND, "job requeued", true},
+		{"force", jobEvent{eventType: jobEventForce}, RUN, "job forced to run", true},
+		{"finish", jobEvent{eventType: jobEventFinish, status: jobStatDone}, 0, "", false},
+		{"finish of lsb.acct", jobEvent{eventType: jobEventFinish, status: jobStatDone, acct: true}, DONE, "", true},
+		{"finish of lsb.acct exit", jobEvent{eventType: jobEventFinish, status: jobStatExit, exitStatus: 256, exitInfo: 5, acct: true}, EXIT, "job killed after reaching LSF run time limit TERM_RUNLIMIT", true},
+		{"none", jobEvent{eventType: jobEventNone}, 0, "", false},
+		{"out of range", jobEvent{eventType: len(transitions)}, 0, "", false},
+	} {
+		got, changed := getState(&c.ev)
+		if changed != c.changed || changed && (got.state != c.state || got.reason != c.reason) {
+			t.Fatalf("%s: got %v %q %v, want %v %q %v", c.name, got.state, got.reason, changed, c.state, c.reason, c.changed)
+		}
+	}
+}
+
+// A job through its life: the routing key of each status message, none
+// for events leaving the state alone
+func TestProcessJobEventSequence(t *testing.T) {
+	mt := &mapTransfer{jobs: jobtable.New(0, len(extraFields)), encoders: make(map[string]*statusEncoder),
+		propBuf: make([]uint32, 0, len(extraFields)), valBuf: make([]string, 0, len(extraFields))}
+	topic := &Topic{TopicName: "status", Type: "job.status.trace", RoutingKeys: []string{QueueKey, CurStatusKey}}
+	ev := func(kind int, status int) *jobEvent {
+		return &jobEvent{eventType: kind, jobId: 7, status: status, cluster: "cluster1"}
+	}
+	exit := ev(jobEventStatus, jobStatExit)
+	exit.exitStatus, exit.exitInfo = 256, 14
+	acct := ev(jobEventFinish, jobStatDone)
+	acct.acct = true
+	for i, step := range []struct {
+		ev    *jobEvent
+		event map[string]interface{}
+		route string
+	}{
+		{ev(jobEventNew, jobStatPsusp), map[string]interface{}{QueueKey: "normal", "user_name": "user1"}, "normal.PSUSP"},
+		{ev(jobEventStatus, jobStatPend), nil, "normal.PEND"},
+		{ev(jobEventSwitch, 0), map[string]interface{}{QueueKey: "short"}, ""},
+		{ev(jobEventMove, 0), nil, ""},
+		{ev(jobEventForce, 0), nil, "short.RUN"},
+		{ev(jobEventSignal, 0), nil, ""},
+		{ev(jobEventRequeue, 0), nil, "short.PEND"},
+		{ev(jobEventStart, jobStatRun|jobStatWait), nil, "short.WAIT"},
+		{ev(jobEventStart, jobStatRun), nil, ""},
+		{ev(jobEventStartAccept, 0), nil, "short.RUN"},
+		{ev(jobEventStatus2, jobStatSsusp), nil, "short.SSUSP"},
+		{ev(jobEventStatus2, jobStatSsusp), nil, ""},
+		{exit, nil, "short.EXIT"},
+		// the finished job is dropped with its properties
+		{ev(jobEventStatus, jobStatExit), nil, ".EXIT"},
+		{ev(jobEventFinish, jobStatDone), nil, ""},
+		{acct, nil, ".DONE"},
+	} {
+		if step.event == nil {
+			step.event = map[string]interface{}{}
+		}
+		route := ""
+		if m := mt.processJobEvent(step.ev, step.event, topic); m != nil {
+			route = m.RoutingKey
+		}
+		if route != step.route {
+			t.Fatalf("step %d: routing key %q, want %q", i, route, step.route)
+		}
+	}
+}
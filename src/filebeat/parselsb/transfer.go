@@ -1,7 +1,8 @@
 package parselsb
 
 type StateHandler interface {
-	processJobEvent(event map[string]interface{}, topic *Topic) *MessageWithTopic
+	processJobEvent(ev *jobEvent, event map[string]interface{}, topic *Topic) *MessageWithTopic
+	rebuildStates(topics []Topic, event map[string]interface{})
 	registerSyncTask()
 	stopSyncTask()
 }
@@ -0,0 +1,500 @@
+/************************************************************************
+ *
+ * EVENT REC
+ *
+ * event_rec.c -- 2026-10-19
+ *
+ * Per thread parser context: reusable struct eventRec for
+ * lsb_geteventrecbyline(), release of the members it allocates, and
+ * scratch arrays kept at their high-water mark.
+ *
+ * EXPORTED ROUTINES:
+ *
+ * getParseCtx() - per thread parser context.
+ * reserveHostScratch() - grow the exec host scratch arrays.
+ * resetParseCtx() - reset the context between records.
+ * resetEventRec() - free LSF allocated members and clear the record.
+ *
+ ************************************************************************/
+
+#include "event_rec.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(WIN32)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+#define FREEUP(pointer)                                                        \
+  if (pointer != NULL) {                                                       \
+    free(pointer);                                                             \
+    pointer = NULL;                                                            \
+  }
+
+/*
+ * Record string members. Depending on the LSF version lsbatch.h declares
+ * names such as userName, queue or cwd as fixed arrays inside the record,
+ * those are skipped; the record is zeroed by resetEventRec() afterwards.
+ */
+#define FREEMEMBER(member)                                                     \
+  if ((void *) (member) != (void *) &(member)) {                               \
+    free((void *) (member));                                                   \
+  }
+
+static THREAD_LOCAL struct parseCtx *threadCtx = NULL;
+
+static void freeStrArray(char **array, int num) {
+	int i;
+
+	if (array == NULL) {
+		return;
+	}
+	for (i = 0; i < num; i++) {
+		FREEUP(array[i]);
+	}
+	free(array);
+}
+
+static void freeXFiles(struct xFile *xf, int nxf) {
+	int i;
+
+	if (xf == NULL) {
+		return;
+	}
+	for (i = 0; i < nxf; i++) {
+		FREEMEMBER(xf[i].subFn);
+		FREEMEMBER(xf[i].execFn);
+	}
+	free(xf);
+}
+
+#if defined(LSF8) || defined(LSF9) || defined(LSF10)
+static void freeHRusages(struct hRusage *hostRusage, int num) {
+	int i;
+
+	if (hostRusage == NULL) {
+		return;
+	}
+	for (i = 0; i < num; i++) {
+		FREEMEMBER(hostRusage[i].name);
+	}
+	free(hostRusage);
+}
+#endif
+
+static void freeJRusage(struct jRusage *jrusage) {
+	FREEUP(jrusage->pidInfo);
+	FREEUP(jrusage->pgid);
+}
+
+static void freeJobNew(struct jobNewLog *l) {
+	FREEMEMBER(l->userName);
+	FREEMEMBER(l->hostSpec);
+	FREEMEMBER(l->queue);
+	FREEMEMBER(l->resReq);
+	FREEMEMBER(l->fromHost);
+	FREEMEMBER(l->cwd);
+#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
+	FREEMEMBER(l->subcwd);
+#endif
+	FREEMEMBER(l->chkpntDir);
+	FREEMEMBER(l->inFile);
+	FREEMEMBER(l->outFile);
+	FREEMEMBER(l->errFile);
+	FREEMEMBER(l->inFileSpool);
+	FREEMEMBER(l->commandSpool);
+	FREEMEMBER(l->jobSpoolDir);
+	FREEMEMBER(l->subHomeDir);
+	FREEMEMBER(l->jobFile);
+	freeStrArray(l->askedHosts, l->numAskedHosts);
+	FREEMEMBER(l->dependCond);
+	FREEMEMBER(l->timeEvent);
+	FREEMEMBER(l->jobName);
+	FREEMEMBER(l->command);
+	freeXFiles(l->xf, l->nxf);
+	FREEMEMBER(l->preExecCmd);
+	FREEMEMBER(l->mailUser);
+	FREEMEMBER(l->projectName);
+	FREEMEMBER(l->schedHostType);
+	FREEMEMBER(l->loginShell);
+	FREEMEMBER(l->userGroup);
+	FREEMEMBER(l->exceptList);
+	FREEMEMBER(l->rsvId);
+	FREEMEMBER(l->jobGroup);
+	FREEMEMBER(l->extsched);
+	FREEMEMBER(l->warningAction);
+	FREEMEMBER(l->sla);
+	FREEMEMBER(l->licenseProject);
+#if !defined(LSF6)
+	FREEMEMBER(l->app);
+	FREEMEMBER(l->postExecCmd);
+	FREEMEMBER(l->requeueEValues);
+#endif
+#if defined(LSF8) || defined(LSF9) || defined(LSF10)
+	FREEMEMBER(l->jobDescription);
+#endif
+#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
+	FREEMEMBER(l->srcCluster);
+#if !defined(LSF6)
+	FREEMEMBER(l->flow_id);
+#endif
+#endif
+}
+
+static void freeJobMod(struct jobModLog *l) {
+	FREEMEMBER(l->jobIdStr);
+	FREEMEMBER(l->userName);
+	FREEMEMBER(l->jobName);
+	FREEMEMBER(l->queue);
+	freeStrArray(l->askedHosts, l->numAskedHosts);
+	FREEMEMBER(l->resReq);
+	FREEMEMBER(l->hostSpec);
+	FREEMEMBER(l->dependCond);
+	FREEMEMBER(l->timeEvent);
+	FREEMEMBER(l->subHomeDir);
+	FREEMEMBER(l->inFile);
+	FREEMEMBER(l->outFile);
+	FREEMEMBER(l->errFile);
+	FREEMEMBER(l->command);
+	FREEMEMBER(l->inFileSpool);
+	FREEMEMBER(l->commandSpool);
+	FREEMEMBER(l->chkpntDir);
+	freeXFiles(l->xf, l->nxf);
+	FREEMEMBER(l->jobFile);
+	FREEMEMBER(l->fromHost);
+	FREEMEMBER(l->cwd);
+	FREEMEMBER(l->preExecCmd);
+	FREEMEMBER(l->mailUser);
+	FREEMEMBER(l->projectName);
+	FREEMEMBER(l->loginShell);
+	FREEMEMBER(l->schedHostType);
+	FREEMEMBER(l->userGroup);
+	FREEMEMBER(l->exceptList);
+	FREEMEMBER(l->rsvId);
+	FREEMEMBER(l->extsched);
+	FREEMEMBER(l->warningAction);
+	FREEMEMBER(l->jobGroup);
+	FREEMEMBER(l->sla);
+	FREEMEMBER(l->licenseProject);
+#if !defined(LSF6)
+	FREEMEMBER(l->app);
+	FREEMEMBER(l->apsString);
+	FREEMEMBER(l->postExecCmd);
+#endif
+}
+
+static void freeJobStart(struct jobStartLog *l) {
+	freeStrArray(l->execHosts, l->numExHosts);
+	FREEMEMBER(l->queuePreCmd);
+	FREEMEMBER(l->queuePostCmd);
+	FREEMEMBER(l->userGroup);
+	FREEMEMBER(l->additionalInfo);
+	FREEMEMBER(l->effectiveResReq);
+#if defined(LSF10)
+	freeStrArray(l->allocSlots, l->numAllocSlots);
+#endif
+}
+
+static void freeJobFinish(struct jobFinishLog *l) {
+	FREEMEMBER(l->userName);
+	FREEMEMBER(l->queue);
+	FREEMEMBER(l->resReq);
+	FREEMEMBER(l->fromHost);
+	FREEMEMBER(l->cwd);
+#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
+	FREEMEMBER(l->subcwd);
+#endif
+	FREEMEMBER(l->inFile);
+	FREEMEMBER(l->outFile);
+	FREEMEMBER(l->errFile);
+	FREEMEMBER(l->inFileSpool);
+	FREEMEMBER(l->commandSpool);
+	FREEMEMBER(l->jobFile);
+	freeStrArray(l->askedHosts, l->numAskedHosts);
+	freeStrArray(l->execHosts, l->numExHosts);
+	FREEMEMBER(l->jobName);
+	FREEMEMBER(l->command);
+	FREEMEMBER(l->dependCond);
+	FREEMEMBER(l->timeEvent);
+	FREEMEMBER(l->preExecCmd);
+	FREEMEMBER(l->mailUser);
+	FREEMEMBER(l->projectName);
+	FREEMEMBER(l->loginShell);
+	FREEMEMBER(l->rsvId);
+	FREEMEMBER(l->sla);
+	FREEMEMBER(l->additionalInfo);
+	FREEMEMBER(l->warningAction);
+	FREEMEMBER(l->chargedSAAP);
+	FREEMEMBER(l->licenseProject);
+#if !defined(LSF6)
+	FREEMEMBER(l->app);
+	FREEMEMBER(l->postExecCmd);
+	FREEMEMBER(l->jgroup);
+#endif
+#if defined(LSF9) || defined(LSF10)
+	FREEMEMBER(l->effectiveResReq);
+#endif
+#if defined(LSF8) || defined(LSF9) || defined(LSF10)
+	FREEMEMBER(l->jobDescription);
+#endif
+#if !defined(LSF6) && (defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1))
+	FREEMEMBER(l->flow_id);
+#endif
+#if defined(LSF10)
+	freeHRusages(l->hostRusage, l->numhRusages);
+	freeStrArray(l->allocSlots, l->numAllocSlots);
+#endif
+}
+
+#if defined(LSF8) || defined(LSF9) || defined(LSF10)
+static void freeJobFinish2(struct jobFinish2Log *l) {
+	FREEMEMBER(l->userName);
+	FREEMEMBER(l->queue);
+	FREEMEMBER(l->resReq);
+	FREEMEMBER(l->fromHost);
+	FREEMEMBER(l->cwd);
+	FREEMEMBER(l->inFile);
+	FREEMEMBER(l->outFile);
+	FREEMEMBER(l->jobFile);
+	freeStrArray(l->execHosts, l->numExHosts);
+	FREEMEMBER(l->slotUsages);
+	FREEMEMBER(l->jobName);
+	FREEMEMBER(l->command);
+	FREEMEMBER(l->preExecCmd);
+	FREEMEMBER(l->postExecCmd);
+	FREEMEMBER(l->projectName);
+	FREEMEMBER(l->sla);
+	FREEMEMBER(l->chargedSAAP);
+	FREEMEMBER(l->licenseProject);
+	FREEMEMBER(l->app);
+	FREEMEMBER(l->jgroup);
+	FREEMEMBER(l->execRusage);
+	FREEMEMBER(l->clusterName);
+	FREEMEMBER(l->userGroup);
+#if defined(LSF10)
+	FREEMEMBER(l->jobDescription);
+	FREEMEMBER(l->requeueEValues);
+	FREEMEMBER(l->dependCond);
+	FREEMEMBER(l->rsvId);
+#endif
+#if defined(LSF9) || defined(LSF10)
+	FREEMEMBER(l->effectiveResReq);
+#endif
+#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
+	FREEMEMBER(l->flow_id);
+	FREEMEMBER(l->srcCluster);
+	FREEMEMBER(l->dstCluster);
+#endif
+	freeHRusages(l->hostRusage, l->numhRusages);
+}
+
+static void freeJobStatus2(struct jobStatus2Log *l) {
+	FREEMEMBER(l->userName);
+	FREEMEMBER(l->queue);
+	FREEMEMBER(l->resReq);
+	FREEMEMBER(l->projectName);
+	FREEMEMBER(l->jgroup);
+	freeStrArray(l->execHosts, l->numExHosts);
+	FREEMEMBER(l->slotUsages);
+	FREEMEMBER(l->app);
+	FREEMEMBER(l->execRusage);
+	FREEMEMBER(l->clusterName);
+	FREEMEMBER(l->userGroup);
+	freeHRusages(l->hostRusage, l->numhRusages);
+}
+#endif
+
+static void freeSbdUnreportedStatus(struct sbdUnreportedStatusLog *l) {
+	FREEMEMBER(l->execCwd);
+	FREEMEMBER(l->execHome);
+	FREEMEMBER(l->execUsername);
+	freeJRusage(&l->runRusage);
+}
+
+/*
+ *-----------------------------------------------------------------------
+ *
+ * resetEventRec
+ *
+ * ARGUMENTS:
+ *
+ * logrec[IN]: record filled by lsb_geteventrecbyline(), may be NULL.
+ *
+ * DESCRIPTION:
+ *
+ * Free the strings and arrays which belong to the union member selected
+ * by logrec->type, then zero the whole record so the next line starts
+ * from a clean state. Event types without heap members only get zeroed.
+ *
+ * RETURN:
+ *
+ * NULL.
+ *
+ *-----------------------------------------------------------------------
+ */
+void resetEventRec(struct eventRec *logrec) {
+	union eventLog *log;
+
+	if (logrec == NULL) {
+		return;
+	}
+	log = &logrec->eventLog;
+
+	switch (logrec->type) {
+	case EVENT_JOB_NEW:
+		freeJobNew(&log->jobNewLog);
+		break;
+	case EVENT_JOB_MODIFY2:
+		freeJobMod(&log->jobModLog);
+		break;
+	case EVENT_JOB_START:
+	case EVENT_PRE_EXEC_START:
+		freeJobStart(&log->jobStartLog);
+		break;
+	case EVENT_JOB_EXECUTE:
+		FREEMEMBER(log->jobExecuteLog.execHome);
+		FREEMEMBER(log->jobExecuteLog.execCwd);
+		FREEMEMBER(log->jobExecuteLog.execUsername);
+		FREEMEMBER(log->jobExecuteLog.additionalInfo);
+		FREEMEMBER(log->jobExecuteLog.execRusage);
+		break;
+	case EVENT_JOB_SWITCH:
+		FREEMEMBER(log->jobSwitchLog.queue);
+		FREEMEMBER(log->jobSwitchLog.userName);
+		break;
+	case EVENT_JOB_MOVE:
+		FREEMEMBER(log->jobMoveLog.userName);
+		break;
+	case EVENT_JOB_FINISH:
+		freeJobFinish(&log->jobFinishLog);
+		break;
+#if defined(LSF8) || defined(LSF9) || defined(LSF10)
+	case EVENT_JOB_FINISH2:
+		freeJobFinish2(&log->jobFinish2Log);
+		break;
+	case EVENT_JOB_STARTLIMIT:
+		FREEMEMBER(log->jobStartLimitLog.clusterName);
+		break;
+	case EVENT_JOB_STATUS2:
+		freeJobStatus2(&log->jobStatus2Log);
+		break;
+#endif
+	case EVENT_MIG:
+		freeStrArray(log->migLog.askedHosts, log->migLog.numAskedHosts);
+		FREEMEMBER(log->migLog.userName);
+		break;
+	case EVENT_JOB_SIGNAL:
+		FREEMEMBER(log->signalLog.signalSymbol);
+		FREEMEMBER(log->signalLog.userName);
+		break;
+	case EVENT_JOB_FORWARD:
+		FREEMEMBER(log->jobForwardLog.cluster);
+		freeStrArray(log->jobForwardLog.reserHosts,
+				log->jobForwardLog.numReserHosts);
+		break;
+	case EVENT_JOB_ACCEPT:
+		FREEMEMBER(log->jobAcceptLog.cluster);
+		break;
+	case EVENT_JOB_SIGACT:
+		FREEMEMBER(log->sigactLog.signalSymbol);
+		break;
+	case EVENT_JOB_EXT_MSG:
+	case EVENT_JOB_ATTA_DATA:
+		FREEMEMBER(log->jobExternalMsgLog.desc);
+		FREEMEMBER(log->jobExternalMsgLog.fileName);
+		FREEMEMBER(log->jobExternalMsgLog.userName);
+		break;
+	case EVENT_JOB_CHUNK:
+		FREEMEMBER(log->jobChunkLog.membJobId);
+		freeStrArray(log->jobChunkLog.execHosts,
+				(int) log->jobChunkLog.numExHosts);
+		break;
+	case EVENT_SBD_UNREPORTED_STATUS:
+		freeSbdUnreportedStatus(&log->sbdUnreportedStatusLog);
+		break;
+	case EVENT_JOB_FORCE:
+		freeStrArray(log->jobForceRequestLog.execHosts,
+				log->jobForceRequestLog.numExecHosts);
+		FREEMEMBER(log->jobForceRequestLog.userName);
+		FREEMEMBER(log->jobForceRequestLog.queue);
+		break;
+	case EVENT_JOB_RUN_RUSAGE:
+		freeJRusage(&log->jobRunRusageLog.jrusage);
+		break;
+	default:
+		break;
+	}
+
+	memset(logrec, 0, sizeof(struct eventRec));
+}
+
+struct parseCtx *getParseCtx(void) {
+	if (threadCtx == NULL) {
+		threadCtx = (struct parseCtx *) calloc(1, sizeof(struct parseCtx));
+	}
+	return threadCtx;
+}
+
+/*
+ *-----------------------------------------------------------------------
+ *
+ * reserveHostScratch
+ *
+ * ARGUMENTS:
+ *
+ * ctx[IN]: parser context.
+ * num[IN]: number of entries needed.
+ *
+ * DESCRIPTION:
+ *
+ * Grow ctx->hosts and ctx->slots to hold num entries. Capacity only
+ * grows (doubling), so after a few records no allocation is needed.
+ * The contents are not preserved.
+ *
+ * RETURN:
+ *
+ * 0 on success, -1 on failure.
+ *
+ *-----------------------------------------------------------------------
+ */
+int reserveHostScratch(struct parseCtx *ctx, int num) {
+	int size;
+
+	if (ctx == NULL || num < 0) {
+		return -1;
+	}
+	if (num <= ctx->numScratch) {
+		return 0;
+	}
+
+	size = ctx->numScratch > 0 ? ctx->numScratch : 64;
+	while (size < num) {
+		size *= 2;
+	}
+	FREEUP(ctx->hosts);
+	FREEUP(ctx->slots);
+	ctx->numScratch = 0;
+	ctx->hosts = (char **) malloc(size * sizeof(char *));
+	ctx->slots = (int *) malloc(size * sizeof(int));
+	if (ctx->hosts == NULL || ctx->slots == NULL) {
+		FREEUP(ctx->hosts);
+		FREEUP(ctx->slots);
+		return -1;
+	}
+	ctx->numScratch = size;
+	return 0;
+}
+
+void resetParseCtx(struct parseCtx *ctx) {
+	if (ctx == NULL) {
+		return;
+	}
+	resetEventRec(&ctx->logrec);
+	if (ctx->numScratch > PARSE_CTX_MAX_KEEP) {
+		FREEUP(ctx->hosts);
+		FREEUP(ctx->slots);
+		ctx->numScratch = 0;
+	}
+}
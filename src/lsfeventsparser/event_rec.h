@@ -0,0 +1,64 @@
+/************************************************************************
+ *
+ * EVENT REC
+ *
+ * event_rec.h -- 2026-10-19
+ *
+ * Per thread parser context and ownership of the struct eventRec filled
+ * by lsb_geteventrecbyline().
+ *
+ * Each thread keeps one context and reuses it for every line: the event
+ * record, plus scratch arrays the parser needs per record, which are
+ * kept at their high-water mark instead of being allocated each time.
+ * lsb_geteventrecbyline() allocates the strings and arrays hanging off
+ * the record; resetEventRec() releases them and clears the record so it
+ * is ready for the next line.
+ *
+ ************************************************************************/
+
+#ifndef _EVENT_REC_H_
+#define _EVENT_REC_H_
+
+#include "lsbatch.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scratch arrays above this many entries are released by resetParseCtx()
+// instead of being kept for the next record.
+#define PARSE_CTX_MAX_KEEP 4096
+
+struct parseCtx {
+  // reusable record for lsb_geteventrecbyline()
+  struct eventRec logrec;
+
+  // distinct exec host names of the current record, borrowed from logrec
+  char **hosts;
+  // slot count per entry of hosts
+  int *slots;
+  // capacity of hosts and slots
+  int numScratch;
+};
+
+// Return the calling thread's parser context, allocated on first use.
+// Returns NULL if out of memory.
+struct parseCtx *getParseCtx(void);
+
+// Make sure ctx->hosts and ctx->slots hold at least num entries.
+// Returns 0 on success, -1 if out of memory.
+int reserveHostScratch(struct parseCtx *ctx, int num);
+
+// Reset the context between records: release the record members and
+// drop scratch arrays grown beyond PARSE_CTX_MAX_KEEP.
+void resetParseCtx(struct parseCtx *ctx);
+
+// Free the members LSF allocated for logrec->type and zero the record.
+// The record itself is kept.
+void resetEventRec(struct eventRec *logrec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -122,8 +122,7 @@ void addStringToObject(Json4c *object, const char *key, char *value) {
 		return;
 	}
 
-    char *str = strreplace(value, "\"", "\\\"");
-//    str = strreplace(str, "\'", "\\\'");
+    char *str = jsonEscape(value);
 
 	ksnprintf(&string->key, "%s", key);
 	ksnprintf(&string->valuestring, "%s", str);
@@ -132,6 +131,24 @@ void addStringToObject(Json4c *object, const char *key, char *value) {
 	free(str);
 }
 
+// Add an already escaped string to a JSON object, the value is not copied
+void addReferenceToObject(Json4c *object, const char *key, const char *value) {
+	if (!object || !key || !value) {
+		return;
+	}
+
+	Json4c *string = createString();
+	if (!string) {
+		return;
+	}
+
+	ksnprintf(&string->key, "%s", key);
+	string->valuestring = (char *) value;
+	string->isReference = 1;
+
+	addChild(object, string);
+}
+
 void addInstanceToObject(Json4c *object, const char *key, Json4c *instance) {
 	if (!object || !key || !instance) {
 		return;
@@ -287,7 +304,9 @@ void stringFree(Json4c *string) {
 	}
 
 	FREEUP(string->key);
-	FREEUP(string->valuestring);
+	if (!string->isReference) {
+		FREEUP(string->valuestring);
+	}
 	FREEUP(string);
 }
 
@@ -487,6 +506,7 @@ int isInteger(double num) {
 	}
 }
 
+#if defined(JSON4C_MAIN)
 int main() {
 	Json4c *test1 = jCreateArray();
 	Json4c *test = jCreateObject();
@@ -499,3 +519,4 @@ int main() {
 	free(buffer);
 	return 1;
 }
+#endif
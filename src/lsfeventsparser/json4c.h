@@ -50,6 +50,10 @@ typedef struct Json4c {
   // pointer
   // should be NULL.
   struct Json4c *valuechild;
+
+  // Non-zero if valuestring is borrowed (e.g. from the name intern table)
+  // and must not be freed together with this instance.
+  int isReference;
 } Json4c;
 
 // To JSON String
@@ -71,6 +75,9 @@ Json4c *jCreateArray();
 void addNumberToObject(Json4c *object, const char *key, double value);
 void addStringToObject(Json4c *object, const char *key, char *value);
 void addInstanceToObject(Json4c *object, const char *key, Json4c *instance);
+// Add an already escaped string without copying it. The value must outlive
+// the object.
+void addReferenceToObject(Json4c *object, const char *key, const char *value);
 void addNumberToArray(Json4c *array, double value);
 void addStringToArray(Json4c *array, char *value);
 void addInstanceToArray(Json4c *array, Json4c *instance);
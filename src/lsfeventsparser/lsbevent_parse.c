@@ -29,6 +29,8 @@
 
 #include "lsbevent_parse.h"
 #include "json4c.h"
+#include "name_intern.h"
+#include "event_rec.h"
 #include "job_array.h"
 #include "lsbatch.h"
 #include <math.h>
@@ -39,6 +41,8 @@
 #include <time.h>
 #if defined(WIN32)
 #include <windows.h>
+#else
+#include <pthread.h>
 #endif
 #if defined(_HPUXIA64_)
 #include <dlfcn.h>
@@ -103,6 +107,49 @@ struct streamer {
 typedef struct eventRec *(*MOD_LOG_FUNCEVR)(void *);
 
 static struct streamer stream = { 0 };
+/* result of loading the stream library, see initstream() */
+static int streamStatus = -1;
+static char *streamMsg = NULL;
+#if defined(WIN32)
+static INIT_ONCE streamOnce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t streamOnce = PTHREAD_ONCE_INIT;
+#endif
+
+/*
+ * lsb_geteventrecbyline() and ls_getclustername() are not thread safe,
+ * but lsb.events and lsb.acct files are parsed from several threads
+ * during a backfill or rebuild. Calls into them are serialized by
+ * lsfLock; building the JSON stays concurrent. lsb.stream records go
+ * through lsb_readstreamlineMT() and need no lock.
+ */
+#if defined(WIN32)
+static SRWLOCK lsfLock = SRWLOCK_INIT;
+#define LSF_LOCK()   AcquireSRWLockExclusive(&lsfLock)
+#define LSF_UNLOCK() ReleaseSRWLockExclusive(&lsfLock)
+#else
+static pthread_mutex_t lsfLock = PTHREAD_MUTEX_INITIALIZER;
+#define LSF_LOCK()   pthread_mutex_lock(&lsfLock)
+#define LSF_UNLOCK() pthread_mutex_unlock(&lsfLock)
+#endif
+/* copy of ls_getclustername(), read once under lsfLock */
+static char *clusterName = NULL;
+
+/*
+ * Put a host/queue/user/project/cluster name. The same few thousand names
+ * repeat in every record, so the escaped value is taken from the process
+ * wide intern table and referenced instead of copied. Falls back to a
+ * private copy when the name cannot be interned.
+ */
+static void addNameToObject(Json4c *object, const char *key, char *name) {
+	const char *escaped = internName(name);
+
+	if (escaped) {
+		addReferenceToObject(object, key, escaped);
+	} else {
+		addStringToObject(object, key, name);
+	}
+}
 
 static char *timeConvert(long l) {
 	if (l <= 0) { // don't convert "invalid" time
@@ -160,6 +207,7 @@ static char* formatExitReason(struct jobFinish2Log *jobFinish2Log) {
 	int exitInfo = jobFinish2Log->exitInfo;
 	int exceptMask = jobFinish2Log->exceptMask;
 	int exitStatus = jobFinish2Log->exitStatus;
+	const char *maskReason = getExceptMaskReason(exceptMask);
 
 	char* exitReason = (char*)malloc(MAX_LEN);
 
@@ -174,9 +222,10 @@ static char* formatExitReason(struct jobFinish2Log *jobFinish2Log) {
 		if(exitInfo == 0 && exceptMask == 0) {
 			sprintf(exitReason, "-");
 		} else if(exitInfo > 0 && exitInfo < 30) {
-			sprintf(exitReason, sysExitInfoMapping[exitInfo]);
-		} else if(exceptMask > 0) {
-			sprintf(exitReason, getExceptMaskReason(exceptMask));
+			sprintf(exitReason, "%s", sysExitInfoMapping[exitInfo]);
+		} else if(exceptMask > 0 && maskReason != NULL) {
+			/* NULL for a mask of several or unknown exceptions */
+			sprintf(exitReason, "%s", maskReason);
 		} else if(exitStatus == 0) {
 			sprintf(exitReason, "RECALLED JOB");
 		} else if(exitStatus > 255) {
@@ -205,6 +254,10 @@ static char* formatExitReason(struct jobFinish2Log *jobFinish2Log) {
  * DESCRIPTION:
  *
  * init stream function, get function pointer from library.
+ * $LSF_STREAM_LIBRARY, when set, names the library to load instead of
+ * liblsbstream, e.g. the mock library under mock/. The library is loaded
+ * once, by the first caller, while any other caller waits for it, so no
+ * thread sees the handle before the function pointers.
  *
  * RETURN:
  *
@@ -212,34 +265,33 @@ static char* formatExitReason(struct jobFinish2Log *jobFinish2Log) {
  *
  *-----------------------------------------------------------------------
  */
-static int initstream(char **msg) {
+static void loadstream(void) {
 	void *handle;
 
-	/* only first startup to init. */
-	if (NULL != stream.handle) {
-		return 0;
-	}
-
+	stream.library = getenv("LSF_STREAM_LIBRARY");
+	if (stream.library == NULL || stream.library[0] == '\0') {
 #if defined(WIN32)
-	stream.library = "liblsbstream.dll";
+		stream.library = "liblsbstream.dll";
 #else
-	stream.library = "liblsbstream.so";
+		stream.library = "liblsbstream.so";
 #endif
+	}
 
 	/* Load the stream library from the standard
 	 * library location.
 	 */
 #if defined(WIN32)
 	handle = LoadLibrary(stream.library);
-	*msg = NULL;
 #else
 	handle = dlopen(stream.library, RTLD_LAZY);
-	*msg = dlerror();
+	if (handle == NULL && (streamMsg = dlerror()) != NULL) {
+		/* the dlerror() buffer is the loading thread's */
+		streamMsg = strdup(streamMsg);
+	}
 #endif /*WIN32*/
 	if (!handle) {
-		return -1;
+		return;
 	}
-	stream.handle = handle;
 
 #if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
 	/* check for the known symbols...
@@ -278,7 +330,9 @@ static int initstream(char **msg) {
 
 #endif /* LSB_EVENT_VERSION9_1 */
 
-	return (0);
+	stream.handle = handle;
+	streamStatus = 0;
+	return;
 
 	screwed: if (handle != NULL) {
 #if defined(WIN32)
@@ -288,8 +342,47 @@ static int initstream(char **msg) {
 #endif /*WIN32*/
 	}
 
-	return (-1);
+} /* loadstream() */
+
+#if defined(WIN32)
+static BOOL CALLBACK loadstreamOnce(PINIT_ONCE once, PVOID param, PVOID *ctx) {
+	loadstream();
+	return TRUE;
+}
+#endif
+
+static int geteventrecbyline(char *record, struct eventRec *logrec) {
+	int ret;
+
+	LSF_LOCK();
+	ret = lsb_geteventrecbyline(record, logrec);
+	LSF_UNLOCK();
+	return ret;
+}
+
+static char *getclustername(void) {
+	char *name;
 
+	LSF_LOCK();
+	if (clusterName == NULL) {
+		name = ls_getclustername();
+		if (name != NULL) {
+			clusterName = strdup(name);
+		}
+	}
+	name = clusterName;
+	LSF_UNLOCK();
+	return name;
+}
+
+static int initstream(char **msg) {
+#if defined(WIN32)
+	InitOnceExecuteOnce(&streamOnce, loadstreamOnce, NULL, NULL);
+#else
+	pthread_once(&streamOnce, loadstream);
+#endif
+	*msg = streamMsg;
+	return streamStatus;
 } /* initstream() */
 
 /*
@@ -583,7 +676,7 @@ static Json4c *getHostsHashmapArray(char *p, time_t eventTime, int jobId,
 		FREEUP(time);
 		addNumberToObject(objHost, FIELD_EVENT_TIME_UTC, (int)eventTime);
 
-		addStringToObject(objHost, FIELD_HOST_NAME, askedHosts[i]);
+		addNameToObject(objHost, FIELD_HOST_NAME, askedHosts[i]);
 
 		addNumberToObject(objHost, FIELD_JOB_ARRAY_IDX, idx);
 
@@ -636,16 +729,21 @@ static Json4c *getExecHostsHashmapArray(char *eventType, time_t eventTime,
 	int *HostSlots = NULL;
 	char *p = NULL;
 	int nHost = 0;
-	if (execHosts == NULL) {
+	struct parseCtx *ctx = getParseCtx();
+	if (execHosts == NULL || numExHosts <= 0) {
 		return NULL;
 	}
 
-	/* init RealHost array. */
-	RealHosts = calloc(numExHosts, sizeof(char *));
-	HostSlots = calloc(numExHosts, sizeof(int));
+	/* init RealHost array, reusing the per thread scratch arrays. */
+	if (reserveHostScratch(ctx, numExHosts) < 0) {
+		return NULL;
+	}
+	RealHosts = ctx->hosts;
+	HostSlots = ctx->slots;
+	memset(HostSlots, 0, numExHosts * sizeof(int));
 
-	/* copy first host to RealHost array. */
-	RealHosts[0] = strdup(execHosts[0]);
+	/* first host in RealHost array, names are borrowed from execHosts. */
+	RealHosts[0] = execHosts[0];
 	numRealHosts = 1;
 
 	found = 0;
@@ -659,7 +757,7 @@ static Json4c *getExecHostsHashmapArray(char *eventType, time_t eventTime,
 			}
 		}
 		if (0 == found) {
-			RealHosts[numRealHosts] = strdup(execHosts[i]);
+			RealHosts[numRealHosts] = execHosts[i];
 			HostSlots[numRealHosts]++;
 			numRealHosts++;
 		}
@@ -681,24 +779,17 @@ static Json4c *getExecHostsHashmapArray(char *eventType, time_t eventTime,
 		p = strchr(RealHosts[i], '*');
 		nHost = atoi(RealHosts[i]);
 		if (NULL != p && nHost > 0) {
-			addStringToObject(objHost, FIELD_HOST_NAME, p + 1);
+			addNameToObject(objHost, FIELD_HOST_NAME, p + 1);
 
 			addNumberToObject(objHost, FIELD_EXECHOST_SLOT_NUM, nHost);
 		} else {
-			addStringToObject(objHost, FIELD_HOST_NAME, RealHosts[i]);
+			addNameToObject(objHost, FIELD_HOST_NAME, RealHosts[i]);
 
 			addNumberToObject(objHost, FIELD_EXECHOST_SLOT_NUM, HostSlots[i]);
 		}
 		addInstanceToArray(execHostsArray, objHost);
 	}
 
-	/* free memory. */
-	for (j = 0; j < numRealHosts; j++) {
-		free(RealHosts[j]);
-	}
-	free(RealHosts);
-	free(HostSlots);
-
 	return execHostsArray;
 }
 
@@ -763,7 +854,7 @@ static Json4c *getJobExecHostsHashmapArray(char *eventType, time_t eventTime,
 			return NULL;
 		}
 
-		addStringToObject(objHost, FIELD_HOST_NAME, jobFinish2Log->execHosts[i]);
+		addNameToObject(objHost, FIELD_HOST_NAME, jobFinish2Log->execHosts[i]);
 
 		addNumberToObject(objHost, FIELD_EXECHOST_SLOT_NUM, jobFinish2Log->slotUsages[i]);
 
@@ -884,29 +975,26 @@ static char *getExecHostsStr(char **execHosts, int numExHosts, Json4c *objMap) {
 	char numStr[21];
 	int totalLen = 0;
 	int totalSlots = 0;
+	struct parseCtx *ctx = getParseCtx();
 
-	if (NULL == execHosts || numExHosts == 0) {
-		return NULL;
-	}
-
-	/* get TempHosts array memory. */
-	hostsTemp = (char **) malloc(numExHosts * sizeof(char *));
-	if (hostsTemp == NULL) {
+	if (NULL == execHosts || numExHosts <= 0) {
 		return NULL;
 	}
 
-	numHostsTemp = (int *) malloc(numExHosts * sizeof(int));
-	if (numHostsTemp == NULL) {
+	/* TempHosts arrays come from the per thread scratch arrays. */
+	if (reserveHostScratch(ctx, numExHosts) < 0) {
 		return NULL;
 	}
+	hostsTemp = ctx->hosts;
+	numHostsTemp = ctx->slots;
 
 	/* Initialize array of int */
 	for (i = 0; i < numExHosts; i++) {
 		numHostsTemp[i] = 1;
 	}
 
-	/* copy first host to temp array. */
-	hostsTemp[0] = strdup(execHosts[0]);
+	/* first host in temp array, names are borrowed from execHosts. */
+	hostsTemp[0] = execHosts[0];
 	totalHostsTemp = 1;
 
 	/*log_msg(env, logger, _LOG_INFO_INT_, "# of execHosts: %d", numExHosts,
@@ -920,7 +1008,7 @@ static char *getExecHostsStr(char **execHosts, int numExHosts, Json4c *objMap) {
 			}
 		}
 		if (j == totalHostsTemp) {
-			hostsTemp[totalHostsTemp] = strdup(execHosts[i]);
+			hostsTemp[totalHostsTemp] = execHosts[i];
 			totalHostsTemp++;
 		}
 	}
@@ -953,17 +1041,6 @@ static char *getExecHostsStr(char **execHosts, int numExHosts, Json4c *objMap) {
 	}
 	execHostStr[totalLen - 1] = 0x00;
 
-	/* free memory. */
-	for (i = 0; i < totalHostsTemp; i++) {
-		free(hostsTemp[i]);
-	}
-
-	if (hostsTemp != NULL) {
-		free(hostsTemp);
-	}
-
-	free(numHostsTemp);
-
 	// hashmap_put_int(env, objMap, HashMap_put, "num_exec_procs", totalSlots);
 	addNumberToObject(objMap, FIELD_NUM_EXEC_PROCESSORS, totalSlots);
 
@@ -1237,7 +1314,7 @@ static void putJobNew(Json4c *objHashMap, struct eventRec *logrec) {
 
 	addNumberToObject(objHashMap, FIELD_UID, logrec->eventLog.jobNewLog.userId);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 			logrec->eventLog.jobNewLog.userName);
 
 	addNumberToObject(objHashMap, FIELD_JOB_OPTS,
@@ -1249,6 +1326,7 @@ static void putJobNew(Json4c *objHashMap, struct eventRec *logrec) {
 	if (logrec->eventLog.jobNewLog.options2 & SUB2_HOLD) {
 		jstatsstr = transformJstatus(JOB_STAT_PSUSP);
 		addStringToObject(objHashMap, FIELD_JOB_STATUS, jstatsstr);
+		free(jstatsstr);
 	}
 	addNumberToObject(objHashMap, FIELD_NUM_PROCESSORS,
 			logrec->eventLog.jobNewLog.numProcessors);
@@ -1291,10 +1369,10 @@ static void putJobNew(Json4c *objHashMap, struct eventRec *logrec) {
 				logrec->eventLog.jobNewLog.hostFactor);
 
 	addNumberToObject(objHashMap, FIELD_UMASK, logrec->eventLog.jobNewLog.umask);
-	addStringToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobNewLog.queue);
+	addNameToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobNewLog.queue);
 	addStringToObject(objHashMap, FIELD_RES_REQ, logrec->eventLog.jobNewLog.resReq);
 
-	addStringToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME,
+	addNameToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME,
 				logrec->eventLog.jobNewLog.fromHost);
 
 #if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
@@ -1403,7 +1481,7 @@ static void putJobNew(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_MAIL_USER,
 				logrec->eventLog.jobNewLog.mailUser);
 
-	addStringToObject(objHashMap, FIELD_PROJECT_NAME,
+	addNameToObject(objHashMap, FIELD_PROJECT_NAME,
 				logrec->eventLog.jobNewLog.projectName);
 
 	addNumberToObject(objHashMap, FIELD_NIOS_PORT,
@@ -1724,11 +1802,11 @@ static void putJobSwitch(Json4c *objHashMap, struct eventRec *logrec) {
 	
 	addNumberToObject(objHashMap, FIELD_UID, logrec->eventLog.jobSwitchLog.userId);
 
-	addStringToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobSwitchLog.queue);
+	addNameToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobSwitchLog.queue);
 
 	addNumberToObject(objHashMap, FIELD_JOB_ARRAY_IDX, logrec->eventLog.jobSwitchLog.idx);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobSwitchLog.userName);
 }
 
@@ -1775,7 +1853,7 @@ static void putJobMove(Json4c *objHashMap, struct eventRec *logrec) {
 
 	addNumberToObject(objHashMap, FIELD_JOB_ARRAY_IDX, logrec->eventLog.jobMoveLog.idx);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobMoveLog.userName);
 }
 
@@ -1941,7 +2019,7 @@ static void putJobFinish(Json4c *objHashMap, struct eventRec *logrec) {
 	addNumberToObject(objHashMap, FIELD_UID,
 				logrec->eventLog.jobFinishLog.userId);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobFinishLog.userName);
 
 	addNumberToObject(objHashMap, FIELD_JOB_OPTS,
@@ -1981,10 +2059,10 @@ static void putJobFinish(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_END_TIME_STR, time);
 	FREEUP(time);
 
-	addStringToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobFinishLog.queue);
+	addNameToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobFinishLog.queue);
 	addStringToObject(objHashMap, FIELD_RES_REQ, logrec->eventLog.jobFinishLog.resReq);
 
-	addStringToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinishLog.fromHost);
+	addNameToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinishLog.fromHost);
 	
 	gmt = (int)logrec->eventLog.jobFinishLog.submitTime;
     addNumberToObject(objHashMap, FIELD_SUBMIT_TIME_UTC,gmt*1000);
@@ -2090,7 +2168,7 @@ static void putJobFinish(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_MAIL_USER,
 				logrec->eventLog.jobFinishLog.mailUser);
 
-	addStringToObject(objHashMap, FIELD_PROJECT_NAME,
+	addNameToObject(objHashMap, FIELD_PROJECT_NAME,
 			logrec->eventLog.jobFinishLog.projectName);
 
 	addNumberToObject(objHashMap, FIELD_EXIT_STATUS,
@@ -2244,15 +2322,16 @@ void ltrim(char *s) {
 	char *p;
 	p = s;
 	while (' ' == *p || '\t' == *p) {
-		*p++;
+		p++;
 	}
-	strcpy(s, p);
+	/* source and destination overlap */
+	memmove(s, p, strlen(p) + 1);
 }
 
 void rtrim(char *s) {
 	int i;
 	i = strlen(s) - 1;
-	while ((' ' == s[i] || '\t' == s[i]) && i >= 0) {
+	while (i >= 0 && (' ' == s[i] || '\t' == s[i])) {
 		i--;
 	}
 	s[i + 1] = '\0';
@@ -2359,7 +2438,7 @@ static Json4c *getJobFinish2HashmapArray(struct eventRec *logrec) {
 		break;
 	}
 
-	addStringToObject(objHost, FIELD_USER_NAME,
+	addNameToObject(objHost, FIELD_USER_NAME,
 				logrec->eventLog.jobFinish2Log.userName);
 
 	addNumberToObject(objHost, FIELD_JOB_OPTS,
@@ -2406,10 +2485,10 @@ static Json4c *getJobFinish2HashmapArray(struct eventRec *logrec) {
 
 
 
-	addStringToObject(objHost, FIELD_QUEUE_NAME, logrec->eventLog.jobFinish2Log.queue);
+	addNameToObject(objHost, FIELD_QUEUE_NAME, logrec->eventLog.jobFinish2Log.queue);
 	addStringToObject(objHost, FIELD_RES_REQ, logrec->eventLog.jobFinish2Log.resReq);
 
-	addStringToObject(objHost, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinish2Log.fromHost);
+	addNameToObject(objHost, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinish2Log.fromHost);
 
 	addStringToObject(objHost, FIELD_CWD, logrec->eventLog.jobFinish2Log.cwd);
 	addStringToObject(objHost, FIELD_IN_FILE, logrec->eventLog.jobFinish2Log.inFile);
@@ -2425,7 +2504,7 @@ static Json4c *getJobFinish2HashmapArray(struct eventRec *logrec) {
 	addStringToObject(objHost, FIELD_JOB_COMMAND, logrec->eventLog.jobFinish2Log.command);
 	addStringToObject(objHost, FIELD_PREEXEC_CMD, logrec->eventLog.jobFinish2Log.preExecCmd);
 
-	addStringToObject(objHost, FIELD_PROJECT_NAME, logrec->eventLog.jobFinish2Log.projectName);
+	addNameToObject(objHost, FIELD_PROJECT_NAME, logrec->eventLog.jobFinish2Log.projectName);
 
 	addNumberToObject(objHost, FIELD_EXIT_STATUS, logrec->eventLog.jobFinish2Log.exitStatus);
 
@@ -2526,7 +2605,7 @@ static Json4c *getJobFinish2HashmapArray(struct eventRec *logrec) {
 	addStringToObject(objHost, FIELD_EXEC_RUSAGE,
 				logrec->eventLog.jobFinish2Log.execRusage);
 
-	addStringToObject(objHost, FIELD_CLUSTER_NAME,
+	addNameToObject(objHost, FIELD_CLUSTER_NAME,
 				logrec->eventLog.jobFinish2Log.clusterName);
 
 	addStringToObject(objHost, FIELD_USER_GROUP_NAME,
@@ -2627,7 +2706,7 @@ static void putJobFinish2(Json4c *objHost, struct eventRec *logrec) {
 		break;
 	}
 
-	addStringToObject(objHost, FIELD_USER_NAME,
+	addNameToObject(objHost, FIELD_USER_NAME,
 			logrec->eventLog.jobFinish2Log.userName);
 
 	addNumberToObject(objHost, FIELD_JOB_OPTS,
@@ -2672,10 +2751,10 @@ static void putJobFinish2(Json4c *objHost, struct eventRec *logrec) {
 	addStringToObject(objHost, FIELD_END_TIME_STR, time);
 	FREEUP(time);
 
-	addStringToObject(objHost, FIELD_QUEUE_NAME, logrec->eventLog.jobFinish2Log.queue);
+	addNameToObject(objHost, FIELD_QUEUE_NAME, logrec->eventLog.jobFinish2Log.queue);
 	addStringToObject(objHost, FIELD_RES_REQ, logrec->eventLog.jobFinish2Log.resReq);
 
-	addStringToObject(objHost, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinish2Log.fromHost);
+	addNameToObject(objHost, FIELD_SUBMISSION_HOST_NAME, logrec->eventLog.jobFinish2Log.fromHost);
 
 	addStringToObject(objHost, FIELD_CWD, logrec->eventLog.jobFinish2Log.cwd);
 	addStringToObject(objHost, FIELD_IN_FILE, logrec->eventLog.jobFinish2Log.inFile);
@@ -2691,7 +2770,7 @@ static void putJobFinish2(Json4c *objHost, struct eventRec *logrec) {
 	addStringToObject(objHost, FIELD_JOB_COMMAND, logrec->eventLog.jobFinish2Log.command);
 	addStringToObject(objHost, FIELD_PREEXEC_CMD, logrec->eventLog.jobFinish2Log.preExecCmd);
 
-	addStringToObject(objHost, FIELD_PROJECT_NAME, logrec->eventLog.jobFinish2Log.projectName);
+	addNameToObject(objHost, FIELD_PROJECT_NAME, logrec->eventLog.jobFinish2Log.projectName);
 
 	addNumberToObject(objHost, FIELD_EXIT_STATUS, logrec->eventLog.jobFinish2Log.exitStatus);
 
@@ -2798,7 +2877,7 @@ static void putJobFinish2(Json4c *objHost, struct eventRec *logrec) {
 	addStringToObject(objHost, FIELD_EXEC_RUSAGE,
 				logrec->eventLog.jobFinish2Log.execRusage);
 
-	addStringToObject(objHost, FIELD_CLUSTER_NAME,
+	addNameToObject(objHost, FIELD_CLUSTER_NAME,
 			logrec->eventLog.jobFinish2Log.clusterName);
 
 	addStringToObject(objHost, FIELD_USER_GROUP_NAME,
@@ -2971,7 +3050,7 @@ static void putJobStartLimit(Json4c *objHost, struct eventRec *logrec) {
 
 	addNumberToObject(objHost, FIELD_JOB_ARRAY_IDX, lsfArrayIdx);
 
-	addStringToObject(objHost, FIELD_CLUSTER_NAME, logrec->eventLog.jobStartLimitLog.clusterName);
+	addNameToObject(objHost, FIELD_CLUSTER_NAME, logrec->eventLog.jobStartLimitLog.clusterName);
 
 	// Add nested level cluster_rlimit and job_rlimit by ZK
 	Json4c * clusterRLimit = jCreateObject();
@@ -3026,7 +3105,7 @@ static void putMig(Json4c *objHashMap, struct eventRec *logrec) {
 
 	addNumberToObject(objHashMap, FIELD_UID, logrec->eventLog.migLog.userId);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME, logrec->eventLog.migLog.userName);
+	addNameToObject(objHashMap, FIELD_USER_NAME, logrec->eventLog.migLog.userName);
 
 	addNumberToObject(objHashMap, FIELD_JOB_ARRAY_IDX, logrec->eventLog.migLog.idx);
 
@@ -3110,7 +3189,7 @@ static void putJobModify2(Json4c *objHashMap, struct eventRec *logrec) {
 		}
 	}
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobModLog.userName);
 
 	addNumberToObject(objHashMap, FIELD_SUBMIT_TIME, logrec->eventLog.jobModLog.submitTime);
@@ -3147,7 +3226,7 @@ static void putJobModify2(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_JOB_NAME_FULL,
 				logrec->eventLog.jobModLog.jobName);
 
-	addStringToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobModLog.queue);
+	addNameToObject(objHashMap, FIELD_QUEUE_NAME, logrec->eventLog.jobModLog.queue);
 	addStringToObject(objHashMap, FIELD_RES_REQ, logrec->eventLog.jobModLog.resReq);
 
 	addStringToObject(objHashMap, FIELD_HOST_SPEC,
@@ -3189,7 +3268,7 @@ static void putJobModify2(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_JOB_FILE,
 				logrec->eventLog.jobModLog.jobFile);
 
-	addStringToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME,
+	addNameToObject(objHashMap, FIELD_SUBMISSION_HOST_NAME,
 				logrec->eventLog.jobModLog.fromHost);
 
 	/* cwd */
@@ -3218,7 +3297,7 @@ static void putJobModify2(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_MAIL_USER,
 				logrec->eventLog.jobModLog.mailUser);
 
-	addStringToObject(objHashMap, FIELD_PROJECT_NAME,
+	addNameToObject(objHashMap, FIELD_PROJECT_NAME,
 			logrec->eventLog.jobModLog.projectName);
 
 	addNumberToObject(objHashMap, FIELD_NIOS_PORT,
@@ -3363,7 +3442,7 @@ static void putJobSignal(Json4c *objHashMap, struct eventRec *logrec) {
 
 	addNumberToObject(objHashMap, FIELD_JOB_ARRAY_IDX, logrec->eventLog.signalLog.idx);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.signalLog.userName);
 }
 
@@ -3869,7 +3948,7 @@ static void putJobExtMsg(Json4c *objHashMap, struct eventRec *logrec) {
 	addStringToObject(objHashMap, FIELD_FILE_NAME,
 				logrec->eventLog.jobExternalMsgLog.fileName);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobExternalMsgLog.userName);
 
 }
@@ -3927,6 +4006,7 @@ static void putJobChunk(Json4c *objHashMap, struct eventRec *logrec) {
 	*buff = '\0';
 
 	addStringToObject(objHashMap, FIELD_MEMB_JOB_ID, temp);
+	free(temp);
 
 	/* this type have no idx, so default is :0*/
 	addNumberToObject(objHashMap, FIELD_JOB_ARRAY_IDX, 0);
@@ -4156,10 +4236,10 @@ static void putJobForce(Json4c *objHashMap, struct eventRec *logrec) {
 	addNumberToObject(objHashMap, FIELD_RUN_OPTIONS,
 			logrec->eventLog.jobForceRequestLog.options);
 
-	addStringToObject(objHashMap, FIELD_USER_NAME,
+	addNameToObject(objHashMap, FIELD_USER_NAME,
 				logrec->eventLog.jobForceRequestLog.userName);
 
-	addStringToObject(objHashMap, FIELD_QUEUE_NAME,
+	addNameToObject(objHashMap, FIELD_QUEUE_NAME,
 			logrec->eventLog.jobForceRequestLog.queue);
 
 	/* number of exec host*/
@@ -4379,11 +4459,11 @@ static Json4c *getJobStatus2HashmapArray(struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.userName
 			&& strlen(logrec->eventLog.jobStatus2Log.userName)) {
-		addStringToObject(objHost, FIELD_USER_NAME,
+		addNameToObject(objHost, FIELD_USER_NAME,
 						logrec->eventLog.jobStatus2Log.userName);
 
 	} else {
-		addStringToObject(objHost, FIELD_USER_NAME, "-");
+		addNameToObject(objHost, FIELD_USER_NAME, "-");
 
 	}
 
@@ -4418,10 +4498,10 @@ static Json4c *getJobStatus2HashmapArray(struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.queue
 			&& strlen(logrec->eventLog.jobStatus2Log.queue)) {
-		addStringToObject(objHost, FIELD_QUEUE_NAME,
+		addNameToObject(objHost, FIELD_QUEUE_NAME,
 				logrec->eventLog.jobStatus2Log.queue);
 	} else {
-		addStringToObject(objHost, FIELD_QUEUE_NAME, "-");
+		addNameToObject(objHost, FIELD_QUEUE_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.resReq
 			&& strlen(logrec->eventLog.jobStatus2Log.resReq)) {
@@ -4433,10 +4513,10 @@ static Json4c *getJobStatus2HashmapArray(struct eventRec *logrec) {
 	}
 	if (logrec->eventLog.jobStatus2Log.projectName
 			&& strlen(logrec->eventLog.jobStatus2Log.projectName)) {
-		addStringToObject(objHost, FIELD_PROJECT_NAME,
+		addNameToObject(objHost, FIELD_PROJECT_NAME,
 						logrec->eventLog.jobStatus2Log.projectName);
 	} else {
-		addStringToObject(objHost, FIELD_PROJECT_NAME, "-");
+		addNameToObject(objHost, FIELD_PROJECT_NAME, "-");
 	}
 #if !defined(LSF6)
 	if (logrec->eventLog.jobStatus2Log.jgroup
@@ -4473,10 +4553,10 @@ static Json4c *getJobStatus2HashmapArray(struct eventRec *logrec) {
 	if (logrec->eventLog.jobStatus2Log.clusterName
 			&& strlen(logrec->eventLog.jobStatus2Log.clusterName)) {
 
-		addStringToObject(objHost, FIELD_CLUSTER_NAME,
+		addNameToObject(objHost, FIELD_CLUSTER_NAME,
 						logrec->eventLog.jobStatus2Log.clusterName);
 	} else {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME, "-");
+		addNameToObject(objHost, FIELD_CLUSTER_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.userGroup
 			&& strlen(logrec->eventLog.jobStatus2Log.userGroup)) {
@@ -4530,11 +4610,11 @@ static void putJobStatus2(Json4c *objHost, struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.userName
 			&& strlen(logrec->eventLog.jobStatus2Log.userName)) {
-		addStringToObject(objHost, FIELD_USER_NAME,
+		addNameToObject(objHost, FIELD_USER_NAME,
 						logrec->eventLog.jobStatus2Log.userName);
 
 	} else {
-		addStringToObject(objHost, FIELD_USER_NAME, "-");
+		addNameToObject(objHost, FIELD_USER_NAME, "-");
 	}
 	addNumberToObject(objHost, FIELD_SAMPLE_INTERVAL,
 				logrec->eventLog.jobStatus2Log.sampleInterval);
@@ -4568,10 +4648,10 @@ static void putJobStatus2(Json4c *objHost, struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.queue
 			&& strlen(logrec->eventLog.jobStatus2Log.queue)) {
-		addStringToObject(objHost, FIELD_QUEUE_NAME,
+		addNameToObject(objHost, FIELD_QUEUE_NAME,
 				logrec->eventLog.jobStatus2Log.queue);
 	} else {
-		addStringToObject(objHost, FIELD_QUEUE_NAME, "-");
+		addNameToObject(objHost, FIELD_QUEUE_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.resReq
 			&& strlen(logrec->eventLog.jobStatus2Log.resReq)) {
@@ -4583,10 +4663,10 @@ static void putJobStatus2(Json4c *objHost, struct eventRec *logrec) {
 	}
 	if (logrec->eventLog.jobStatus2Log.projectName
 			&& strlen(logrec->eventLog.jobStatus2Log.projectName)) {
-		addStringToObject(objHost, FIELD_PROJECT_NAME,
+		addNameToObject(objHost, FIELD_PROJECT_NAME,
 					logrec->eventLog.jobStatus2Log.projectName);
 	} else {
-		addStringToObject(objHost, FIELD_PROJECT_NAME, "-");
+		addNameToObject(objHost, FIELD_PROJECT_NAME, "-");
 	}
 #if !defined(LSF6)
 	if (logrec->eventLog.jobStatus2Log.jgroup
@@ -4621,10 +4701,10 @@ static void putJobStatus2(Json4c *objHost, struct eventRec *logrec) {
 	}
 	if (logrec->eventLog.jobStatus2Log.clusterName
 			&& strlen(logrec->eventLog.jobStatus2Log.clusterName)) {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME,
+		addNameToObject(objHost, FIELD_CLUSTER_NAME,
 						logrec->eventLog.jobStatus2Log.clusterName);
 	} else {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME, "-");
+		addNameToObject(objHost, FIELD_CLUSTER_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.userGroup
 			&& strlen(logrec->eventLog.jobStatus2Log.userGroup)) {
@@ -4700,11 +4780,11 @@ static Json4c *getJobStatus2PendHashmapArray(struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.userName
 			&& strlen(logrec->eventLog.jobStatus2Log.userName)) {
-		addStringToObject(objHost, FIELD_USER_NAME,
+		addNameToObject(objHost, FIELD_USER_NAME,
 						logrec->eventLog.jobStatus2Log.userName);
 
 	} else {
-		addStringToObject(objHost, FIELD_USER_NAME, "-");
+		addNameToObject(objHost, FIELD_USER_NAME, "-");
 	}
 	addNumberToObject(objHost, FIELD_SAMPLE_INTERVAL,
 				logrec->eventLog.jobStatus2Log.sampleInterval);
@@ -4724,10 +4804,10 @@ static Json4c *getJobStatus2PendHashmapArray(struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.queue
 			&& strlen(logrec->eventLog.jobStatus2Log.queue)) {
-		addStringToObject(objHost, FIELD_QUEUE_NAME,
+		addNameToObject(objHost, FIELD_QUEUE_NAME,
 				logrec->eventLog.jobStatus2Log.queue);
 	} else {
-		addStringToObject(objHost, FIELD_QUEUE_NAME, "-");
+		addNameToObject(objHost, FIELD_QUEUE_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.resReq
 			&& strlen(logrec->eventLog.jobStatus2Log.resReq)) {
@@ -4739,10 +4819,10 @@ static Json4c *getJobStatus2PendHashmapArray(struct eventRec *logrec) {
 	}
 	if (logrec->eventLog.jobStatus2Log.projectName
 			&& strlen(logrec->eventLog.jobStatus2Log.projectName)) {
-		addStringToObject(objHost, FIELD_PROJECT_NAME,
+		addNameToObject(objHost, FIELD_PROJECT_NAME,
 						logrec->eventLog.jobStatus2Log.projectName);
 	} else {
-		addStringToObject(objHost, FIELD_PROJECT_NAME, "-");
+		addNameToObject(objHost, FIELD_PROJECT_NAME, "-");
 	}
 #if !defined(LSF6)
 	if (logrec->eventLog.jobStatus2Log.jgroup
@@ -4764,10 +4844,10 @@ static Json4c *getJobStatus2PendHashmapArray(struct eventRec *logrec) {
 #endif
 	if (logrec->eventLog.jobStatus2Log.clusterName
 			&& strlen(logrec->eventLog.jobStatus2Log.clusterName)) {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME,
+		addNameToObject(objHost, FIELD_CLUSTER_NAME,
 						logrec->eventLog.jobStatus2Log.clusterName);
 	} else {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME, "-");
+		addNameToObject(objHost, FIELD_CLUSTER_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.userGroup
 			&& strlen(logrec->eventLog.jobStatus2Log.userGroup)) {
@@ -4792,11 +4872,11 @@ static void putJobStatus2Pend(Json4c *objHost, struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.userName
 			&& strlen(logrec->eventLog.jobStatus2Log.userName)) {
-		addStringToObject(objHost, FIELD_USER_NAME,
+		addNameToObject(objHost, FIELD_USER_NAME,
 						logrec->eventLog.jobStatus2Log.userName);
 
 	} else {
-		addStringToObject(objHost, FIELD_USER_NAME, "-");
+		addNameToObject(objHost, FIELD_USER_NAME, "-");
 	}
 	addNumberToObject(objHost, FIELD_SAMPLE_INTERVAL,
 			logrec->eventLog.jobStatus2Log.sampleInterval);
@@ -4816,10 +4896,10 @@ static void putJobStatus2Pend(Json4c *objHost, struct eventRec *logrec) {
 
 	if (logrec->eventLog.jobStatus2Log.queue
 			&& strlen(logrec->eventLog.jobStatus2Log.queue)) {
-		addStringToObject(objHost, FIELD_QUEUE_NAME,
+		addNameToObject(objHost, FIELD_QUEUE_NAME,
 				logrec->eventLog.jobStatus2Log.queue);
 	} else {
-		addStringToObject(objHost, FIELD_QUEUE_NAME, "-");
+		addNameToObject(objHost, FIELD_QUEUE_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.resReq
 			&& strlen(logrec->eventLog.jobStatus2Log.resReq)) {
@@ -4830,10 +4910,10 @@ static void putJobStatus2Pend(Json4c *objHost, struct eventRec *logrec) {
 	}
 	if (logrec->eventLog.jobStatus2Log.projectName
 			&& strlen(logrec->eventLog.jobStatus2Log.projectName)) {
-		addStringToObject(objHost, FIELD_PROJECT_NAME,
+		addNameToObject(objHost, FIELD_PROJECT_NAME,
 				logrec->eventLog.jobStatus2Log.projectName);
 	} else {
-		addStringToObject(objHost, FIELD_PROJECT_NAME, "-");
+		addNameToObject(objHost, FIELD_PROJECT_NAME, "-");
 	}
 #if !defined(LSF6)
 	if (logrec->eventLog.jobStatus2Log.jgroup
@@ -4855,10 +4935,10 @@ static void putJobStatus2Pend(Json4c *objHost, struct eventRec *logrec) {
 #endif
 	if (logrec->eventLog.jobStatus2Log.clusterName
 			&& strlen(logrec->eventLog.jobStatus2Log.clusterName)) {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME,
+		addNameToObject(objHost, FIELD_CLUSTER_NAME,
 				logrec->eventLog.jobStatus2Log.clusterName);
 	} else {
-		addStringToObject(objHost, FIELD_CLUSTER_NAME, "-");
+		addNameToObject(objHost, FIELD_CLUSTER_NAME, "-");
 	}
 	if (logrec->eventLog.jobStatus2Log.userGroup
 			&& strlen(logrec->eventLog.jobStatus2Log.userGroup)) {
@@ -4929,7 +5009,7 @@ static Json4c *getJobRunTimeHostsHashmapArray(char *eventType, time_t eventTime,
 //			throw_exception_by_key(env, logger, "perf.lsf.events.nullObject", NULL);
 			return NULL;
 		}
-		addStringToObject(objHost, FIELD_HOST_NAME, jobStatus2Log->execHosts[i]);
+		addNameToObject(objHost, FIELD_HOST_NAME, jobStatus2Log->execHosts[i]);
 
 		addNumberToObject(objHost, FIELD_EXECHOST_SLOT_NUM, jobStatus2Log->slotUsages[i]);
 
@@ -5017,6 +5097,123 @@ static Json4c *getJobRunTimeHostsHashmapArray(char *eventType, time_t eventTime,
 	return execHostsArray;
 }
 
+/*
+ *-----------------------------------------------------------------------
+ *
+ * fillJobInfo
+ *
+ * ARGUMENTS:
+ *
+ * logrec[IN]: parsed record.
+ *
+ * DESCRIPTION:
+ *
+ * Copy the job fields of logrec to the lsbJobInfo of the running *InfoN
+ * call, if any, so the caller can track job states without decoding the
+ * JSON text. Records not about a single job leave it at
+ * LSB_JOB_EVENT_NONE.
+ *
+ * RETURN:
+ *
+ * 1 if the caller only wants the job fields and the JSON text is not to
+ * be built, 0 otherwise.
+ *
+ *-----------------------------------------------------------------------
+ */
+#if defined(WIN32)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+static THREAD_LOCAL struct lsbJobInfo *jobInfo = NULL;
+/* set by the *JobInfoN calls, which skip the JSON text */
+static THREAD_LOCAL int jobInfoOnly = 0;
+static THREAD_LOCAL int jobInfoParsed = 0;
+
+static int fillJobInfo(struct eventRec *logrec) {
+	struct lsbJobInfo *info = jobInfo;
+
+	if (info == NULL) {
+		return 0;
+	}
+	jobInfoParsed = 1;
+	switch (logrec->type) {
+	case EVENT_JOB_NEW:
+		info->eventType = LSB_JOB_EVENT_NEW;
+		info->jobId = logrec->eventLog.jobNewLog.jobId;
+		info->idx = logrec->eventLog.jobNewLog.idx;
+		info->jStatus = (logrec->eventLog.jobNewLog.options2 & SUB2_HOLD) ?
+				JOB_STAT_PSUSP : JOB_STAT_PEND;
+		break;
+	case EVENT_JOB_START:
+		info->eventType = LSB_JOB_EVENT_START;
+		info->jobId = logrec->eventLog.jobStartLog.jobId;
+		info->idx = logrec->eventLog.jobStartLog.idx;
+		info->jStatus = logrec->eventLog.jobStartLog.jStatus;
+		break;
+	case EVENT_JOB_START_ACCEPT:
+		info->eventType = LSB_JOB_EVENT_START_ACCEPT;
+		info->jobId = logrec->eventLog.jobStartAcceptLog.jobId;
+		info->idx = logrec->eventLog.jobStartAcceptLog.idx;
+		break;
+	case EVENT_JOB_STATUS:
+		info->eventType = LSB_JOB_EVENT_STATUS;
+		info->jobId = logrec->eventLog.jobStatusLog.jobId;
+		info->idx = logrec->eventLog.jobStatusLog.idx;
+		info->jStatus = logrec->eventLog.jobStatusLog.jStatus;
+		info->exitStatus = logrec->eventLog.jobStatusLog.exitStatus;
+		info->exitInfo = logrec->eventLog.jobStatusLog.exitInfo;
+		break;
+	case EVENT_JOB_STATUS2:
+		/* jobId 0 is the pending reason summary, not a job */
+		if (logrec->eventLog.jobStatus2Log.jobId <= 0) {
+			break;
+		}
+		info->eventType = LSB_JOB_EVENT_STATUS2;
+		info->jobId = LSB_ARRAY_JOBID(logrec->eventLog.jobStatus2Log.jobId);
+		info->idx = LSB_ARRAY_IDX(logrec->eventLog.jobStatus2Log.jobId);
+		info->jStatus = logrec->eventLog.jobStatus2Log.jStatus;
+		break;
+	case EVENT_JOB_SWITCH:
+		info->eventType = LSB_JOB_EVENT_SWITCH;
+		info->jobId = logrec->eventLog.jobSwitchLog.jobId;
+		info->idx = logrec->eventLog.jobSwitchLog.idx;
+		break;
+	case EVENT_JOB_MOVE:
+		info->eventType = LSB_JOB_EVENT_MOVE;
+		info->jobId = logrec->eventLog.jobMoveLog.jobId;
+		info->idx = logrec->eventLog.jobMoveLog.idx;
+		break;
+	case EVENT_JOB_SIGNAL:
+		info->eventType = LSB_JOB_EVENT_SIGNAL;
+		info->jobId = logrec->eventLog.signalLog.jobId;
+		info->idx = logrec->eventLog.signalLog.idx;
+		break;
+	case EVENT_JOB_REQUEUE:
+		info->eventType = LSB_JOB_EVENT_REQUEUE;
+		info->jobId = logrec->eventLog.jobRequeueLog.jobId;
+		info->idx = logrec->eventLog.jobRequeueLog.idx;
+		break;
+	case EVENT_JOB_FORCE:
+		info->eventType = LSB_JOB_EVENT_FORCE;
+		info->jobId = logrec->eventLog.jobForceRequestLog.jobId;
+		info->idx = logrec->eventLog.jobForceRequestLog.idx;
+		break;
+	case EVENT_JOB_FINISH:
+		info->eventType = LSB_JOB_EVENT_FINISH;
+		info->jobId = logrec->eventLog.jobFinishLog.jobId;
+		info->idx = logrec->eventLog.jobFinishLog.idx;
+		info->jStatus = logrec->eventLog.jobFinishLog.jStatus;
+		info->exitStatus = logrec->eventLog.jobFinishLog.exitStatus;
+		info->exitInfo = logrec->eventLog.jobFinishLog.exitInfo;
+		break;
+	default:
+		break;
+	}
+	return jobInfoOnly;
+}
+
 /*
  *-----------------------------------------------------------------------
  *
@@ -5049,7 +5246,7 @@ char *readlsbStream(char *record) {
 	char *ret;
 	struct eventRec *logrec = NULL;
 
-	Json4c *objHeadHashmap, *objRangeHashmap;
+	Json4c *objHeadHashmap = NULL, *objRangeHashmap;
 
 	int i, iRet;
 	Json4c *askedHostsArray, *execHostsArray, *reserHostsArray, *hRusagesArray;
@@ -5085,6 +5282,9 @@ char *readlsbStream(char *record) {
 		TRACE("read error\n");
 		return NULL;
 	}
+	if (fillJobInfo(logrec)) {
+		goto end;
+	}
 
 	/* backup the original record to get event type string. */
 	strncpy(eventType, record, 1023);
@@ -5309,10 +5509,12 @@ char *readlsbStream(char *record) {
 #endif
 	default:
 		TRACE("unknown event type\n");
-		return NULL;
+		jFree(objHeadHashmap);
+		objHeadHashmap = NULL;
+		goto end;
 	}
 	/* add clusterName */
-	addStringToObject(objHeadHashmap, FIELD_CLUSTER_NAME, ls_getclustername());
+	addNameToObject(objHeadHashmap, FIELD_CLUSTER_NAME, getclustername());
 
 	end:
 	/* relase memory. */
@@ -5322,6 +5524,7 @@ char *readlsbStream(char *record) {
 	logrec = NULL;
 #endif
 
+	/* NULL for unknown or malformed records. */
 	ret = jToString(objHeadHashmap);
 	jFree(objHeadHashmap);
 
@@ -5359,9 +5562,10 @@ char *readlsbStream(char *record) {
 char *readlsbEvents(char *record) {
 	// char *recstr = NULL;
 	char *ret;
+	struct parseCtx *ctx;
 	struct eventRec *logrec = NULL;
 
-	Json4c *objHeadHashmap, *objRangeHashmap;
+	Json4c *objHeadHashmap = NULL, *objRangeHashmap;
 
 	int i, iRet;
 	Json4c *askedHostsArray, *execHostsArray, *reserHostsArray, *hRusagesArray;
@@ -5385,17 +5589,22 @@ char *readlsbEvents(char *record) {
 	}
 
 
-	/* invoke LSF parse function. */
-	logrec = (struct eventRec *) calloc(1, sizeof(struct eventRec));
-	if (logrec == NULL) {
+	/* invoke LSF parse function on the reusable record. */
+	ctx = getParseCtx();
+	if (ctx == NULL) {
 		return NULL;
 	}
+	logrec = &ctx->logrec;
 
-	iRet = lsb_geteventrecbyline(record, logrec);
+	iRet = geteventrecbyline(record, logrec);
 
 	if (iRet == -1) {
+		resetParseCtx(ctx);
 		return NULL;
 	}
+	if (fillJobInfo(logrec)) {
+		goto end;
+	}
 	/*#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
 	 logrec = (*stream.lsb_readstreamlineMT)(record);
 	 #else
@@ -5629,34 +5838,30 @@ char *readlsbEvents(char *record) {
 		break;
 #endif
 	default:
-		return NULL;
+		jFree(objHeadHashmap);
+		objHeadHashmap = NULL;
+		goto end;
 	}
 	/* add clusterName */
-	addStringToObject(objHeadHashmap, FIELD_CLUSTER_NAME, ls_getclustername());
+	addNameToObject(objHeadHashmap, FIELD_CLUSTER_NAME, getclustername());
 
 	end:
-	/* relase memory. */
+	/* relase memory, NULL for unknown or malformed records. */
 
 	ret = jToString(objHeadHashmap);
 	jFree(objHeadHashmap);
 
-#if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
-	if(logrec != NULL) {
-		//(*stream.lsb_freelogrec)(logrec);
-		/* relase memory. */
-		FREEUP(logrec);
-		logrec = NULL;
-	}
-#endif
+	resetParseCtx(ctx);
 	return ret;
 	// return objHeadHashmap;
 }
 
 char *readlsbAcct(char *record) {
 	char *ret;
+	struct parseCtx *ctx;
 	struct eventRec *logrec = NULL;
 
-	Json4c *objHeadHashmap;
+	Json4c *objHeadHashmap = NULL;
 	int iRet;
 	Json4c *execHostsArray;
 	char eventType[1024] = { '\0' };
@@ -5674,32 +5879,37 @@ char *readlsbAcct(char *record) {
 	if (record == NULL) {
 		return NULL;
 	}
-	/* invoke LSF parse function. */
-	logrec = (struct eventRec *) calloc(1, sizeof(struct eventRec));
-	if (logrec == NULL) {
+	/* invoke LSF parse function on the reusable record. */
+	ctx = getParseCtx();
+	if (ctx == NULL) {
 		return NULL;
 	}
-	iRet = lsb_geteventrecbyline(record, logrec);
+	logrec = &ctx->logrec;
+	iRet = geteventrecbyline(record, logrec);
 	if (iRet == -1) {
+		resetParseCtx(ctx);
 		return NULL;
 	}
+	if (fillJobInfo(logrec)) {
+		goto end;
+	}
 	/* backup the original record to get event type string. */
 	strncpy(eventType, record, 1023);
 	eventType[1023] = '\0';
 	p = strchr(eventType, ' ');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 	*p = '\0';
 	/* remove ". */
 	p = strrchr(eventType, '\"');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 	*p = '\0';
 	p = strchr(eventType, '\"');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 
 	objHeadHashmap = jCreateObject();
@@ -5721,14 +5931,19 @@ char *readlsbAcct(char *record) {
 		}
 		break;
 	default:
-		return NULL;
+		jFree(objHeadHashmap);
+		objHeadHashmap = NULL;
+		goto end;
 	}
 	/* add clusterName */
-	addStringToObject(objHeadHashmap, FIELD_CLUSTER_NAME, ls_getclustername());
+	addNameToObject(objHeadHashmap, FIELD_CLUSTER_NAME, getclustername());
 
+	end:
+	/* relase memory, NULL for unknown or malformed records. */
 	ret = jToString(objHeadHashmap);
 	jFree(objHeadHashmap);
 
+	resetParseCtx(ctx);
 	return ret;
 }
 
@@ -5762,7 +5977,7 @@ char *readlsbAcct(char *record) {
 char *readlsbStatus(char *record) {
 	char *ret;
 	struct eventRec *logrec = NULL;
-	Json4c *objHeadHashmap;
+	Json4c *objHeadHashmap = NULL;
 	int iRet;
 	Json4c *execHostsArray;
 	char eventType[1024] = { '\0' };
@@ -5795,23 +6010,26 @@ char *readlsbStatus(char *record) {
 	if (logrec == NULL) {
 		return NULL;
 	}
+	if (fillJobInfo(logrec)) {
+		goto end;
+	}
 	/* backup the original record to get event type string. */
 	strncpy(eventType, record, 1023);
 	eventType[1023] = '\0';
 	p = strchr(eventType, ' ');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 	*p = '\0';
 	/* remove ". */
 	p = strrchr(eventType, '\"');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 	*p = '\0';
 	p = strchr(eventType, '\"');
 	if (NULL == p) {
-		return NULL;
+		goto end;
 	}
 	/* create hashmap object. */
 	objHeadHashmap = jCreateObject();
@@ -5834,8 +6052,13 @@ char *readlsbStatus(char *record) {
 
 		break;
 		default:
-		return NULL;
+		jFree(objHeadHashmap);
+		objHeadHashmap = NULL;
+		break;
 	}
+
+	end:
+	/* relase memory, NULL for unknown or malformed records. */
 #if defined(LSB_EVENT_VERSION9_1) || defined(LSB_EVENT_VERSION10_1)
 	(*stream.lsb_freelogrec)(logrec);
 	logrec = NULL;
@@ -5850,3 +6073,162 @@ char *readlsbStatus(char *record) {
 #endif
 
 }
+
+/*
+ *-----------------------------------------------------------------------
+ *
+ * lineBuffer
+ *
+ * ARGUMENTS:
+ *
+ * record[IN]: record bytes, not NUL terminated.
+ * len[IN]: number of bytes in record.
+ *
+ * DESCRIPTION:
+ *
+ * The LSF record readers want a NUL terminated string, while the caller
+ * hands in a (pointer, length) view of its own read buffer. Copy the bytes
+ * into a per thread buffer which only grows to the longest line seen, so
+ * there is no allocation per record and nothing for the caller to free.
+ *
+ * RETURN:
+ *
+ * NUL terminated copy of record on success, NULL on failure.
+ *
+ *-----------------------------------------------------------------------
+ */
+static THREAD_LOCAL char *lineBuf = NULL;
+static THREAD_LOCAL int lineBufSize = 0;
+
+static char *lineBuffer(const char *record, int len) {
+	char *buf;
+	int size;
+
+	if (record == NULL || len < 0) {
+		return NULL;
+	}
+	if (len + 1 > lineBufSize) {
+		size = lineBufSize > 0 ? lineBufSize : 4096;
+		while (size < len + 1) {
+			size *= 2;
+		}
+		buf = realloc(lineBuf, size);
+		if (buf == NULL) {
+			return NULL;
+		}
+		lineBuf = buf;
+		lineBufSize = size;
+	}
+	memcpy(lineBuf, record, len);
+	lineBuf[len] = '\0';
+	return lineBuf;
+}
+
+/*
+ * Length aware entry points, record does not need to be NUL terminated
+ * and is not retained after the call returns.
+ */
+char *readlsbStreamN(const char *record, int len) {
+	char *line = lineBuffer(record, len);
+
+	return line ? readlsbStream(line) : NULL;
+}
+
+char *readlsbEventsN(const char *record, int len) {
+	char *line = lineBuffer(record, len);
+
+	return line ? readlsbEvents(line) : NULL;
+}
+
+char *readlsbAcctN(const char *record, int len) {
+	char *line = lineBuffer(record, len);
+
+	return line ? readlsbAcct(line) : NULL;
+}
+
+char *readlsbStatusN(const char *record, int len) {
+	char *line = lineBuffer(record, len);
+
+	return line ? readlsbStatus(line) : NULL;
+}
+
+/*
+ * Same as the length aware entry points, also filling info with the job
+ * fields of the record; info->eventType is LSB_JOB_EVENT_NONE if the
+ * record is not about a single job or could not be parsed.
+ */
+static char *readInfoN(char *(*reader)(char *), const char *record, int len,
+		struct lsbJobInfo *info) {
+	char *line = lineBuffer(record, len);
+	char *ret;
+
+	if (info == NULL) {
+		return line ? reader(line) : NULL;
+	}
+	memset(info, 0, sizeof(*info));
+	if (line == NULL) {
+		return NULL;
+	}
+	jobInfo = info;
+	ret = reader(line);
+	jobInfo = NULL;
+	if (ret == NULL) {
+		memset(info, 0, sizeof(*info));
+	}
+	return ret;
+}
+
+char *readlsbStreamInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readInfoN(readlsbStream, record, len, info);
+}
+
+char *readlsbEventsInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readInfoN(readlsbEvents, record, len, info);
+}
+
+char *readlsbAcctInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readInfoN(readlsbAcct, record, len, info);
+}
+
+char *readlsbStatusInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readInfoN(readlsbStatus, record, len, info);
+}
+
+/*
+ * Fill info with the job fields of a record without building its JSON
+ * text, for callers replaying a long history. Return 0 on success, -1 if
+ * the record could not be parsed.
+ */
+static int readJobInfoN(char *(*reader)(char *), const char *record, int len,
+		struct lsbJobInfo *info) {
+	char *line = lineBuffer(record, len);
+
+	memset(info, 0, sizeof(*info));
+	if (line == NULL) {
+		return -1;
+	}
+	jobInfo = info;
+	jobInfoOnly = 1;
+	jobInfoParsed = 0;
+	/* NULL, no JSON text is built */
+	free(reader(line));
+	jobInfo = NULL;
+	jobInfoOnly = 0;
+	return jobInfoParsed ? 0 : -1;
+}
+
+int readlsbStreamJobInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readJobInfoN(readlsbStream, record, len, info);
+}
+
+int readlsbEventsJobInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readJobInfoN(readlsbEvents, record, len, info);
+}
+
+int readlsbAcctJobInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readJobInfoN(readlsbAcct, record, len, info);
+}
+
+int readlsbStatusJobInfoN(const char *record, int len, struct lsbJobInfo *info) {
+	return readJobInfoN(readlsbStatus, record, len, info);
+}
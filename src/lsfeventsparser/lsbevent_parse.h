@@ -13,6 +13,63 @@ char *readlsbAcct(char *);
 
 char *readlsbStatus(char *);
 
+/* Same as above for a (pointer, length) record which need not be NUL
+ * terminated; the record is not retained after the call. */
+char *readlsbStreamN(const char *, int);
+
+char *readlsbEventsN(const char *, int);
+
+char *readlsbAcctN(const char *, int);
+
+char *readlsbStatusN(const char *, int);
+
+/* Kind of job event of a parsed record */
+enum lsbJobEvent {
+	LSB_JOB_EVENT_NONE = 0,
+	LSB_JOB_EVENT_NEW,
+	LSB_JOB_EVENT_START,
+	LSB_JOB_EVENT_START_ACCEPT,
+	LSB_JOB_EVENT_STATUS,
+	LSB_JOB_EVENT_STATUS2,
+	LSB_JOB_EVENT_SWITCH,
+	LSB_JOB_EVENT_MOVE,
+	LSB_JOB_EVENT_SIGNAL,
+	LSB_JOB_EVENT_REQUEUE,
+	LSB_JOB_EVENT_FORCE,
+	LSB_JOB_EVENT_FINISH
+};
+
+/* Job fields of a parsed record, for callers tracking job states. jStatus
+ * holds the LSF JOB_STAT_* bits, 0 for events which carry no status. */
+struct lsbJobInfo {
+	int eventType;
+	int jobId;
+	int idx;
+	int jStatus;
+	int exitStatus;
+	int exitInfo;
+};
+
+/* Same as the N variants, also filling info with the job fields of the
+ * record. */
+char *readlsbStreamInfoN(const char *, int, struct lsbJobInfo *);
+
+char *readlsbEventsInfoN(const char *, int, struct lsbJobInfo *);
+
+char *readlsbAcctInfoN(const char *, int, struct lsbJobInfo *);
+
+char *readlsbStatusInfoN(const char *, int, struct lsbJobInfo *);
+
+/* Only fill info, without building the JSON text. Return 0 on success,
+ * -1 if the record could not be parsed. */
+int readlsbStreamJobInfoN(const char *, int, struct lsbJobInfo *);
+
+int readlsbEventsJobInfoN(const char *, int, struct lsbJobInfo *);
+
+int readlsbAcctJobInfoN(const char *, int, struct lsbJobInfo *);
+
+int readlsbStatusJobInfoN(const char *, int, struct lsbJobInfo *);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,182 @@
+/************************************************************************
+ *
+ * LSB Stream Parse soak test
+ *
+ * lsbevent_parse_soak.c -- 2026-10-19
+ *
+ * Feed every record of a corpus file through one of the parser entry
+ * points, many rounds over. Built with -fsanitize=address (see the soak
+ * target in the Makefile) any record leaked by the parser makes the
+ * process exit non-zero at the end of the run.
+ *
+ * usage: lsbevent_parse_soak -t stream|events|acct|status [-n rounds] [-j] corpus
+ *
+ * -j only fills the job fields of each record, without the JSON text.
+ *
+ * A corpus may state the counts each round must give with comment lines
+ *
+ *     # expect <type>[-j] <parsed> <job events> <rejected>
+ *
+ * the soak fails if the counts of a round differ from those for its
+ * type and mode. soak/gencorpus.sh writes them for the corpora it makes.
+ *
+ ************************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lsbevent_parse.h"
+
+#define MAX_RECORD_LEN (1024 * 1024)
+
+typedef char *(*readFunc)(const char *, int, struct lsbJobInfo *);
+typedef int (*infoFunc)(const char *, int, struct lsbJobInfo *);
+
+static void usage(void) {
+	printf("usage: lsbevent_parse_soak -t stream|events|acct|status "
+			"[-n rounds] [-j] corpus\n");
+}
+
+/*
+ * Read the counts a corpus expects of each round for mode, "stream" or
+ * "stream-j" say. Return 1 if it states them, 0 otherwise.
+ */
+static int readExpect(FILE *fp, const char *mode, long *parsed, long *jobs,
+		long *failed, char *line) {
+	char name[64];
+	int found = 0;
+
+	rewind(fp);
+	while (fgets(line, MAX_RECORD_LEN, fp) != NULL) {
+		if (4 == sscanf(line, "# expect %63s %ld %ld %ld", name, parsed, jobs,
+				failed) && 0 == strcmp(name, mode)) {
+			found = 1;
+			break;
+		}
+	}
+	return found;
+}
+
+int main(int argc, char **argv) {
+	readFunc parse = NULL;
+	infoFunc parseInfo = NULL;
+	int infoOnly = 0;
+	const char *corpus = NULL;
+	const char *type = NULL;
+	char mode[64];
+	long rounds = 1;
+	long round, parsed = 0, failed = 0, jobs = 0;
+	long roundParsed, roundFailed, roundJobs;
+	long wantParsed = 0, wantJobs = 0, wantFailed = 0;
+	int expect, mismatch = 0;
+	struct lsbJobInfo info;
+	char *line;
+	FILE *fp;
+	clock_t start;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (0 == strcmp(argv[i], "-t") && i + 1 < argc) {
+			i++;
+			type = argv[i];
+			if (0 == strcmp(argv[i], "stream")) {
+				parse = readlsbStreamInfoN;
+				parseInfo = readlsbStreamJobInfoN;
+			} else if (0 == strcmp(argv[i], "events")) {
+				parse = readlsbEventsInfoN;
+				parseInfo = readlsbEventsJobInfoN;
+			} else if (0 == strcmp(argv[i], "acct")) {
+				parse = readlsbAcctInfoN;
+				parseInfo = readlsbAcctJobInfoN;
+			} else if (0 == strcmp(argv[i], "status")) {
+				parse = readlsbStatusInfoN;
+				parseInfo = readlsbStatusJobInfoN;
+			}
+		} else if (0 == strcmp(argv[i], "-j")) {
+			infoOnly = 1;
+		} else if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+			rounds = atol(argv[++i]);
+		} else {
+			corpus = argv[i];
+		}
+	}
+	if (parse == NULL || corpus == NULL || rounds <= 0) {
+		usage();
+		return -1;
+	}
+
+	fp = fopen(corpus, "r");
+	if (fp == NULL) {
+		printf("Cannot open corpus %s\n", corpus);
+		return -1;
+	}
+	line = malloc(MAX_RECORD_LEN);
+	if (line == NULL) {
+		fclose(fp);
+		return -1;
+	}
+
+	snprintf(mode, sizeof(mode), "%s%s", type, infoOnly ? "-j" : "");
+	expect = readExpect(fp, mode, &wantParsed, &wantJobs, &wantFailed, line);
+
+	start = clock();
+	for (round = 0; round < rounds; round++) {
+		roundParsed = parsed;
+		roundFailed = failed;
+		roundJobs = jobs;
+		rewind(fp);
+		while (fgets(line, MAX_RECORD_LEN, fp) != NULL) {
+			int len = strlen(line);
+			char *res;
+
+			while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+				len--;
+			}
+			if (len == 0 || line[0] == '#') {
+				continue;
+			}
+			if (infoOnly) {
+				if (parseInfo(line, len, &info) != 0) {
+					failed++;
+				} else {
+					parsed++;
+					if (info.eventType != LSB_JOB_EVENT_NONE) {
+						jobs++;
+					}
+				}
+				continue;
+			}
+			res = parse(line, len, &info);
+			if (res == NULL) {
+				failed++;
+			} else {
+				parsed++;
+				if (info.eventType != LSB_JOB_EVENT_NONE) {
+					jobs++;
+				}
+				free(res);
+			}
+		}
+		roundParsed = parsed - roundParsed;
+		roundFailed = failed - roundFailed;
+		roundJobs = jobs - roundJobs;
+		if (expect && (roundParsed != wantParsed || roundJobs != wantJobs
+				|| roundFailed != wantFailed)) {
+			printf("%s: round %ld of %s: %ld parsed, %ld job events, "
+					"%ld rejected, expected %ld, %ld, %ld\n", corpus, round + 1,
+					mode, roundParsed, roundJobs, roundFailed, wantParsed,
+					wantJobs, wantFailed);
+			mismatch = 1;
+			break;
+		}
+	}
+
+	printf("%s: %ld rounds, %ld records parsed, %ld job events, %ld rejected, "
+			"%.2fs cpu\n", corpus, rounds, parsed, jobs, failed,
+			(double) (clock() - start) / CLOCKS_PER_SEC);
+
+	free(line);
+	fclose(fp);
+	return mismatch;
+}
@@ -0,0 +1,801 @@
+/************************************************************************
+ *
+ * LSF MOCK
+ *
+ * lsbatch.h -- 2026-10-19
+ *
+ * Declares the subset of the LSF lsbatch.h structures, constants and
+ * APIs which the events parser uses, so that the parser can be built,
+ * tested and benchmarked on hosts without an LSF installation. Layout
+ * follows LSF 10.1; only members touched by lsbevent_parse.c and
+ * job_array.c are present, so a library built against this header must
+ * only be used with lsf_mock.c, never with a real LSF install.
+ *
+ ************************************************************************/
+
+#ifndef _LSBATCH_H_
+#define _LSBATCH_H_
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LSB_EVENT_VERSION9_1 "9.1"
+#define LSB_EVENT_VERSION10_1 "10.1"
+
+#define MAXFULLFILENAMELEN 4096
+#define MAX_VERSION_LEN 12
+
+typedef long long int LS_LONG_INT;
+typedef unsigned long long int LS_UNS_LONG_INT;
+
+#define LSB_ARRAY_IDX(jobId) \
+	(((jobId) == -1) ? (0) : (int)(((LS_UNS_LONG_INT)(jobId) >> 32) & 0xFFFFFFFF))
+#define LSB_ARRAY_JOBID(jobId) \
+	(((jobId) == -1) ? (-1) : (int)((jobId) & 0xFFFFFFFF))
+
+/* job status */
+#define JOB_STAT_NULL 0x00
+#define JOB_STAT_PEND 0x01
+#define JOB_STAT_PSUSP 0x02
+#define JOB_STAT_RUN 0x04
+#define JOB_STAT_SSUSP 0x08
+#define JOB_STAT_USUSP 0x10
+#define JOB_STAT_EXIT 0x20
+#define JOB_STAT_DONE 0x40
+#define JOB_STAT_PDONE 0x80
+#define JOB_STAT_PERR 0x100
+#define JOB_STAT_WAIT 0x200
+#define JOB_STAT_UNKWN 0x10000
+
+/* submission options */
+#define SUB_INTERACTIVE 0x2000
+#define SUB2_HOLD 0x04
+
+/* suspending reasons */
+#define SUSP_MBD_PREEMPT 0x02000000
+#define SUSP_HOST_RSVACTIVE 0x10000000
+#define SUSP_ADVRSV_EXPIRED 0x20000000
+
+#define AC_JOB_INFO_VMJOB 0x1
+
+/* resource limits */
+#define LSF_RLIMIT_CPU 0
+#define LSF_RLIMIT_FSIZE 1
+#define LSF_RLIMIT_DATA 2
+#define LSF_RLIMIT_STACK 3
+#define LSF_RLIMIT_CORE 4
+#define LSF_RLIMIT_RSS 5
+#define LSF_RLIMIT_NOFILE 6
+#define LSF_RLIMIT_OPEN_MAX 7
+#define LSF_RLIMIT_VMEM 8
+#define LSF_RLIMIT_SWAP LSF_RLIMIT_VMEM
+#define LSF_RLIMIT_RUN 9
+#define LSF_RLIMIT_PROCESS 10
+#define LSF_RLIMIT_THREAD 11
+#define LSF_RLIM_NLIMITS 12
+
+/* event types */
+#define EVENT_JOB_NEW 1
+#define EVENT_JOB_START 2
+#define EVENT_JOB_STATUS 3
+#define EVENT_JOB_SWITCH 4
+#define EVENT_JOB_MOVE 5
+#define EVENT_QUEUE_CTRL 6
+#define EVENT_HOST_CTRL 7
+#define EVENT_MBD_DIE 8
+#define EVENT_MBD_UNFULFILL 9
+#define EVENT_JOB_FINISH 10
+#define EVENT_LOAD_INDEX 11
+#define EVENT_CHKPNT 12
+#define EVENT_MIG 13
+#define EVENT_PRE_EXEC_START 14
+#define EVENT_MBD_START 15
+#define EVENT_JOB_ROUTE 16
+#define EVENT_JOB_MODIFY 17
+#define EVENT_JOB_SIGNAL 18
+#define EVENT_CAL_NEW 19
+#define EVENT_CAL_MODIFY 20
+#define EVENT_CAL_DELETE 21
+#define EVENT_JOB_FORWARD 22
+#define EVENT_JOB_ACCEPT 23
+#define EVENT_STATUS_ACK 24
+#define EVENT_JOB_EXECUTE 25
+#define EVENT_JOB_MSG 26
+#define EVENT_JOB_MSG_ACK 27
+#define EVENT_JOB_REQUEUE 28
+#define EVENT_JOB_OCCUPY_REQ 29
+#define EVENT_JOB_VACATED 30
+#define EVENT_JOB_SIGACT 32
+#define EVENT_SBD_JOB_STATUS 34
+#define EVENT_JOB_START_ACCEPT 35
+#define EVENT_CAL_UNDELETE 36
+#define EVENT_JOB_CLEAN 37
+#define EVENT_JOB_EXCEPTION 38
+#define EVENT_JGRP_ADD 39
+#define EVENT_JGRP_MOD 40
+#define EVENT_JGRP_CTRL 41
+#define EVENT_JOB_FORCE 42
+#define EVENT_LOG_SWITCH 43
+#define EVENT_JOB_MODIFY2 44
+#define EVENT_JGRP_STATUS 45
+#define EVENT_JOB_ATTR_SET 46
+#define EVENT_JOB_EXT_MSG 47
+#define EVENT_JOB_ATTA_DATA 48
+#define EVENT_JOB_CHUNK 49
+#define EVENT_SBD_UNREPORTED_STATUS 50
+#define EVENT_ADRSV_FINISH 51
+#define EVENT_HGHOST_CTRL 52
+#define EVENT_CPUPROFILE_STATUS 53
+#define EVENT_DATA_LOGGING 54
+#define EVENT_JOB_RUN_RUSAGE 55
+#define EVENT_END_OF_STREAM 56
+#define EVENT_SLA_RECOMPUTE 57
+#define EVENT_METRIC_LOG 58
+#define EVENT_TASK_FINISH 59
+#define EVENT_JOB_RESIZE_NOTIFY_START 60
+#define EVENT_JOB_RESIZE_NOTIFY_ACCEPT 61
+#define EVENT_JOB_RESIZE_NOTIFY_DONE 62
+#define EVENT_JOB_RESIZE_RELEASE 63
+#define EVENT_JOB_RESIZE_CANCEL 64
+#define EVENT_JOB_RESIZE 65
+#define EVENT_JOB_ARRAY_ELEMENT 66
+#define EVENT_MBD_SIM_STATUS 67
+#define EVENT_JOB_FINISH2 68
+#define EVENT_JOB_STARTLIMIT 69
+#define EVENT_JOB_STATUS2 70
+#define EVENT_JOB_PENDING_REASONS 71
+
+struct xFile {
+	char *subFn;
+	char *execFn;
+	int options;
+};
+
+struct lsfRusage {
+	double ru_utime;
+	double ru_stime;
+	double ru_maxrss;
+	double ru_ixrss;
+	double ru_ismrss;
+	double ru_idrss;
+	double ru_isrss;
+	double ru_minflt;
+	double ru_majflt;
+	double ru_nswap;
+	double ru_inblock;
+	double ru_oublock;
+	double ru_ioch;
+	double ru_msgsnd;
+	double ru_msgrcv;
+	double ru_nsignals;
+	double ru_nvcsw;
+	double ru_nivcsw;
+	double ru_exutime;
+};
+
+struct pidInfo {
+	int pid;
+	int ppid;
+	int pgid;
+	int jobid;
+};
+
+struct jRusage {
+	int mem;
+	int swap;
+	int utime;
+	int stime;
+	int npids;
+	struct pidInfo *pidInfo;
+	int npgids;
+	int *pgid;
+	int nthreads;
+};
+
+struct hRusage {
+	char *name;
+	int mem;
+	int swap;
+	int utime;
+	int stime;
+};
+
+struct jobNewLog {
+	int jobId;
+	int userId;
+	char *userName;
+	int options;
+	int options2;
+	int numProcessors;
+	time_t submitTime;
+	time_t beginTime;
+	time_t termTime;
+	int sigValue;
+	int chkpntPeriod;
+	int restartPid;
+	int rLimits[LSF_RLIM_NLIMITS];
+	char *hostSpec;
+	float hostFactor;
+	int umask;
+	char *queue;
+	char *resReq;
+	char *fromHost;
+	char *cwd;
+	char *subcwd;
+	char *chkpntDir;
+	char *inFile;
+	char *outFile;
+	char *errFile;
+	char *inFileSpool;
+	char *commandSpool;
+	char *jobSpoolDir;
+	char *subHomeDir;
+	char *jobFile;
+	int numAskedHosts;
+	char **askedHosts;
+	char *dependCond;
+	char *timeEvent;
+	char *jobName;
+	char *command;
+	int nxf;
+	struct xFile *xf;
+	char *preExecCmd;
+	char *mailUser;
+	char *projectName;
+	int niosPort;
+	int maxNumProcessors;
+	char *schedHostType;
+	char *loginShell;
+	char *userGroup;
+	char *exceptList;
+	int idx;
+	int userPriority;
+	char *rsvId;
+	char *jobGroup;
+	char *extsched;
+	int warningTimePeriod;
+	char *warningAction;
+	char *sla;
+	int SLArunLimit;
+	char *licenseProject;
+	int options3;
+	char *app;
+	char *postExecCmd;
+	int runtimeEstimation;
+	char *requeueEValues;
+	char *jobDescription;
+	char *srcCluster;
+	char *flow_id;
+};
+
+struct jobModLog {
+	char *jobIdStr;
+	int options;
+	int options2;
+	int delOptions;
+	int delOptions2;
+	int userId;
+	char *userName;
+	int submitTime;
+	int umask;
+	int numProcessors;
+	int beginTime;
+	int termTime;
+	int sigValue;
+	int restartPid;
+	char *jobName;
+	char *queue;
+	int numAskedHosts;
+	char **askedHosts;
+	char *resReq;
+	int rLimits[LSF_RLIM_NLIMITS];
+	char *hostSpec;
+	char *dependCond;
+	char *timeEvent;
+	char *subHomeDir;
+	char *inFile;
+	char *outFile;
+	char *errFile;
+	char *command;
+	char *inFileSpool;
+	char *commandSpool;
+	int chkpntPeriod;
+	char *chkpntDir;
+	int nxf;
+	struct xFile *xf;
+	char *jobFile;
+	char *fromHost;
+	char *cwd;
+	char *preExecCmd;
+	char *mailUser;
+	char *projectName;
+	int niosPort;
+	int maxNumProcessors;
+	char *loginShell;
+	char *schedHostType;
+	char *userGroup;
+	char *exceptList;
+	int userPriority;
+	char *rsvId;
+	char *extsched;
+	int warningTimePeriod;
+	char *warningAction;
+	char *jobGroup;
+	char *sla;
+	char *licenseProject;
+	int options3;
+	int delOptions3;
+	char *app;
+	char *apsString;
+	char *postExecCmd;
+	int runtimeEstimation;
+};
+
+struct jobStartLog {
+	int jobId;
+	int jStatus;
+	int jobPid;
+	int jobPGid;
+	float hostFactor;
+	int numExHosts;
+	char **execHosts;
+	char *queuePreCmd;
+	char *queuePostCmd;
+	int jFlags;
+	char *userGroup;
+	int idx;
+	char *additionalInfo;
+	int duration4PreemptBackfill;
+	char *effectiveResReq;
+	int numAllocSlots;
+	char **allocSlots;
+};
+
+struct jobStartAcceptLog {
+	int jobId;
+	int jobPid;
+	int jobPGid;
+	int idx;
+};
+
+struct jobExecuteLog {
+	int jobId;
+	int execUid;
+	char *execHome;
+	char *execCwd;
+	int jobPGid;
+	char *execUsername;
+	int jobPid;
+	int idx;
+	char *additionalInfo;
+	int SLAscaledRunLimit;
+	int position;
+	char *execRusage;
+	int duration4PreemptBackfill;
+};
+
+struct jobStatusLog {
+	int jobId;
+	int jStatus;
+	int reason;
+	int subreasons;
+	float cpuTime;
+	time_t endTime;
+	int ru;
+	struct lsfRusage lsfRusage;
+	int jFlags;
+	int exitStatus;
+	int idx;
+	int exitInfo;
+	int maxMem;
+	int avgMem;
+};
+
+struct sbdUnreportedStatusLog {
+	int jobId;
+	int actPid;
+	int jobPid;
+	int jobPGid;
+	int newStatus;
+	int reason;
+	int subreasons;
+	struct lsfRusage lsfRusage;
+	int execUid;
+	int exitStatus;
+	char *execCwd;
+	char *execHome;
+	char *execUsername;
+	int msgId;
+	struct jRusage runRusage;
+	int sigValue;
+	int actStatus;
+	int seq;
+	int idx;
+	int exitInfo;
+};
+
+struct jobSwitchLog {
+	int userId;
+	int jobId;
+	char *queue;
+	int idx;
+	char *userName;
+};
+
+struct jobMoveLog {
+	int userId;
+	int jobId;
+	int position;
+	int base;
+	int idx;
+	char *userName;
+};
+
+struct unfulfillLog {
+	int jobId;
+	int notSwitched;
+	int sig;
+	int sig1;
+	int sig1Flags;
+	time_t chkPeriod;
+	int notModified;
+	int idx;
+	int miscOpts4PendSig;
+};
+
+struct jobFinishLog {
+	int jobId;
+	int userId;
+	char *userName;
+	int options;
+	int numProcessors;
+	int jStatus;
+	time_t submitTime;
+	time_t beginTime;
+	time_t termTime;
+	time_t startTime;
+	time_t endTime;
+	char *queue;
+	char *resReq;
+	char *fromHost;
+	char *cwd;
+	char *subcwd;
+	char *inFile;
+	char *outFile;
+	char *errFile;
+	char *inFileSpool;
+	char *commandSpool;
+	char *jobFile;
+	int numAskedHosts;
+	char **askedHosts;
+	float hostFactor;
+	int numExHosts;
+	char **execHosts;
+	float cpuTime;
+	char *jobName;
+	char *command;
+	struct lsfRusage lsfRusage;
+	char *dependCond;
+	char *timeEvent;
+	char *preExecCmd;
+	char *mailUser;
+	char *projectName;
+	int exitStatus;
+	int maxNumProcessors;
+	char *loginShell;
+	int idx;
+	int maxRMem;
+	int maxRSwap;
+	char *rsvId;
+	char *sla;
+	int exceptMask;
+	char *additionalInfo;
+	int exitInfo;
+	int warningTimePeriod;
+	char *warningAction;
+	char *chargedSAAP;
+	char *licenseProject;
+	char *app;
+	char *postExecCmd;
+	int runtimeEstimation;
+	char *jgroup;
+	char *effectiveResReq;
+	int totalProvisionTime;
+	int runTime;
+	int runLimit;
+	int avgMem;
+	char *jobDescription;
+	char *flow_id;
+	int numhRusages;
+	struct hRusage *hostRusage;
+	int numAllocSlots;
+	char **allocSlots;
+};
+
+struct jobFinish2Log {
+	LS_LONG_INT jobId;
+	int userId;
+	char *userName;
+	int options;
+	int options2;
+	int options3;
+	int numProcessors;
+	int jStatus;
+	time_t submitTime;
+	time_t beginTime;
+	time_t termTime;
+	time_t startTime;
+	time_t endTime;
+	time_t forwardTime;
+	char *queue;
+	char *resReq;
+	char *fromHost;
+	char *cwd;
+	char *inFile;
+	char *outFile;
+	char *jobFile;
+	int numExHosts;
+	char **execHosts;
+	int *slotUsages;
+	float cpuTime;
+	char *jobName;
+	char *command;
+	struct lsfRusage lsfRusage;
+	char *preExecCmd;
+	char *postExecCmd;
+	char *projectName;
+	int exitStatus;
+	int maxNumProcessors;
+	char *sla;
+	int exitInfo;
+	int exceptMask;
+	char *chargedSAAP;
+	char *licenseProject;
+	char *app;
+	char *jgroup;
+	char *execRusage;
+	char *clusterName;
+	char *userGroup;
+	int runtime;
+	int runLimit;
+	char *jobDescription;
+	char *requeueEValues;
+	char *dependCond;
+	float hostFactor;
+	char *rsvId;
+	char *effectiveResReq;
+	char *flow_id;
+	char *srcCluster;
+	LS_LONG_INT srcJobId;
+	char *dstCluster;
+	LS_LONG_INT dstJobId;
+	int totalProvisionTime;
+	int dcJobFlags;
+	int numhRusages;
+	struct hRusage *hostRusage;
+};
+
+struct jobStartLimitLog {
+	LS_LONG_INT jobId;
+	char *clusterName;
+	int lsfLimits[LSF_RLIM_NLIMITS];
+	int jobRlimits[LSF_RLIM_NLIMITS];
+};
+
+struct jobStatus2Log {
+	LS_LONG_INT jobId;
+	char *userName;
+	int sampleInterval;
+	int numProcessors;
+	int num_processors;
+	int numJobs;
+	int jStatus;
+	int reason;
+	time_t submitTime;
+	time_t startTime;
+	time_t endTime;
+	char *queue;
+	char *resReq;
+	char *projectName;
+	char *jgroup;
+	struct lsfRusage lsfRusage;
+	int numExHosts;
+	char **execHosts;
+	int *slotUsages;
+	char *app;
+	char *execRusage;
+	char *clusterName;
+	char *userGroup;
+	int runtimeDelta;
+	int jobRmtAttr;
+	int provtimeDelta;
+	int dcJobFlags;
+	int numhRusages;
+	struct hRusage *hostRusage;
+};
+
+struct migLog {
+	int jobId;
+	int numAskedHosts;
+	char **askedHosts;
+	int userId;
+	int idx;
+	char *userName;
+};
+
+struct signalLog {
+	int userId;
+	int jobId;
+	char *signalSymbol;
+	int runCount;
+	int idx;
+	char *userName;
+};
+
+struct jobForwardLog {
+	int jobId;
+	char *cluster;
+	int numReserHosts;
+	char **reserHosts;
+	int idx;
+	int jobRmtAttr;
+};
+
+struct jobAcceptLog {
+	int jobId;
+	LS_LONG_INT remoteJid;
+	char *cluster;
+	int idx;
+	int jobRmtAttr;
+};
+
+struct sigactLog {
+	int jobId;
+	time_t period;
+	int pid;
+	int jStatus;
+	int reasons;
+	int flags;
+	char *signalSymbol;
+	int actStatus;
+	int idx;
+};
+
+struct jobRequeueLog {
+	int jobId;
+	int idx;
+};
+
+struct jobCleanLog {
+	int jobId;
+	int idx;
+};
+
+struct jobExceptionLog {
+	int jobId;
+	int exceptMask;
+	int actMask;
+	time_t timeEvent;
+	int exceptInfo;
+	int idx;
+};
+
+struct jobExternalMsgLog {
+	int jobId;
+	int idx;
+	int msgIdx;
+	char *desc;
+	int userId;
+	long dataSize;
+	time_t postTime;
+	int dataStatus;
+	char *fileName;
+	char *userName;
+};
+
+struct jobChunkLog {
+	long membSize;
+	LS_LONG_INT *membJobId;
+	long numExHosts;
+	char **execHosts;
+};
+
+struct jobForceRequestLog {
+	int userId;
+	int numExecHosts;
+	char **execHosts;
+	int jobId;
+	int idx;
+	int options;
+	char *userName;
+	char *queue;
+};
+
+struct jobRunRusageLog {
+	int jobid;
+	int idx;
+	struct jRusage jrusage;
+};
+
+struct perfmonLog {
+	int samplePeriod;
+	int totalQueries;
+	int jobQuries;
+	int queueQuries;
+	int hostQuries;
+	int submissionRequest;
+	int jobSubmitted;
+	int dispatchedjobs;
+	int jobcompleted;
+	int jobMCSend;
+	int jobMCReceive;
+	time_t startTime;
+	int mbdFreeHandle;
+	int mbdUsedHandle;
+	int scheduleInterval;
+	int hostRequirements;
+	int jobBuckets;
+};
+
+union eventLog {
+	struct jobNewLog jobNewLog;
+	struct jobStartLog jobStartLog;
+	struct jobStatusLog jobStatusLog;
+	struct sbdUnreportedStatusLog sbdUnreportedStatusLog;
+	struct jobSwitchLog jobSwitchLog;
+	struct jobMoveLog jobMoveLog;
+	struct unfulfillLog unfulfillLog;
+	struct jobFinishLog jobFinishLog;
+	struct jobFinish2Log jobFinish2Log;
+	struct jobStartLimitLog jobStartLimitLog;
+	struct jobStatus2Log jobStatus2Log;
+	struct migLog migLog;
+	struct jobModLog jobModLog;
+	struct signalLog signalLog;
+	struct jobForwardLog jobForwardLog;
+	struct jobAcceptLog jobAcceptLog;
+	struct jobStartAcceptLog jobStartAcceptLog;
+	struct sigactLog sigactLog;
+	struct jobExecuteLog jobExecuteLog;
+	struct jobRequeueLog jobRequeueLog;
+	struct jobCleanLog jobCleanLog;
+	struct jobExceptionLog jobExceptionLog;
+	struct jobExternalMsgLog jobExternalMsgLog;
+	struct jobChunkLog jobChunkLog;
+	struct jobForceRequestLog jobForceRequestLog;
+	struct jobRunRusageLog jobRunRusageLog;
+	struct perfmonLog perfmonLog;
+};
+
+struct eventRec {
+	char version[MAX_VERSION_LEN];
+	int type;
+	time_t eventTime;
+	union eventLog eventLog;
+};
+
+struct parameterInfo {
+	int maxJobArraySize;
+};
+
+/* liblsf / libbat */
+extern int lsb_init(char *appName);
+extern char *ls_getclustername(void);
+extern struct parameterInfo *lsb_parameterinfo(char **names, int *numUsers,
+		int options);
+extern int lsb_geteventrecbyline(char *line, struct eventRec *logRec);
+
+/* liblsbstream */
+extern struct eventRec *lsb_readstreamlineMT(const char *line);
+extern void lsb_freelogrec(struct eventRec *logRec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LSBATCH_H_ */
@@ -0,0 +1,1405 @@
+/************************************************************************
+ *
+ * LSF MOCK
+ *
+ * lsf_mock.c -- 2026-10-19
+ *
+ * Stand-in for the LSF entry points used by the events parser, so it can
+ * be built, tested and benchmarked without an LSF installation.
+ *
+ * Every record type the parser handles is understood, fields in the
+ * lsb.events(5) order, JOB_FINISH2 and JOB_STATUS2 as key/value lists;
+ * MBD_START is read as a header only record. Every string and array
+ * member is heap allocated, like the real library does, so leak checkers
+ * see the same ownership. Like the real library a record of any other
+ * type, short of a field, with a malformed number or with a count beyond
+ * the record fails with -1/NULL.
+ *
+ * EXPORTED ROUTINES:
+ *
+ * lsb_geteventrecbyline() - parse a record into a caller owned eventRec.
+ * lsb_readstreamlineMT() - parse a record into a new eventRec.
+ * lsb_freelogrec() - free an eventRec from lsb_readstreamlineMT().
+ * ls_getclustername() - $LSF_MOCK_CLUSTER or "mock_cluster".
+ * lsb_init(), lsb_parameterinfo() - fixed parameters.
+ *
+ ************************************************************************/
+
+#include "lsbatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FREEUP(pointer)                                                        \
+  if (pointer != NULL) {                                                       \
+    free(pointer);                                                             \
+    pointer = NULL;                                                            \
+  }
+
+/* tokenized record, every token is a NUL terminated copy */
+struct tokens {
+	char **tok;
+	int num;
+	int cur;
+	int bad; /* a field was missing or malformed */
+};
+
+/*
+ * Split a record into tokens. Quoted tokens may contain blanks and ""
+ * for an embedded quote, the quotes themselves are dropped.
+ */
+static int tokenize(const char *line, struct tokens *t) {
+	const char *p = line;
+	int size = 64;
+	char *buf;
+	int len;
+
+	t->num = 0;
+	t->cur = 0;
+	t->bad = 0;
+	t->tok = malloc(size * sizeof(char *));
+	if (t->tok == NULL) {
+		return -1;
+	}
+	buf = malloc(strlen(line) + 1);
+	if (buf == NULL) {
+		FREEUP(t->tok);
+		return -1;
+	}
+
+	for (;;) {
+		while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+			p++;
+		}
+		if (*p == '\0') {
+			break;
+		}
+		len = 0;
+		if (*p == '"') {
+			p++;
+			while (*p) {
+				if (*p == '"' && p[1] == '"') {
+					buf[len++] = '"';
+					p += 2;
+				} else if (*p == '"') {
+					p++;
+					break;
+				} else {
+					buf[len++] = *p++;
+				}
+			}
+		} else {
+			while (*p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+				buf[len++] = *p++;
+			}
+		}
+		buf[len] = '\0';
+		if (t->num == size) {
+			char **tok = realloc(t->tok, 2 * size * sizeof(char *));
+			if (tok == NULL) {
+				free(buf);
+				return -1;
+			}
+			t->tok = tok;
+			size *= 2;
+		}
+		t->tok[t->num++] = strdup(buf);
+	}
+	free(buf);
+	return 0;
+}
+
+static void freeTokens(struct tokens *t) {
+	int i;
+
+	for (i = 0; i < t->num; i++) {
+		free(t->tok[i]);
+	}
+	FREEUP(t->tok);
+}
+
+/* next token, "" and the record marked bad once it is exhausted */
+static const char *next(struct tokens *t) {
+	if (t->cur < t->num) {
+		return t->tok[t->cur++];
+	}
+	t->bad = 1;
+	return "";
+}
+
+static LS_LONG_INT nextLong(struct tokens *t) {
+	const char *tok = next(t);
+	char *end;
+	LS_LONG_INT val = strtoll(tok, &end, 10);
+
+	if (end == tok || *end != '\0') {
+		t->bad = 1;
+	}
+	return val;
+}
+
+static int nextInt(struct tokens *t) {
+	return (int) nextLong(t);
+}
+
+/* an integer field which may be missing, 0 if the next token is not one */
+static int nextOptInt(struct tokens *t) {
+	char *end;
+	int val;
+
+	if (t->cur >= t->num) {
+		return 0;
+	}
+	val = (int) strtol(t->tok[t->cur], &end, 10);
+	if (end == t->tok[t->cur] || *end != '\0') {
+		return 0;
+	}
+	t->cur++;
+	return val;
+}
+
+static double nextDouble(struct tokens *t) {
+	const char *tok = next(t);
+	char *end;
+	double val = strtod(tok, &end);
+
+	if (end == tok || *end != '\0') {
+		t->bad = 1;
+	}
+	return val;
+}
+
+/* a count of the items following it, at most one token each */
+static int nextCount(struct tokens *t) {
+	int num = nextInt(t);
+
+	if (num < 0 || num > t->num - t->cur) {
+		t->bad = 1;
+		return 0;
+	}
+	return num;
+}
+
+/* a count of the key/value pairs following it */
+static int nextPairs(struct tokens *t) {
+	int num = nextInt(t);
+
+	if (num < 0 || num > (t->num - t->cur) / 2) {
+		t->bad = 1;
+		return 0;
+	}
+	return num;
+}
+
+static char *nextStr(struct tokens *t) {
+	return strdup(next(t));
+}
+
+/* a count and that many strings, the count is 0 if they are not there */
+static char **nextStrArray(struct tokens *t, int *num) {
+	char **array;
+	int i;
+
+	*num = nextCount(t);
+	if (*num == 0) {
+		return NULL;
+	}
+	array = calloc(*num, sizeof(char *));
+	if (array == NULL) {
+		*num = 0;
+		return NULL;
+	}
+	for (i = 0; i < *num; i++) {
+		array[i] = nextStr(t);
+	}
+	return array;
+}
+
+/* one copy of each string, as LSF keeps allocSlots apart from execHosts */
+static char **copyStrArray(char **array, int num) {
+	char **copy;
+	int i;
+
+	if (num == 0) {
+		return NULL;
+	}
+	copy = calloc(num, sizeof(char *));
+	if (copy == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < num; i++) {
+		copy[i] = strdup(array[i]);
+	}
+	return copy;
+}
+
+static void freeStrArray(char ***array, int num) {
+	int i;
+
+	for (i = 0; i < num; i++) {
+		free((*array)[i]);
+	}
+	FREEUP(*array);
+}
+
+static void nextRusage(struct tokens *t, struct lsfRusage *ru) {
+	ru->ru_utime = nextDouble(t);
+	ru->ru_stime = nextDouble(t);
+	ru->ru_maxrss = nextDouble(t);
+	ru->ru_ixrss = nextDouble(t);
+	ru->ru_ismrss = nextDouble(t);
+	ru->ru_idrss = nextDouble(t);
+	ru->ru_isrss = nextDouble(t);
+	ru->ru_minflt = nextDouble(t);
+	ru->ru_majflt = nextDouble(t);
+	ru->ru_nswap = nextDouble(t);
+	ru->ru_inblock = nextDouble(t);
+	ru->ru_oublock = nextDouble(t);
+	ru->ru_ioch = nextDouble(t);
+	ru->ru_msgsnd = nextDouble(t);
+	ru->ru_msgrcv = nextDouble(t);
+	ru->ru_nsignals = nextDouble(t);
+	ru->ru_nvcsw = nextDouble(t);
+	ru->ru_nivcsw = nextDouble(t);
+	ru->ru_exutime = nextDouble(t);
+}
+
+/* split a blank separated key/value value into an array */
+static int splitList(const char *value, char ***array) {
+	struct tokens t;
+	int num;
+
+	*array = NULL;
+	if (tokenize(value, &t) < 0) {
+		freeTokens(&t);
+		return 0;
+	}
+	num = t.num;
+	if (num > 0) {
+		*array = t.tok;
+		t.tok = NULL;
+		t.num = 0;
+	}
+	freeTokens(&t);
+	return num;
+}
+
+static int *splitIntList(const char *value, int *num) {
+	char **list;
+	int *ints = NULL;
+	int i;
+
+	*num = splitList(value, &list);
+	if (*num > 0) {
+		ints = calloc(*num, sizeof(int));
+		for (i = 0; i < *num; i++) {
+			ints[i] = atoi(list[i]);
+			free(list[i]);
+		}
+		free(list);
+	}
+	return ints;
+}
+
+static void readMetricLog(struct tokens *t, struct perfmonLog *l) {
+	l->startTime = nextInt(t);
+	l->samplePeriod = nextInt(t);
+	l->totalQueries = nextInt(t);
+	l->jobQuries = nextInt(t);
+	l->queueQuries = nextInt(t);
+	l->hostQuries = nextInt(t);
+	l->submissionRequest = nextInt(t);
+	l->jobSubmitted = nextInt(t);
+	l->dispatchedjobs = nextInt(t);
+	l->jobcompleted = nextInt(t);
+	l->jobMCSend = nextInt(t);
+	l->jobMCReceive = nextInt(t);
+	l->mbdFreeHandle = nextInt(t);
+	l->mbdUsedHandle = nextInt(t);
+	l->scheduleInterval = nextInt(t);
+	l->hostRequirements = nextInt(t);
+	l->jobBuckets = nextInt(t);
+}
+
+static void readJobStatus(struct tokens *t, struct jobStatusLog *l) {
+	l->jobId = nextInt(t);
+	l->jStatus = nextInt(t);
+	l->reason = nextInt(t);
+	l->subreasons = nextInt(t);
+	l->cpuTime = nextDouble(t);
+	l->endTime = nextInt(t);
+	l->ru = nextInt(t);
+	if (l->ru) {
+		nextRusage(t, &l->lsfRusage);
+	}
+	l->jFlags = nextInt(t);
+	l->exitStatus = nextInt(t);
+	l->idx = nextInt(t);
+	/* not written by every LSF version */
+	l->exitInfo = nextOptInt(t);
+}
+
+static void readJobStart(struct tokens *t, struct jobStartLog *l) {
+	l->jobId = nextInt(t);
+	l->jStatus = nextInt(t);
+	l->jobPid = nextInt(t);
+	l->jobPGid = nextInt(t);
+	l->hostFactor = nextDouble(t);
+	l->execHosts = nextStrArray(t, &l->numExHosts);
+	l->queuePreCmd = nextStr(t);
+	l->queuePostCmd = nextStr(t);
+	l->jFlags = nextInt(t);
+	l->userGroup = nextStr(t);
+	l->idx = nextInt(t);
+	l->additionalInfo = nextStr(t);
+	l->duration4PreemptBackfill = nextInt(t);
+	l->effectiveResReq = nextStr(t);
+	l->allocSlots = copyStrArray(l->execHosts, l->numExHosts);
+	l->numAllocSlots = l->allocSlots ? l->numExHosts : 0;
+}
+
+static void readJobExecute(struct tokens *t, struct jobExecuteLog *l) {
+	l->jobId = nextInt(t);
+	l->execUid = nextInt(t);
+	l->jobPGid = nextInt(t);
+	l->execCwd = nextStr(t);
+	l->execHome = nextStr(t);
+	l->execUsername = nextStr(t);
+	l->jobPid = nextInt(t);
+	l->idx = nextInt(t);
+	l->additionalInfo = nextStr(t);
+	l->SLAscaledRunLimit = nextInt(t);
+	l->execRusage = nextStr(t);
+	l->position = nextInt(t);
+	l->duration4PreemptBackfill = nextInt(t);
+}
+
+static void readJobFinish(struct tokens *t, struct jobFinishLog *l) {
+	int i;
+
+	l->jobId = nextInt(t);
+	l->userId = nextInt(t);
+	l->options = nextInt(t);
+	l->numProcessors = nextInt(t);
+	l->submitTime = nextInt(t);
+	l->beginTime = nextInt(t);
+	l->termTime = nextInt(t);
+	l->startTime = nextInt(t);
+	l->userName = nextStr(t);
+	l->queue = nextStr(t);
+	l->resReq = nextStr(t);
+	l->dependCond = nextStr(t);
+	l->preExecCmd = nextStr(t);
+	l->fromHost = nextStr(t);
+	l->cwd = nextStr(t);
+	l->inFile = nextStr(t);
+	l->outFile = nextStr(t);
+	l->errFile = nextStr(t);
+	l->jobFile = nextStr(t);
+	l->askedHosts = nextStrArray(t, &l->numAskedHosts);
+	l->execHosts = nextStrArray(t, &l->numExHosts);
+	l->jStatus = nextInt(t);
+	l->hostFactor = nextDouble(t);
+	l->jobName = nextStr(t);
+	l->command = nextStr(t);
+	nextRusage(t, &l->lsfRusage);
+	l->mailUser = nextStr(t);
+	l->projectName = nextStr(t);
+	l->exitStatus = nextInt(t);
+	l->maxNumProcessors = nextInt(t);
+	l->loginShell = nextStr(t);
+	l->timeEvent = nextStr(t);
+	l->idx = nextInt(t);
+	l->maxRMem = nextInt(t);
+	l->maxRSwap = nextInt(t);
+	l->inFileSpool = nextStr(t);
+	l->commandSpool = nextStr(t);
+	l->rsvId = nextStr(t);
+	l->sla = nextStr(t);
+	l->exceptMask = nextInt(t);
+	l->additionalInfo = nextStr(t);
+	l->exitInfo = nextInt(t);
+	l->warningAction = nextStr(t);
+	l->warningTimePeriod = nextInt(t);
+	l->chargedSAAP = nextStr(t);
+	l->licenseProject = nextStr(t);
+	l->app = nextStr(t);
+	l->postExecCmd = nextStr(t);
+	l->runtimeEstimation = nextInt(t);
+	l->jgroup = nextStr(t);
+	l->endTime = 0;
+	l->allocSlots = copyStrArray(l->execHosts, l->numExHosts);
+	l->numAllocSlots = l->allocSlots ? l->numExHosts : 0;
+	if (l->numExHosts > 0) {
+		l->hostRusage = calloc(l->numExHosts, sizeof(struct hRusage));
+	}
+	if (l->hostRusage != NULL) {
+		l->numhRusages = l->numExHosts;
+		for (i = 0; i < l->numhRusages; i++) {
+			l->hostRusage[i].name = strdup(l->execHosts[i]);
+		}
+	}
+}
+
+#define KEY_STR(name, field)                                                   \
+  if (0 == strcmp(key, name)) {                                                \
+    FREEUP(field);                                                             \
+    field = strdup(value);                                                     \
+    continue;                                                                  \
+  }
+#define KEY_INT(name, field)                                                   \
+  if (0 == strcmp(key, name)) {                                                \
+    field = atoi(value);                                                       \
+    continue;                                                                  \
+  }
+#define KEY_DOUBLE(name, field)                                                \
+  if (0 == strcmp(key, name)) {                                                \
+    field = atof(value);                                                       \
+    continue;                                                                  \
+  }
+
+static void readJobFinish2(struct tokens *t, struct jobFinish2Log *l) {
+	int i, num, numSlots = 0;
+
+	l->jobId = nextLong(t);
+	num = nextPairs(t);
+	for (i = 0; i < num; i++) {
+		const char *key = next(t);
+		const char *value = next(t);
+
+		KEY_INT("userId", l->userId);
+		KEY_STR("userName", l->userName);
+		KEY_INT("numProcessors", l->numProcessors);
+		KEY_INT("options", l->options);
+		KEY_INT("options2", l->options2);
+		KEY_INT("jStatus", l->jStatus);
+		KEY_INT("submitTime", l->submitTime);
+		KEY_INT("termTime", l->termTime);
+		KEY_INT("startTime", l->startTime);
+		KEY_INT("endTime", l->endTime);
+		KEY_STR("queue", l->queue);
+		KEY_STR("fromHost", l->fromHost);
+		KEY_STR("cwd", l->cwd);
+		KEY_STR("jobFile", l->jobFile);
+		KEY_DOUBLE("cpuTime", l->cpuTime);
+		KEY_STR("command", l->command);
+		KEY_STR("jobName", l->jobName);
+		KEY_DOUBLE("ru_utime", l->lsfRusage.ru_utime);
+		KEY_DOUBLE("ru_stime", l->lsfRusage.ru_stime);
+		KEY_DOUBLE("ru_maxrss", l->lsfRusage.ru_maxrss);
+		KEY_DOUBLE("ru_nswap", l->lsfRusage.ru_nswap);
+		KEY_STR("projectName", l->projectName);
+		KEY_INT("exitStatus", l->exitStatus);
+		KEY_INT("maxNumProcessors", l->maxNumProcessors);
+		KEY_INT("exitInfo", l->exitInfo);
+		KEY_INT("exceptMask", l->exceptMask);
+		KEY_STR("chargedSAAP", l->chargedSAAP);
+		KEY_INT("runtime", l->runtime);
+		KEY_STR("effectiveResReq", l->effectiveResReq);
+		KEY_STR("app", l->app);
+		KEY_STR("userGroup", l->userGroup);
+		KEY_DOUBLE("hostFactor", l->hostFactor);
+		if (0 == strcmp(key, "execHosts")) {
+			int j;
+			for (j = 0; j < l->numExHosts; j++) {
+				free(l->execHosts[j]);
+			}
+			FREEUP(l->execHosts);
+			l->numExHosts = splitList(value, &l->execHosts);
+			continue;
+		}
+		if (0 == strcmp(key, "slotUsages")) {
+			FREEUP(l->slotUsages);
+			l->slotUsages = splitIntList(value, &numSlots);
+			continue;
+		}
+	}
+	/* keep slotUsages in step with execHosts */
+	if (l->numExHosts > 0 && numSlots < l->numExHosts) {
+		int *slots = calloc(l->numExHosts, sizeof(int));
+		for (i = 0; i < l->numExHosts; i++) {
+			slots[i] = i < numSlots ? l->slotUsages[i] : 1;
+		}
+		FREEUP(l->slotUsages);
+		l->slotUsages = slots;
+	}
+}
+
+static void readJobStatus2(struct tokens *t, struct jobStatus2Log *l) {
+	int i, num, numSlots = 0;
+
+	l->jobId = nextLong(t);
+	num = nextPairs(t);
+	for (i = 0; i < num; i++) {
+		const char *key = next(t);
+		const char *value = next(t);
+
+		KEY_STR("userName", l->userName);
+		KEY_INT("sampleInterval", l->sampleInterval);
+		KEY_INT("numProcessors", l->numProcessors);
+		KEY_INT("numJobs", l->numJobs);
+		KEY_INT("jStatus", l->jStatus);
+		KEY_INT("reason", l->reason);
+		KEY_INT("submitTime", l->submitTime);
+		KEY_INT("startTime", l->startTime);
+		KEY_INT("endTime", l->endTime);
+		KEY_STR("queue", l->queue);
+		KEY_STR("resReq", l->resReq);
+		KEY_STR("projectName", l->projectName);
+		KEY_STR("jgroup", l->jgroup);
+		KEY_DOUBLE("ru_utime", l->lsfRusage.ru_utime);
+		KEY_DOUBLE("ru_stime", l->lsfRusage.ru_stime);
+		KEY_DOUBLE("ru_maxrss", l->lsfRusage.ru_maxrss);
+		KEY_DOUBLE("ru_nswap", l->lsfRusage.ru_nswap);
+		KEY_STR("app", l->app);
+		KEY_STR("userGroup", l->userGroup);
+		KEY_INT("runtimeDelta", l->runtimeDelta);
+		if (0 == strcmp(key, "execHosts")) {
+			int j;
+			for (j = 0; j < l->numExHosts; j++) {
+				free(l->execHosts[j]);
+			}
+			FREEUP(l->execHosts);
+			l->numExHosts = splitList(value, &l->execHosts);
+			continue;
+		}
+		if (0 == strcmp(key, "slotUsages")) {
+			FREEUP(l->slotUsages);
+			l->slotUsages = splitIntList(value, &numSlots);
+			continue;
+		}
+	}
+	if (l->numExHosts > 0 && numSlots < l->numExHosts) {
+		int *slots = calloc(l->numExHosts, sizeof(int));
+		for (i = 0; i < l->numExHosts; i++) {
+			slots[i] = i < numSlots ? l->slotUsages[i] : 1;
+		}
+		FREEUP(l->slotUsages);
+		l->slotUsages = slots;
+	}
+}
+
+static void nextRLimits(struct tokens *t, int *rLimits) {
+	int i;
+
+	for (i = 0; i < LSF_RLIM_NLIMITS; i++) {
+		rLimits[i] = nextInt(t);
+	}
+}
+
+static struct xFile *nextXFiles(struct tokens *t, int *nxf) {
+	struct xFile *xf;
+	int i;
+
+	*nxf = nextCount(t);
+	if (*nxf == 0) {
+		return NULL;
+	}
+	xf = calloc(*nxf, sizeof(struct xFile));
+	if (xf == NULL) {
+		*nxf = 0;
+		return NULL;
+	}
+	for (i = 0; i < *nxf; i++) {
+		xf[i].subFn = nextStr(t);
+		xf[i].execFn = nextStr(t);
+		xf[i].options = nextInt(t);
+	}
+	return xf;
+}
+
+static void freeXFiles(struct xFile **xf, int nxf) {
+	int i;
+
+	for (i = 0; i < nxf; i++) {
+		free((*xf)[i].subFn);
+		free((*xf)[i].execFn);
+	}
+	FREEUP(*xf);
+}
+
+static void nextJRusage(struct tokens *t, struct jRusage *ru) {
+	int i;
+
+	ru->mem = nextInt(t);
+	ru->swap = nextInt(t);
+	ru->utime = nextInt(t);
+	ru->stime = nextInt(t);
+	ru->npids = nextCount(t);
+	if (ru->npids > 0) {
+		ru->pidInfo = calloc(ru->npids, sizeof(struct pidInfo));
+		if (ru->pidInfo == NULL) {
+			ru->npids = 0;
+		}
+		for (i = 0; i < ru->npids; i++) {
+			ru->pidInfo[i].pid = nextInt(t);
+			ru->pidInfo[i].ppid = nextInt(t);
+			ru->pidInfo[i].pgid = nextInt(t);
+			ru->pidInfo[i].jobid = nextInt(t);
+		}
+	}
+	ru->npgids = nextCount(t);
+	if (ru->npgids > 0) {
+		ru->pgid = calloc(ru->npgids, sizeof(int));
+		if (ru->pgid == NULL) {
+			ru->npgids = 0;
+		}
+		for (i = 0; i < ru->npgids; i++) {
+			ru->pgid[i] = nextInt(t);
+		}
+	}
+	ru->nthreads = nextInt(t);
+}
+
+static void readJobNew(struct tokens *t, struct jobNewLog *l) {
+	l->jobId = nextInt(t);
+	l->userId = nextInt(t);
+	l->options = nextInt(t);
+	l->numProcessors = nextInt(t);
+	l->submitTime = nextInt(t);
+	l->beginTime = nextInt(t);
+	l->termTime = nextInt(t);
+	l->sigValue = nextInt(t);
+	l->chkpntPeriod = nextInt(t);
+	l->restartPid = nextInt(t);
+	l->userName = nextStr(t);
+	nextRLimits(t, l->rLimits);
+	l->hostSpec = nextStr(t);
+	l->hostFactor = nextDouble(t);
+	l->umask = nextInt(t);
+	l->queue = nextStr(t);
+	l->resReq = nextStr(t);
+	l->fromHost = nextStr(t);
+	l->cwd = nextStr(t);
+	l->chkpntDir = nextStr(t);
+	l->inFile = nextStr(t);
+	l->outFile = nextStr(t);
+	l->errFile = nextStr(t);
+	l->inFileSpool = nextStr(t);
+	l->commandSpool = nextStr(t);
+	l->jobSpoolDir = nextStr(t);
+	l->subHomeDir = nextStr(t);
+	l->jobFile = nextStr(t);
+	l->askedHosts = nextStrArray(t, &l->numAskedHosts);
+	l->dependCond = nextStr(t);
+	l->timeEvent = nextStr(t);
+	l->jobName = nextStr(t);
+	l->command = nextStr(t);
+	l->xf = nextXFiles(t, &l->nxf);
+	l->preExecCmd = nextStr(t);
+	l->mailUser = nextStr(t);
+	l->projectName = nextStr(t);
+	l->niosPort = nextInt(t);
+	l->maxNumProcessors = nextInt(t);
+	l->schedHostType = nextStr(t);
+	l->loginShell = nextStr(t);
+	l->userGroup = nextStr(t);
+	l->exceptList = nextStr(t);
+	l->options2 = nextInt(t);
+	l->idx = nextInt(t);
+	l->userPriority = nextInt(t);
+	l->rsvId = nextStr(t);
+	l->jobGroup = nextStr(t);
+	l->extsched = nextStr(t);
+	l->warningTimePeriod = nextInt(t);
+	l->warningAction = nextStr(t);
+	l->sla = nextStr(t);
+	l->SLArunLimit = nextInt(t);
+	l->licenseProject = nextStr(t);
+	l->options3 = nextInt(t);
+	l->app = nextStr(t);
+	l->postExecCmd = nextStr(t);
+	l->runtimeEstimation = nextInt(t);
+	l->requeueEValues = nextStr(t);
+	l->jobDescription = nextStr(t);
+	l->subcwd = nextStr(t);
+	l->srcCluster = nextStr(t);
+	l->flow_id = nextStr(t);
+}
+
+static void readJobModify2(struct tokens *t, struct jobModLog *l) {
+	l->jobIdStr = nextStr(t);
+	l->options = nextInt(t);
+	l->options2 = nextInt(t);
+	l->delOptions = nextInt(t);
+	l->delOptions2 = nextInt(t);
+	l->userId = nextInt(t);
+	l->userName = nextStr(t);
+	l->submitTime = nextInt(t);
+	l->umask = nextInt(t);
+	l->numProcessors = nextInt(t);
+	l->beginTime = nextInt(t);
+	l->termTime = nextInt(t);
+	l->sigValue = nextInt(t);
+	l->restartPid = nextInt(t);
+	l->jobName = nextStr(t);
+	l->queue = nextStr(t);
+	l->askedHosts = nextStrArray(t, &l->numAskedHosts);
+	l->resReq = nextStr(t);
+	nextRLimits(t, l->rLimits);
+	l->hostSpec = nextStr(t);
+	l->dependCond = nextStr(t);
+	l->timeEvent = nextStr(t);
+	l->subHomeDir = nextStr(t);
+	l->inFile = nextStr(t);
+	l->outFile = nextStr(t);
+	l->errFile = nextStr(t);
+	l->command = nextStr(t);
+	l->inFileSpool = nextStr(t);
+	l->commandSpool = nextStr(t);
+	l->chkpntPeriod = nextInt(t);
+	l->chkpntDir = nextStr(t);
+	l->xf = nextXFiles(t, &l->nxf);
+	l->jobFile = nextStr(t);
+	l->fromHost = nextStr(t);
+	l->cwd = nextStr(t);
+	l->preExecCmd = nextStr(t);
+	l->mailUser = nextStr(t);
+	l->projectName = nextStr(t);
+	l->niosPort = nextInt(t);
+	l->maxNumProcessors = nextInt(t);
+	l->loginShell = nextStr(t);
+	l->schedHostType = nextStr(t);
+	l->userGroup = nextStr(t);
+	l->exceptList = nextStr(t);
+	l->userPriority = nextInt(t);
+	l->rsvId = nextStr(t);
+	l->extsched = nextStr(t);
+	l->warningTimePeriod = nextInt(t);
+	l->warningAction = nextStr(t);
+	l->jobGroup = nextStr(t);
+	l->sla = nextStr(t);
+	l->licenseProject = nextStr(t);
+	l->options3 = nextInt(t);
+	l->delOptions3 = nextInt(t);
+	l->app = nextStr(t);
+	l->apsString = nextStr(t);
+	l->postExecCmd = nextStr(t);
+	l->runtimeEstimation = nextInt(t);
+}
+
+static void readSbdUnreportedStatus(struct tokens *t,
+		struct sbdUnreportedStatusLog *l) {
+	l->jobId = nextInt(t);
+	l->actPid = nextInt(t);
+	l->jobPid = nextInt(t);
+	l->jobPGid = nextInt(t);
+	l->newStatus = nextInt(t);
+	l->reason = nextInt(t);
+	l->subreasons = nextInt(t);
+	nextRusage(t, &l->lsfRusage);
+	l->execUid = nextInt(t);
+	l->exitStatus = nextInt(t);
+	l->execCwd = nextStr(t);
+	l->execHome = nextStr(t);
+	l->execUsername = nextStr(t);
+	l->msgId = nextInt(t);
+	nextJRusage(t, &l->runRusage);
+	l->sigValue = nextInt(t);
+	l->actStatus = nextInt(t);
+	l->seq = nextInt(t);
+	l->idx = nextInt(t);
+	l->exitInfo = nextInt(t);
+}
+
+static void readJobStartLimit(struct tokens *t, struct jobStartLimitLog *l) {
+	l->jobId = nextLong(t);
+	l->clusterName = nextStr(t);
+	nextRLimits(t, l->lsfLimits);
+	nextRLimits(t, l->jobRlimits);
+}
+
+static void readJobSignal(struct tokens *t, struct signalLog *l) {
+	l->jobId = nextInt(t);
+	l->userId = nextInt(t);
+	l->runCount = nextInt(t);
+	l->signalSymbol = nextStr(t);
+	l->idx = nextInt(t);
+	l->userName = nextStr(t);
+}
+
+static void readJobForward(struct tokens *t, struct jobForwardLog *l) {
+	int num;
+
+	l->jobId = nextInt(t);
+	/* the count comes ahead of the cluster */
+	num = nextInt(t);
+	l->cluster = nextStr(t);
+	if (num < 0 || num > t->num - t->cur) {
+		t->bad = 1;
+		num = 0;
+	}
+	if (num > 0) {
+		l->reserHosts = calloc(num, sizeof(char *));
+		if (l->reserHosts != NULL) {
+			for (l->numReserHosts = 0; l->numReserHosts < num; l->numReserHosts++) {
+				l->reserHosts[l->numReserHosts] = nextStr(t);
+			}
+		}
+	}
+	l->idx = nextInt(t);
+	l->jobRmtAttr = nextInt(t);
+}
+
+static void readJobExtMsg(struct tokens *t, struct jobExternalMsgLog *l) {
+	l->jobId = nextInt(t);
+	l->idx = nextInt(t);
+	l->msgIdx = nextInt(t);
+	l->desc = nextStr(t);
+	l->userId = nextInt(t);
+	l->dataSize = nextLong(t);
+	l->postTime = nextInt(t);
+	l->dataStatus = nextInt(t);
+	l->fileName = nextStr(t);
+	l->userName = nextStr(t);
+}
+
+/* JOB_ATTA_DATA, the data of a message: no description nor user */
+static void readJobAttaData(struct tokens *t, struct jobExternalMsgLog *l) {
+	l->jobId = nextInt(t);
+	l->idx = nextInt(t);
+	l->msgIdx = nextInt(t);
+	l->dataSize = nextLong(t);
+	l->dataStatus = nextInt(t);
+	l->fileName = nextStr(t);
+	l->desc = strdup("");
+	l->userName = strdup("");
+}
+
+static void readJobChunk(struct tokens *t, struct jobChunkLog *l) {
+	int i, num;
+
+	/* a chunk has at least one member, the first gives its job id */
+	num = nextCount(t);
+	if (num == 0) {
+		t->bad = 1;
+	} else {
+		l->membJobId = calloc(num, sizeof(LS_LONG_INT));
+		if (l->membJobId == NULL) {
+			t->bad = 1;
+			num = 0;
+		}
+		for (i = 0; i < num; i++) {
+			l->membJobId[i] = nextLong(t);
+		}
+	}
+	l->membSize = num;
+	l->execHosts = nextStrArray(t, &num);
+	l->numExHosts = num;
+}
+
+static void readJobForce(struct tokens *t, struct jobForceRequestLog *l) {
+	l->userId = nextInt(t);
+	l->execHosts = nextStrArray(t, &l->numExecHosts);
+	l->jobId = nextInt(t);
+	l->idx = nextInt(t);
+	l->options = nextInt(t);
+	l->userName = nextStr(t);
+	l->queue = nextStr(t);
+}
+
+static void readMig(struct tokens *t, struct migLog *l) {
+	l->jobId = nextInt(t);
+	l->askedHosts = nextStrArray(t, &l->numAskedHosts);
+	l->userId = nextInt(t);
+	l->idx = nextInt(t);
+	l->userName = nextStr(t);
+}
+
+static const struct {
+	const char *name;
+	int type;
+} eventTypes[] = {
+	{ "METRIC_LOG", EVENT_METRIC_LOG },
+	{ "JOB_NEW", EVENT_JOB_NEW },
+	{ "JOB_MODIFY2", EVENT_JOB_MODIFY2 },
+	{ "JOB_STATUS", EVENT_JOB_STATUS },
+	{ "JOB_CLEAN", EVENT_JOB_CLEAN },
+	{ "JOB_START", EVENT_JOB_START },
+	{ "PRE_EXEC_START", EVENT_PRE_EXEC_START },
+	{ "JOB_START_ACCEPT", EVENT_JOB_START_ACCEPT },
+	{ "JOB_EXECUTE", EVENT_JOB_EXECUTE },
+	{ "JOB_FINISH", EVENT_JOB_FINISH },
+	{ "JOB_FINISH2", EVENT_JOB_FINISH2 },
+	{ "JOB_STATUS2", EVENT_JOB_STATUS2 },
+	{ "JOB_SWITCH", EVENT_JOB_SWITCH },
+	{ "JOB_MOVE", EVENT_JOB_MOVE },
+	{ "JOB_SIGNAL", EVENT_JOB_SIGNAL },
+	{ "JOB_REQUEUE", EVENT_JOB_REQUEUE },
+	{ "JOB_FORCE", EVENT_JOB_FORCE },
+	{ "JOB_RUN_RUSAGE", EVENT_JOB_RUN_RUSAGE },
+	{ "MBD_UNFULFILL", EVENT_MBD_UNFULFILL },
+	{ "JOB_STARTLIMIT", EVENT_JOB_STARTLIMIT },
+	{ "MIG", EVENT_MIG },
+	{ "JOB_FORWARD", EVENT_JOB_FORWARD },
+	{ "JOB_ACCEPT", EVENT_JOB_ACCEPT },
+	{ "JOB_SIGACT", EVENT_JOB_SIGACT },
+	{ "JOB_EXCEPTION", EVENT_JOB_EXCEPTION },
+	{ "JOB_EXT_MSG", EVENT_JOB_EXT_MSG },
+	{ "JOB_ATTA_DATA", EVENT_JOB_ATTA_DATA },
+	{ "JOB_CHUNK", EVENT_JOB_CHUNK },
+	{ "SBD_UNREPORTED_STATUS", EVENT_SBD_UNREPORTED_STATUS },
+	{ "MBD_START", EVENT_MBD_START },
+	{ NULL, 0 }
+};
+
+/* free the members allocated by the readers above */
+static void freeMembers(struct eventRec *rec) {
+	union eventLog *log = &rec->eventLog;
+
+	switch (rec->type) {
+	case EVENT_JOB_START:
+	case EVENT_PRE_EXEC_START:
+		freeStrArray(&log->jobStartLog.execHosts, log->jobStartLog.numExHosts);
+		FREEUP(log->jobStartLog.queuePreCmd);
+		FREEUP(log->jobStartLog.queuePostCmd);
+		FREEUP(log->jobStartLog.userGroup);
+		FREEUP(log->jobStartLog.additionalInfo);
+		FREEUP(log->jobStartLog.effectiveResReq);
+		freeStrArray(&log->jobStartLog.allocSlots,
+				log->jobStartLog.numAllocSlots);
+		break;
+	case EVENT_JOB_EXECUTE:
+		FREEUP(log->jobExecuteLog.execCwd);
+		FREEUP(log->jobExecuteLog.execHome);
+		FREEUP(log->jobExecuteLog.execUsername);
+		FREEUP(log->jobExecuteLog.additionalInfo);
+		FREEUP(log->jobExecuteLog.execRusage);
+		break;
+	case EVENT_JOB_FINISH: {
+		struct jobFinishLog *l = &log->jobFinishLog;
+		int i;
+
+		freeStrArray(&l->askedHosts, l->numAskedHosts);
+		freeStrArray(&l->execHosts, l->numExHosts);
+		FREEUP(l->userName);
+		FREEUP(l->queue);
+		FREEUP(l->resReq);
+		FREEUP(l->dependCond);
+		FREEUP(l->preExecCmd);
+		FREEUP(l->fromHost);
+		FREEUP(l->cwd);
+		FREEUP(l->inFile);
+		FREEUP(l->outFile);
+		FREEUP(l->errFile);
+		FREEUP(l->jobFile);
+		FREEUP(l->jobName);
+		FREEUP(l->command);
+		FREEUP(l->mailUser);
+		FREEUP(l->projectName);
+		FREEUP(l->loginShell);
+		FREEUP(l->timeEvent);
+		FREEUP(l->inFileSpool);
+		FREEUP(l->commandSpool);
+		FREEUP(l->rsvId);
+		FREEUP(l->sla);
+		FREEUP(l->additionalInfo);
+		FREEUP(l->warningAction);
+		FREEUP(l->chargedSAAP);
+		FREEUP(l->licenseProject);
+		FREEUP(l->app);
+		FREEUP(l->postExecCmd);
+		FREEUP(l->jgroup);
+		freeStrArray(&l->allocSlots, l->numAllocSlots);
+		for (i = 0; i < l->numhRusages; i++) {
+			free(l->hostRusage[i].name);
+		}
+		FREEUP(l->hostRusage);
+		break;
+	}
+	case EVENT_JOB_FINISH2: {
+		struct jobFinish2Log *l = &log->jobFinish2Log;
+		freeStrArray(&l->execHosts, l->numExHosts);
+		FREEUP(l->slotUsages);
+		FREEUP(l->userName);
+		FREEUP(l->queue);
+		FREEUP(l->fromHost);
+		FREEUP(l->cwd);
+		FREEUP(l->jobFile);
+		FREEUP(l->command);
+		FREEUP(l->jobName);
+		FREEUP(l->projectName);
+		FREEUP(l->chargedSAAP);
+		FREEUP(l->effectiveResReq);
+		FREEUP(l->app);
+		FREEUP(l->userGroup);
+		break;
+	}
+	case EVENT_JOB_STATUS2: {
+		struct jobStatus2Log *l = &log->jobStatus2Log;
+		freeStrArray(&l->execHosts, l->numExHosts);
+		FREEUP(l->slotUsages);
+		FREEUP(l->userName);
+		FREEUP(l->queue);
+		FREEUP(l->resReq);
+		FREEUP(l->projectName);
+		FREEUP(l->jgroup);
+		FREEUP(l->app);
+		FREEUP(l->userGroup);
+		break;
+	}
+	case EVENT_JOB_NEW: {
+		struct jobNewLog *l = &log->jobNewLog;
+		freeStrArray(&l->askedHosts, l->numAskedHosts);
+		freeXFiles(&l->xf, l->nxf);
+		FREEUP(l->userName);
+		FREEUP(l->hostSpec);
+		FREEUP(l->queue);
+		FREEUP(l->resReq);
+		FREEUP(l->fromHost);
+		FREEUP(l->cwd);
+		FREEUP(l->subcwd);
+		FREEUP(l->chkpntDir);
+		FREEUP(l->inFile);
+		FREEUP(l->outFile);
+		FREEUP(l->errFile);
+		FREEUP(l->inFileSpool);
+		FREEUP(l->commandSpool);
+		FREEUP(l->jobSpoolDir);
+		FREEUP(l->subHomeDir);
+		FREEUP(l->jobFile);
+		FREEUP(l->dependCond);
+		FREEUP(l->timeEvent);
+		FREEUP(l->jobName);
+		FREEUP(l->command);
+		FREEUP(l->preExecCmd);
+		FREEUP(l->mailUser);
+		FREEUP(l->projectName);
+		FREEUP(l->schedHostType);
+		FREEUP(l->loginShell);
+		FREEUP(l->userGroup);
+		FREEUP(l->exceptList);
+		FREEUP(l->rsvId);
+		FREEUP(l->jobGroup);
+		FREEUP(l->extsched);
+		FREEUP(l->warningAction);
+		FREEUP(l->sla);
+		FREEUP(l->licenseProject);
+		FREEUP(l->app);
+		FREEUP(l->postExecCmd);
+		FREEUP(l->requeueEValues);
+		FREEUP(l->jobDescription);
+		FREEUP(l->srcCluster);
+		FREEUP(l->flow_id);
+		break;
+	}
+	case EVENT_JOB_MODIFY2: {
+		struct jobModLog *l = &log->jobModLog;
+		freeStrArray(&l->askedHosts, l->numAskedHosts);
+		freeXFiles(&l->xf, l->nxf);
+		FREEUP(l->jobIdStr);
+		FREEUP(l->userName);
+		FREEUP(l->jobName);
+		FREEUP(l->queue);
+		FREEUP(l->resReq);
+		FREEUP(l->hostSpec);
+		FREEUP(l->dependCond);
+		FREEUP(l->timeEvent);
+		FREEUP(l->subHomeDir);
+		FREEUP(l->inFile);
+		FREEUP(l->outFile);
+		FREEUP(l->errFile);
+		FREEUP(l->command);
+		FREEUP(l->inFileSpool);
+		FREEUP(l->commandSpool);
+		FREEUP(l->chkpntDir);
+		FREEUP(l->jobFile);
+		FREEUP(l->fromHost);
+		FREEUP(l->cwd);
+		FREEUP(l->preExecCmd);
+		FREEUP(l->mailUser);
+		FREEUP(l->projectName);
+		FREEUP(l->loginShell);
+		FREEUP(l->schedHostType);
+		FREEUP(l->userGroup);
+		FREEUP(l->exceptList);
+		FREEUP(l->rsvId);
+		FREEUP(l->extsched);
+		FREEUP(l->warningAction);
+		FREEUP(l->jobGroup);
+		FREEUP(l->sla);
+		FREEUP(l->licenseProject);
+		FREEUP(l->app);
+		FREEUP(l->apsString);
+		FREEUP(l->postExecCmd);
+		break;
+	}
+	case EVENT_SBD_UNREPORTED_STATUS: {
+		struct sbdUnreportedStatusLog *l = &log->sbdUnreportedStatusLog;
+		FREEUP(l->execCwd);
+		FREEUP(l->execHome);
+		FREEUP(l->execUsername);
+		FREEUP(l->runRusage.pidInfo);
+		FREEUP(l->runRusage.pgid);
+		break;
+	}
+	case EVENT_JOB_RUN_RUSAGE:
+		FREEUP(log->jobRunRusageLog.jrusage.pidInfo);
+		FREEUP(log->jobRunRusageLog.jrusage.pgid);
+		break;
+	case EVENT_JOB_SWITCH:
+		FREEUP(log->jobSwitchLog.queue);
+		FREEUP(log->jobSwitchLog.userName);
+		break;
+	case EVENT_JOB_MOVE:
+		FREEUP(log->jobMoveLog.userName);
+		break;
+	case EVENT_JOB_SIGNAL:
+		FREEUP(log->signalLog.signalSymbol);
+		FREEUP(log->signalLog.userName);
+		break;
+	case EVENT_JOB_FORCE:
+		freeStrArray(&log->jobForceRequestLog.execHosts,
+				log->jobForceRequestLog.numExecHosts);
+		FREEUP(log->jobForceRequestLog.userName);
+		FREEUP(log->jobForceRequestLog.queue);
+		break;
+	case EVENT_JOB_STARTLIMIT:
+		FREEUP(log->jobStartLimitLog.clusterName);
+		break;
+	case EVENT_MIG:
+		freeStrArray(&log->migLog.askedHosts, log->migLog.numAskedHosts);
+		FREEUP(log->migLog.userName);
+		break;
+	case EVENT_JOB_FORWARD:
+		freeStrArray(&log->jobForwardLog.reserHosts,
+				log->jobForwardLog.numReserHosts);
+		FREEUP(log->jobForwardLog.cluster);
+		break;
+	case EVENT_JOB_ACCEPT:
+		FREEUP(log->jobAcceptLog.cluster);
+		break;
+	case EVENT_JOB_SIGACT:
+		FREEUP(log->sigactLog.signalSymbol);
+		break;
+	case EVENT_JOB_EXT_MSG:
+	case EVENT_JOB_ATTA_DATA:
+		FREEUP(log->jobExternalMsgLog.desc);
+		FREEUP(log->jobExternalMsgLog.fileName);
+		FREEUP(log->jobExternalMsgLog.userName);
+		break;
+	case EVENT_JOB_CHUNK:
+		FREEUP(log->jobChunkLog.membJobId);
+		freeStrArray(&log->jobChunkLog.execHosts,
+				log->jobChunkLog.numExHosts);
+		break;
+	default:
+		break;
+	}
+}
+
+int lsb_geteventrecbyline(char *line, struct eventRec *logRec) {
+	struct tokens t;
+	const char *name;
+	int i;
+
+	if (line == NULL || logRec == NULL) {
+		return -1;
+	}
+	if (tokenize(line, &t) < 0 || t.num < 3) {
+		freeTokens(&t);
+		return -1;
+	}
+
+	name = next(&t);
+	for (i = 0; eventTypes[i].name; i++) {
+		if (0 == strcmp(name, eventTypes[i].name)) {
+			break;
+		}
+	}
+	if (eventTypes[i].name == NULL) {
+		freeTokens(&t);
+		return -1;
+	}
+
+	memset(logRec, 0, sizeof(struct eventRec));
+	logRec->type = eventTypes[i].type;
+	strncpy(logRec->version, next(&t), MAX_VERSION_LEN - 1);
+	logRec->eventTime = nextInt(&t);
+
+	switch (logRec->type) {
+	case EVENT_METRIC_LOG:
+		readMetricLog(&t, &logRec->eventLog.perfmonLog);
+		break;
+	case EVENT_JOB_STATUS:
+		readJobStatus(&t, &logRec->eventLog.jobStatusLog);
+		break;
+	case EVENT_JOB_CLEAN:
+		logRec->eventLog.jobCleanLog.jobId = nextInt(&t);
+		logRec->eventLog.jobCleanLog.idx = nextInt(&t);
+		break;
+	case EVENT_JOB_START:
+	case EVENT_PRE_EXEC_START:
+		readJobStart(&t, &logRec->eventLog.jobStartLog);
+		break;
+	case EVENT_JOB_START_ACCEPT:
+		logRec->eventLog.jobStartAcceptLog.jobId = nextInt(&t);
+		logRec->eventLog.jobStartAcceptLog.jobPid = nextInt(&t);
+		logRec->eventLog.jobStartAcceptLog.jobPGid = nextInt(&t);
+		logRec->eventLog.jobStartAcceptLog.idx = nextInt(&t);
+		break;
+	case EVENT_JOB_EXECUTE:
+		readJobExecute(&t, &logRec->eventLog.jobExecuteLog);
+		break;
+	case EVENT_JOB_FINISH:
+		readJobFinish(&t, &logRec->eventLog.jobFinishLog);
+		break;
+	case EVENT_JOB_FINISH2:
+		readJobFinish2(&t, &logRec->eventLog.jobFinish2Log);
+		break;
+	case EVENT_JOB_STATUS2:
+		readJobStatus2(&t, &logRec->eventLog.jobStatus2Log);
+		break;
+	case EVENT_JOB_NEW:
+		readJobNew(&t, &logRec->eventLog.jobNewLog);
+		break;
+	case EVENT_JOB_MODIFY2:
+		readJobModify2(&t, &logRec->eventLog.jobModLog);
+		break;
+	case EVENT_JOB_SWITCH: {
+		struct jobSwitchLog *l = &logRec->eventLog.jobSwitchLog;
+		l->userId = nextInt(&t);
+		l->jobId = nextInt(&t);
+		l->queue = nextStr(&t);
+		l->idx = nextInt(&t);
+		l->userName = nextStr(&t);
+		break;
+	}
+	case EVENT_JOB_MOVE: {
+		struct jobMoveLog *l = &logRec->eventLog.jobMoveLog;
+		l->userId = nextInt(&t);
+		l->jobId = nextInt(&t);
+		l->position = nextInt(&t);
+		l->base = nextInt(&t);
+		l->idx = nextInt(&t);
+		l->userName = nextStr(&t);
+		break;
+	}
+	case EVENT_JOB_SIGNAL:
+		readJobSignal(&t, &logRec->eventLog.signalLog);
+		break;
+	case EVENT_JOB_REQUEUE:
+		logRec->eventLog.jobRequeueLog.jobId = nextInt(&t);
+		logRec->eventLog.jobRequeueLog.idx = nextInt(&t);
+		break;
+	case EVENT_JOB_FORCE:
+		readJobForce(&t, &logRec->eventLog.jobForceRequestLog);
+		break;
+	case EVENT_JOB_RUN_RUSAGE:
+		logRec->eventLog.jobRunRusageLog.jobid = nextInt(&t);
+		logRec->eventLog.jobRunRusageLog.idx = nextInt(&t);
+		nextJRusage(&t, &logRec->eventLog.jobRunRusageLog.jrusage);
+		break;
+	case EVENT_MBD_UNFULFILL: {
+		struct unfulfillLog *l = &logRec->eventLog.unfulfillLog;
+		l->jobId = nextInt(&t);
+		l->notSwitched = nextInt(&t);
+		l->sig = nextInt(&t);
+		l->sig1 = nextInt(&t);
+		l->sig1Flags = nextInt(&t);
+		l->chkPeriod = nextInt(&t);
+		l->notModified = nextInt(&t);
+		l->idx = nextInt(&t);
+		l->miscOpts4PendSig = nextInt(&t);
+		break;
+	}
+	case EVENT_JOB_STARTLIMIT:
+		readJobStartLimit(&t, &logRec->eventLog.jobStartLimitLog);
+		break;
+	case EVENT_MIG:
+		readMig(&t, &logRec->eventLog.migLog);
+		break;
+	case EVENT_JOB_FORWARD:
+		readJobForward(&t, &logRec->eventLog.jobForwardLog);
+		break;
+	case EVENT_JOB_ACCEPT:
+		logRec->eventLog.jobAcceptLog.jobId = nextInt(&t);
+		logRec->eventLog.jobAcceptLog.remoteJid = nextLong(&t);
+		logRec->eventLog.jobAcceptLog.cluster = nextStr(&t);
+		logRec->eventLog.jobAcceptLog.idx = nextInt(&t);
+		logRec->eventLog.jobAcceptLog.jobRmtAttr = nextInt(&t);
+		break;
+	case EVENT_JOB_SIGACT: {
+		struct sigactLog *l = &logRec->eventLog.sigactLog;
+		l->jobId = nextInt(&t);
+		l->period = nextInt(&t);
+		l->pid = nextInt(&t);
+		l->jStatus = nextInt(&t);
+		l->reasons = nextInt(&t);
+		l->flags = nextInt(&t);
+		l->signalSymbol = nextStr(&t);
+		l->actStatus = nextInt(&t);
+		l->idx = nextInt(&t);
+		break;
+	}
+	case EVENT_JOB_EXCEPTION: {
+		struct jobExceptionLog *l = &logRec->eventLog.jobExceptionLog;
+		l->jobId = nextInt(&t);
+		l->exceptMask = nextInt(&t);
+		l->actMask = nextInt(&t);
+		l->timeEvent = nextInt(&t);
+		l->exceptInfo = nextInt(&t);
+		l->idx = nextInt(&t);
+		break;
+	}
+	case EVENT_JOB_EXT_MSG:
+		readJobExtMsg(&t, &logRec->eventLog.jobExternalMsgLog);
+		break;
+	case EVENT_JOB_ATTA_DATA:
+		readJobAttaData(&t, &logRec->eventLog.jobExternalMsgLog);
+		break;
+	case EVENT_JOB_CHUNK:
+		readJobChunk(&t, &logRec->eventLog.jobChunkLog);
+		break;
+	case EVENT_SBD_UNREPORTED_STATUS:
+		readSbdUnreportedStatus(&t, &logRec->eventLog.sbdUnreportedStatusLog);
+		break;
+	}
+
+	freeTokens(&t);
+	if (t.bad) {
+		freeMembers(logRec);
+		memset(logRec, 0, sizeof(struct eventRec));
+		return -1;
+	}
+	return 0;
+}
+
+struct eventRec *lsb_readstreamlineMT(const char *line) {
+	struct eventRec *rec;
+
+	rec = calloc(1, sizeof(struct eventRec));
+	if (rec == NULL) {
+		return NULL;
+	}
+	if (lsb_geteventrecbyline((char *) line, rec) < 0) {
+		free(rec);
+		return NULL;
+	}
+	return rec;
+}
+
+void lsb_freelogrec(struct eventRec *logRec) {
+	if (logRec == NULL) {
+		return;
+	}
+	freeMembers(logRec);
+	free(logRec);
+}
+
+char *ls_getclustername(void) {
+	char *name = getenv("LSF_MOCK_CLUSTER");
+
+	return name ? name : "mock_cluster";
+}
+
+int lsb_init(char *appName) {
+	return 0;
+}
+
+struct parameterInfo *lsb_parameterinfo(char **names, int *numUsers,
+		int options) {
+	static struct parameterInfo info = { 1000 };
+
+	return &info;
+}
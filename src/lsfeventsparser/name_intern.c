@@ -0,0 +1,207 @@
+/************************************************************************
+ *
+ * NAME INTERN
+ *
+ * name_intern.c -- 2026-10-19
+ *
+ * Process-wide, read-mostly intern table for host, queue, user and
+ * project names. The table is an open addressing hash keyed by the raw
+ * name; each slot also keeps the JSON-escaped value, so Json4c string
+ * nodes can reference it instead of owning a freshly escaped copy.
+ *
+ * EXPORTED ROUTINES:
+ *
+ * internName() - look up or insert a name, return its escaped form.
+ * internNameCount() - number of interned names.
+ * internNameReset() - drop the whole table.
+ *
+ ************************************************************************/
+
+#include "name_intern.h"
+#include "strreplace.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define NAME_INTERN_INIT_SLOTS 1024
+
+#if defined(WIN32)
+static SRWLOCK internLock = SRWLOCK_INIT;
+#define READ_LOCK()    AcquireSRWLockShared(&internLock)
+#define READ_UNLOCK()  ReleaseSRWLockShared(&internLock)
+#define WRITE_LOCK()   AcquireSRWLockExclusive(&internLock)
+#define WRITE_UNLOCK() ReleaseSRWLockExclusive(&internLock)
+#else
+static pthread_rwlock_t internLock = PTHREAD_RWLOCK_INITIALIZER;
+#define READ_LOCK()    pthread_rwlock_rdlock(&internLock)
+#define READ_UNLOCK()  pthread_rwlock_unlock(&internLock)
+#define WRITE_LOCK()   pthread_rwlock_wrlock(&internLock)
+#define WRITE_UNLOCK() pthread_rwlock_unlock(&internLock)
+#endif
+
+struct internSlot {
+	unsigned int hash;
+	char *name;
+	char *escaped;
+};
+
+static struct internSlot *slots = NULL;
+static unsigned int numSlots = 0;
+static int numNames = 0;
+
+/* FNV-1a, names are short and mostly share a prefix. */
+static unsigned int hashName(const char *name, size_t *len) {
+	unsigned int h = 2166136261u;
+	const unsigned char *p = (const unsigned char *) name;
+
+	while (*p) {
+		h ^= *p++;
+		h *= 16777619u;
+	}
+	*len = (const char *) p - name;
+	return h;
+}
+
+static struct internSlot *findSlot(struct internSlot *table,
+		unsigned int size, unsigned int hash, const char *name) {
+	unsigned int i = hash & (size - 1);
+
+	while (table[i].name) {
+		if (table[i].hash == hash && 0 == strcmp(table[i].name, name)) {
+			return &table[i];
+		}
+		i = (i + 1) & (size - 1);
+	}
+	return &table[i];
+}
+
+/*
+ * Double the slot array. Called with the write lock held.
+ * Returns 0 on success, -1 on out of memory.
+ */
+static int growTable(void) {
+	unsigned int newSize = numSlots ? numSlots * 2 : NAME_INTERN_INIT_SLOTS;
+	struct internSlot *newSlots;
+	unsigned int i;
+
+	newSlots = calloc(newSize, sizeof(struct internSlot));
+	if (!newSlots) {
+		return -1;
+	}
+	for (i = 0; i < numSlots; i++) {
+		if (slots[i].name) {
+			*findSlot(newSlots, newSize, slots[i].hash, slots[i].name) = slots[i];
+		}
+	}
+	free(slots);
+	slots = newSlots;
+	numSlots = newSize;
+	return 0;
+}
+
+/*
+ *-----------------------------------------------------------------------
+ *
+ * internName
+ *
+ * ARGUMENTS:
+ *
+ * name[IN]: host, queue, user or project name.
+ *
+ * DESCRIPTION:
+ *
+ * Return the JSON-escaped form of name, inserting it on first use.
+ * Lookups of known names only take the shared lock.
+ *
+ * RETURN:
+ *
+ * escaped name owned by the table, NULL if the name is not interned.
+ *
+ *-----------------------------------------------------------------------
+ */
+const char *internName(const char *name) {
+	struct internSlot *slot;
+	const char *escaped = NULL;
+	unsigned int hash;
+	size_t len;
+
+	if (!name) {
+		return NULL;
+	}
+	hash = hashName(name, &len);
+	if (len > NAME_INTERN_MAX_LEN) {
+		return NULL;
+	}
+
+	READ_LOCK();
+	if (numSlots) {
+		slot = findSlot(slots, numSlots, hash, name);
+		escaped = slot->escaped;
+	}
+	READ_UNLOCK();
+	if (escaped) {
+		return escaped;
+	}
+
+	WRITE_LOCK();
+	/* another thread may have inserted it in the meantime */
+	if (numSlots) {
+		slot = findSlot(slots, numSlots, hash, name);
+		if (slot->escaped) {
+			escaped = slot->escaped;
+			goto end;
+		}
+	}
+	if (numNames >= NAME_INTERN_MAX_ENTRIES) {
+		goto end;
+	}
+	/* keep the load factor under 1/2 */
+	if ((unsigned int) (numNames + 1) * 2 > numSlots && growTable() < 0) {
+		goto end;
+	}
+	slot = findSlot(slots, numSlots, hash, name);
+	slot->name = strdup(name);
+	slot->escaped = jsonEscape(name);
+	if (!slot->name || !slot->escaped) {
+		free(slot->name);
+		free(slot->escaped);
+		slot->name = NULL;
+		slot->escaped = NULL;
+		goto end;
+	}
+	slot->hash = hash;
+	numNames++;
+	escaped = slot->escaped;
+
+end:
+	WRITE_UNLOCK();
+	return escaped;
+}
+
+int internNameCount(void) {
+	int count;
+
+	READ_LOCK();
+	count = numNames;
+	READ_UNLOCK();
+	return count;
+}
+
+void internNameReset(void) {
+	unsigned int i;
+
+	WRITE_LOCK();
+	for (i = 0; i < numSlots; i++) {
+		free(slots[i].name);
+		free(slots[i].escaped);
+	}
+	free(slots);
+	slots = NULL;
+	numSlots = 0;
+	numNames = 0;
+	WRITE_UNLOCK();
+}
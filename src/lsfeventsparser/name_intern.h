@@ -0,0 +1,44 @@
+/************************************************************************
+ *
+ * NAME INTERN
+ *
+ * name_intern.h -- 2026-10-19
+ *
+ * Process-wide intern table for host, queue, user and project names.
+ * Every name is stored once together with its JSON-escaped form so that
+ * records carrying the same names do not duplicate and re-escape them.
+ *
+ ************************************************************************/
+
+#ifndef _NAME_INTERN_H_
+#define _NAME_INTERN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The table stops growing once it holds this many names; callers then
+ * fall back to copying and escaping the value themselves. */
+#define NAME_INTERN_MAX_ENTRIES 65536
+
+/* Longer values are never interned (command lines, paths, ...). */
+#define NAME_INTERN_MAX_LEN 512
+
+// Look up or insert a name.
+// Returns the JSON-escaped form of name, owned by the table and valid
+// until internNameReset() is called, or NULL if the name could not be
+// interned (NULL/too long/table full/out of memory).
+const char *internName(const char *name);
+
+// Number of names currently interned.
+int internNameCount(void);
+
+// Drop every interned name. Only safe when no Json4c tree still references
+// an interned value.
+void internNameReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
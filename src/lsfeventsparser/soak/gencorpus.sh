@@ -0,0 +1,436 @@
+#!/bin/sh
+
+#-----------------------------------------------------------------------------
+#
+# Generate the soak corpora: lsb.stream, lsb.acct and lsb.status under
+# outdir, with records of every event type the parser handles for the
+# file, random ids, times, host lists and strings (embedded quotes,
+# backslashes, tabs, UTF-8, long values), plus malformed and truncated
+# records. Each corpus states the counts a soak round must give with
+# "# expect" lines, see lsbevent_parse_soak.c.
+#
+# usage: sh gencorpus.sh [-n records] [-s seed] outdir
+#
+# -n records of each event type, 200 by default; a tenth as many of each
+#    kind of malformed record is added for each type.
+#
+#-----------------------------------------------------------------------------
+
+records=200
+seed=1
+while [ $# -gt 0 ]; do
+	case "$1" in
+	-n) records=$2; shift 2 ;;
+	-s) seed=$2; shift 2 ;;
+	*) outdir=$1; shift ;;
+	esac
+done
+if [ -z "$outdir" ]; then
+	echo "usage: sh gencorpus.sh [-n records] [-s seed] outdir"
+	exit 1
+fi
+mkdir -p "$outdir" || exit 1
+
+awk -v records="$records" -v seed="$seed" -v outdir="$outdir" '
+# the record being built, one token per entry
+function reset() { ntok = 0; cntTok = 0 }
+function add(v) { tok[++ntok] = v }
+function q(s) { gsub(/"/, "\"\"", s); return "\"" s "\"" }
+function addStr(s) { add(q(s)) }
+# the count of a list, the token a malformed record overflows
+function addCount(n) { add(n); if (!cntTok) cntTok = ntok }
+function rnd(n) { return int(rand() * n) }
+function jobId() { return 1 + rnd(9999999) }
+function idx() { return rnd(4) ? 0 : 1 + rnd(1000) }
+function tm() { return now - rnd(86400 * 30) }
+# a job id with an array index in the high 32 bits
+function longJobId() { return sprintf("%.0f", jobId() + rnd(2) * idx() * 4294967296) }
+
+function word(  n, s, i) {
+	n = 1 + rnd(12)
+	s = ""
+	for (i = 0; i < n; i++) {
+		s = s substr(letters, 1 + rnd(length(letters)), 1)
+	}
+	return s
+}
+
+function str(  k, s, n) {
+	k = rnd(12)
+	if (k == 0) return ""
+	if (k == 1) return word() " \"" word() "\" " word()
+	if (k == 2) return "C:\\" word() "\\" word()
+	if (k == 3) return word() "\t" word()
+	if (k == 4) return word() " \303\251\344\270\255 " word()
+	if (k == 5) return "%s %d {\"" word() "\": [1, 2]}"
+	if (k == 6) {
+		n = 1 + rnd(40)
+		s = ""
+		while (n-- > 0) s = s word() " "
+		return s
+	}
+	return word()
+}
+
+function path() { return rnd(8) ? "/" word() "/" word() : str() }
+function host() { return word() (rnd(2) ? "." word() ".com" : "") }
+
+function addHosts(n,  i) {
+	addCount(n)
+	for (i = 0; i < n; i++) addStr(host())
+}
+
+function addRusage(  i) {
+	for (i = 0; i < 19; i++) add(rnd(3) ? rnd(100000) / 100 : -1)
+}
+
+function addLimits(  i) {
+	for (i = 0; i < 12; i++) add(rnd(3) ? -1 : rnd(100000))
+}
+
+function addJRusage(  i, n) {
+	add(rnd(100000)); add(rnd(100000)); add(rnd(10000)); add(rnd(10000))
+	n = rnd(5)
+	addCount(n)
+	for (i = 0; i < n; i++) {
+		add(1 + rnd(99999)); add(1 + rnd(99999)); add(1 + rnd(99999)); add(jobId())
+	}
+	n = rnd(4)
+	add(n)
+	for (i = 0; i < n; i++) add(1 + rnd(99999))
+	add(rnd(64))
+}
+
+function addPair(k, v) { pair[++npairs] = k; value[npairs] = v }
+
+# the key/value list of a JOB_FINISH2 or JOB_STATUS2 record
+function addPairs(pairs,  n, slots, hosts, i) {
+	n = 1 + rnd(6)
+	slots = ""
+	for (i = 0; i < n; i++) slots = slots (1 + rnd(8)) " "
+	hosts = ""
+	for (i = 0; i < n; i++) hosts = hosts host() " "
+	npairs = 0
+	addPair("userName", word())
+	addPair("numProcessors", 1 + rnd(64))
+	addPair("jStatus", stats[1 + rnd(nstats)])
+	addPair("submitTime", tm())
+	addPair("startTime", tm())
+	addPair("endTime", tm())
+	addPair("queue", word())
+	addPair("projectName", str())
+	addPair("ru_utime", rnd(100000) / 100)
+	addPair("ru_stime", rnd(100000) / 100)
+	addPair("ru_maxrss", rnd(1000000))
+	addPair("ru_nswap", rnd(1000000))
+	addPair("app", str())
+	addPair("userGroup", str())
+	if (rnd(4)) addPair("execHosts", hosts)
+	if (rnd(2)) addPair("slotUsages", slots)
+	if (pairs == "finish") {
+		addPair("userId", rnd(100000))
+		addPair("options", rnd(100000000))
+		addPair("options2", rnd(10000))
+		addPair("termTime", rnd(2) ? 0 : tm())
+		addPair("fromHost", host())
+		addPair("cwd", path())
+		addPair("jobFile", str())
+		addPair("cpuTime", rnd(100000) / 1000)
+		addPair("command", str())
+		addPair("jobName", str())
+		addPair("exitStatus", rnd(3) ? 0 : rnd(65536))
+		addPair("maxNumProcessors", 1 + rnd(64))
+		addPair("exitInfo", rnd(30))
+		addPair("exceptMask", rnd(16))
+		addPair("chargedSAAP", "/" word())
+		addPair("runtime", rnd(100000))
+		addPair("effectiveResReq", str())
+		addPair("hostFactor", rnd(10000) / 100)
+	} else {
+		addPair("sampleInterval", 60 * (1 + rnd(10)))
+		addPair("numJobs", 1 + rnd(100))
+		addPair("reason", rnd(1000))
+		addPair("resReq", str())
+		addPair("jgroup", "/" word())
+		addPair("runtimeDelta", rnd(600))
+	}
+	addCount(npairs)
+	for (i = 1; i <= npairs; i++) {
+		addStr(pair[i])
+		addStr(value[i])
+	}
+}
+
+# the fields of a record of type ty, in the lsb.events(5) order
+function body(ty,  i, n) {
+	if (ty == "JOB_NEW") {
+		add(jobId()); add(rnd(100000)); add(rnd(100000000)); add(1 + rnd(64))
+		add(tm()); add(rnd(2) ? 0 : tm()); add(rnd(2) ? 0 : tm())
+		add(rnd(32)); add(rnd(2) ? -1 : rnd(3600)); add(rnd(2) ? -1 : rnd(99999))
+		addStr(word()); addLimits(); addStr(str()); add(rnd(10000) / 100)
+		add(18); addStr(word()); addStr(str()); addStr(host())
+		addStr(path()); addStr(path()); addStr(path()); addStr(path())
+		addStr(path()); addStr(path()); addStr(path()); addStr(path())
+		addStr("/home/" word()); addStr(tm() "." jobId())
+		addHosts(rnd(4)); addStr(str()); addStr(str()); addStr(str())
+		addStr(str())
+		n = rnd(3)
+		addCount(n)
+		for (i = 0; i < n; i++) { addStr(path()); addStr(path()); add(rnd(8)) }
+		addStr(str()); addStr(word() "@" host()); addStr(str())
+		add(rnd(65536)); add(1 + rnd(64)); addStr(word()); addStr("/bin/sh")
+		addStr(str()); addStr(str()); add(rnd(256) * (rnd(3) ? 0 : 4))
+		add(idx()); add(rnd(100)); addStr(str()); addStr("/" word())
+		addStr(str()); add(rnd(2) ? -1 : rnd(600)); addStr(str())
+		addStr(str()); add(-1); addStr(str()); add(rnd(10000)); addStr(str())
+		addStr(str()); add(rnd(2) ? -1 : rnd(86400)); addStr(str())
+		addStr(str()); addStr(path()); addStr(word()); addStr(str())
+	} else if (ty == "JOB_MODIFY2") {
+		addStr(jobId() (rnd(2) ? "[" (1 + rnd(1000)) "]" : ""))
+		add(rnd(100000000)); add(rnd(10000)); add(rnd(1000)); add(rnd(1000))
+		add(rnd(100000)); addStr(word()); add(tm()); add(18)
+		add(1 + rnd(64)); add(tm()); add(tm()); add(rnd(32)); add(-1)
+		addStr(str()); addStr(word()); addHosts(rnd(4)); addStr(str())
+		addLimits(); addStr(str()); addStr(str()); addStr(str())
+		addStr("/home/" word()); addStr(path()); addStr(path())
+		addStr(path()); addStr(str()); addStr(path()); addStr(path())
+		add(rnd(3600)); addStr(path())
+		n = rnd(3)
+		addCount(n)
+		for (i = 0; i < n; i++) { addStr(path()); addStr(path()); add(rnd(8)) }
+		addStr(str()); addStr(host()); addStr(path()); addStr(str())
+		addStr(str()); addStr(str()); add(rnd(65536)); add(1 + rnd(64))
+		addStr("/bin/sh"); addStr(word()); addStr(str()); addStr(str())
+		add(rnd(100)); addStr(str()); addStr(str()); add(-1); addStr(str())
+		addStr("/" word()); addStr(str()); addStr(str()); add(rnd(10000))
+		add(rnd(10000)); addStr(str()); addStr(str()); addStr(str())
+		add(rnd(2) ? -1 : rnd(86400))
+	} else if (ty == "JOB_START" || ty == "PRE_EXEC_START") {
+		add(jobId()); add(stats[1 + rnd(nstats)]); add(rnd(99999)); add(rnd(99999))
+		add(rnd(10000) / 100); addHosts(1 + rnd(6)); addStr(str())
+		addStr(str()); add(rnd(64)); addStr(str()); add(idx())
+		addStr(str()); add(rnd(2) ? 2147483647 : rnd(3600)); addStr(str())
+	} else if (ty == "JOB_START_ACCEPT") {
+		add(jobId()); add(1 + rnd(99999)); add(1 + rnd(99999)); add(idx())
+	} else if (ty == "JOB_EXECUTE") {
+		add(jobId()); add(rnd(100000)); add(1 + rnd(99999)); addStr(path())
+		addStr("/home/" word()); addStr(word()); add(1 + rnd(99999))
+		add(idx()); addStr(str()); add(rnd(2) ? -1 : rnd(3600))
+		addStr(str()); add(rnd(10)); add(rnd(2) ? 2147483647 : rnd(3600))
+	} else if (ty == "JOB_STATUS") {
+		add(jobId()); add(stats[1 + rnd(nstats)]); add(rnd(1000)); add(rnd(100))
+		add(rnd(100000) / 1000); add(tm())
+		n = rnd(2)
+		add(n)
+		if (n) addRusage()
+		add(rnd(64)); add(rnd(3) ? 0 : rnd(65536)); add(idx()); add(rnd(30))
+	} else if (ty == "JOB_SWITCH") {
+		add(rnd(100000)); add(jobId()); addStr(word()); add(idx())
+		addStr(word())
+	} else if (ty == "JOB_MOVE") {
+		add(rnd(100000)); add(jobId()); add(1 + rnd(1000)); add(rnd(3))
+		add(idx()); addStr(word())
+	} else if (ty == "JOB_SIGNAL") {
+		add(jobId()); add(rnd(100000)); add(rnd(10))
+		addStr(rnd(2) ? "KILL" : str()); add(idx()); addStr(word())
+	} else if (ty == "JOB_REQUEUE" || ty == "JOB_CLEAN") {
+		add(jobId()); add(idx())
+	} else if (ty == "JOB_FORCE") {
+		add(rnd(100000)); addHosts(rnd(5)); add(jobId()); add(idx())
+		add(rnd(16)); addStr(word()); addStr(word())
+	} else if (ty == "JOB_RUN_RUSAGE") {
+		add(jobId()); add(idx()); addJRusage()
+	} else if (ty == "MBD_UNFULFILL") {
+		add(jobId()); add(rnd(2)); add(rnd(32)); add(rnd(32)); add(rnd(16))
+		add(rnd(3600)); add(rnd(2)); add(idx()); add(rnd(16))
+	} else if (ty == "JOB_FINISH") {
+		add(jobId()); add(rnd(100000)); add(rnd(100000000)); add(1 + rnd(64))
+		add(tm()); add(rnd(2) ? 0 : tm()); add(rnd(2) ? 0 : tm()); add(tm())
+		addStr(word()); addStr(word()); addStr(str()); addStr(str())
+		addStr(str()); addStr(host()); addStr(path()); addStr(path())
+		addStr(path()); addStr(path()); addStr(tm() "." jobId())
+		addHosts(rnd(4)); addHosts(rnd(6)); add(rnd(2) ? 64 : 32)
+		add(rnd(10000) / 100); addStr(str()); addStr(str()); addRusage()
+		addStr(str()); addStr(str()); add(rnd(3) ? 0 : rnd(65536))
+		add(1 + rnd(64)); addStr("/bin/sh"); addStr(str()); add(idx())
+		add(rnd(1000000)); add(rnd(1000000)); addStr(path()); addStr(path())
+		addStr(str()); addStr(str()); add(rnd(16)); addStr(str())
+		add(rnd(30)); addStr(str()); add(-1); addStr("/" word())
+		addStr(str()); addStr(str()); addStr(str())
+		add(rnd(2) ? -1 : rnd(86400)); addStr("/" word())
+	} else if (ty == "JOB_FINISH2") {
+		add(longJobId()); addPairs("finish")
+	} else if (ty == "JOB_STARTLIMIT") {
+		add(longJobId()); addStr(word()); addLimits(); addLimits()
+	} else if (ty == "MIG") {
+		add(jobId()); addHosts(rnd(4)); add(rnd(100000)); add(idx())
+		addStr(word())
+	} else if (ty == "JOB_FORWARD") {
+		n = rnd(4)
+		add(jobId()); add(n); addStr(word())
+		cntTok = ntok - 1
+		for (i = 0; i < n; i++) addStr(host())
+		add(idx()); add(rnd(16))
+	} else if (ty == "JOB_ACCEPT") {
+		add(jobId()); add(jobId()); addStr(word()); add(idx()); add(rnd(16))
+	} else if (ty == "JOB_SIGACT") {
+		add(jobId()); add(rnd(3600)); add(1 + rnd(99999))
+		add(stats[1 + rnd(nstats)]); add(rnd(1000)); add(rnd(16))
+		addStr(rnd(2) ? "SIG_CHKPNT" : str()); add(rnd(4)); add(idx())
+	} else if (ty == "JOB_EXCEPTION") {
+		add(jobId()); add(rnd(16)); add(rnd(16)); add(tm()); add(rnd(100))
+		add(idx())
+	} else if (ty == "JOB_EXT_MSG") {
+		add(jobId()); add(idx()); add(rnd(8)); addStr(str()); add(rnd(100000))
+		add(rnd(1000000)); add(tm()); add(rnd(4)); addStr(path())
+		addStr(word())
+	} else if (ty == "JOB_ATTA_DATA") {
+		add(jobId()); add(idx()); add(rnd(8)); add(rnd(1000000)); add(rnd(4))
+		addStr(path())
+	} else if (ty == "JOB_CHUNK") {
+		n = 1 + rnd(8)
+		addCount(n)
+		for (i = 0; i < n; i++) add(jobId())
+		addHosts(rnd(3))
+	} else if (ty == "SBD_UNREPORTED_STATUS") {
+		add(jobId()); add(rnd(99999)); add(1 + rnd(99999)); add(1 + rnd(99999))
+		add(stats[1 + rnd(nstats)]); add(rnd(1000)); add(rnd(100))
+		addRusage(); add(rnd(100000)); add(rnd(3) ? 0 : rnd(65536))
+		addStr(path()); addStr("/home/" word()); addStr(word()); add(rnd(100))
+		addJRusage(); add(rnd(32)); add(rnd(4)); add(rnd(1000)); add(idx())
+		add(rnd(30))
+	} else if (ty == "JOB_STATUS2") {
+		add(longJobId()); addPairs("status")
+	} else if (ty == "METRIC_LOG") {
+		add(tm())
+		for (i = 0; i < 16; i++) add(rnd(100000))
+	}
+}
+
+function record(ty) {
+	reset()
+	add(q(ty)); add(q("10.1")); add(tm())
+	body(ty)
+}
+
+function line(  s, i) {
+	s = tok[1]
+	for (i = 2; i <= ntok; i++) s = s " " tok[i]
+	return s
+}
+
+function emit(file, s) { out[file, ++nout[file]] = s }
+
+# good records of ty, and a tenth as many of each malformed kind
+function gen(file, ty, n,  i, k, cut, s) {
+	for (i = 0; i < n; i++) {
+		record(ty)
+		emit(file, line())
+	}
+	for (i = 0; i < bad; i++) {
+		# truncated within the first half of the record
+		record(ty)
+		cut = 1 + rnd(int(ntok / 2))
+		s = tok[1]
+		for (k = 2; k <= cut; k++) s = s " " tok[k]
+		if (rnd(2)) s = s " " substr(tok[cut + 1], 1, int(length(tok[cut + 1]) / 2))
+		emit(file, s)
+		# an event time which is not a number
+		record(ty)
+		tok[3] = "t" tok[3]
+		emit(file, line())
+		# an unknown event type
+		record(ty)
+		tok[1] = q(ty "_BOGUS")
+		emit(file, line())
+		# a quote left open in the event type
+		record(ty)
+		tok[1] = substr(tok[1], 1, length(tok[1]) - 1)
+		emit(file, line())
+		# a count beyond the end of the record
+		record(ty)
+		if (cntTok) {
+			tok[cntTok] = 100000
+		} else {
+			ntok = 2
+		}
+		emit(file, line())
+		nbad[file] += 5
+	}
+}
+
+function write(file,  fname, i, j, k, perm) {
+	fname = outdir "/" file
+	printf("# %s soak corpus made by gencorpus.sh -n %d -s %d\n",
+			file, records, seed) > fname
+	for (i = 1; i <= nexpect[file]; i++) print expect[file, i] > fname
+	# records of all types shuffled together
+	for (i = 1; i <= nout[file]; i++) perm[i] = i
+	for (i = nout[file]; i > 1; i--) {
+		j = 1 + rnd(i)
+		k = perm[i]; perm[i] = perm[j]; perm[j] = k
+	}
+	for (i = 1; i <= nout[file]; i++) print out[file, perm[i]] > fname
+	print "" > fname
+	print "   " > fname
+	print "not a record" > fname
+	close(fname)
+}
+
+function expectLine(file, mode, parsed, jobs, rejected) {
+	expect[file, ++nexpect[file]] = sprintf("# expect %s %d %d %d", mode,
+			parsed, jobs, rejected)
+}
+
+BEGIN {
+	srand(seed)
+	now = 1700000000
+	letters = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_-."
+	nstats = split("1 2 4 8 16 32 64 128 516", stats, " ")
+	bad = int(records / 10)
+	if (bad < 1) bad = 1
+
+	# every type the stream and events entry points handle; the first
+	# ten are about a single job
+	ntypes = split("JOB_NEW JOB_START JOB_START_ACCEPT JOB_STATUS " \
+			"JOB_SWITCH JOB_MOVE JOB_SIGNAL JOB_REQUEUE JOB_FORCE JOB_FINISH " \
+			"JOB_RUN_RUSAGE MBD_UNFULFILL JOB_FINISH2 JOB_STARTLIMIT MIG " \
+			"PRE_EXEC_START JOB_MODIFY2 JOB_FORWARD JOB_ACCEPT JOB_SIGACT " \
+			"JOB_EXECUTE JOB_CLEAN JOB_EXCEPTION JOB_EXT_MSG JOB_ATTA_DATA " \
+			"JOB_CHUNK SBD_UNREPORTED_STATUS METRIC_LOG", types, " ")
+	for (i = 1; i <= ntypes; i++) gen("lsb.stream", types[i], records)
+	# known to LSF, not handled: rejected, read for the job fields only
+	for (i = 0; i < bad; i++) {
+		emit("lsb.stream", "\"MBD_START\" \"10.1\" " tm() " " q(host()) " " \
+				q(word()) " " rnd(100) " " rnd(10))
+	}
+	good = ntypes * records
+	# three blank and garbage lines closing each corpus
+	rejected = nbad["lsb.stream"] + 2
+	expectLine("lsb.stream", "stream", good, 10 * records, rejected + bad)
+	expectLine("lsb.stream", "events", good, 10 * records, rejected + bad)
+	expectLine("lsb.stream", "stream-j", good + bad, 10 * records, rejected)
+	expectLine("lsb.stream", "events-j", good + bad, 10 * records, rejected)
+	write("lsb.stream")
+
+	gen("lsb.acct", "JOB_FINISH", records)
+	gen("lsb.acct", "JOB_START", bad)
+	rejected = nbad["lsb.acct"] + 2
+	expectLine("lsb.acct", "acct", records, records, rejected + bad)
+	expectLine("lsb.acct", "acct-j", records + bad, records + bad, rejected)
+	write("lsb.acct")
+
+	gen("lsb.status", "JOB_STATUS2", records)
+	# the pending reason summary, jobId 0, is not about a job
+	for (i = 0; i < bad; i++) {
+		record("JOB_STATUS2")
+		tok[4] = 0
+		emit("lsb.status", line())
+	}
+	gen("lsb.status", "JOB_STATUS", bad)
+	rejected = nbad["lsb.status"] + 2
+	expectLine("lsb.status", "status", records + bad, records, rejected + bad)
+	expectLine("lsb.status", "status-j", records + 2 * bad, records + bad, rejected)
+	write("lsb.status")
+}
+'
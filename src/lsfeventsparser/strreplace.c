@@ -44,3 +44,46 @@ char *strreplace(char const *const original,
 		return returned;
 	}
 }
+
+// Escape the quotes, line breaks and tabs of a JSON string value, as the
+// quoted fields of multi-line records hold line breaks. Returns a copy to
+// free, NULL when out of memory.
+char *jsonEscape(char const *const value) {
+	size_t retlen = 0;
+	const char *oriptr;
+	char *returned;
+	char *retptr;
+
+	for (oriptr = value; *oriptr; oriptr++) {
+		retlen += strchr("\"\n\r\t", *oriptr) ? 2 : 1;
+	}
+
+	returned = (char *) malloc(sizeof(char) * (retlen + 1));
+	if (returned == NULL) {
+		return NULL;
+	}
+	for (oriptr = value, retptr = returned; *oriptr; oriptr++) {
+		switch (*oriptr) {
+		case '"':
+			*retptr++ = '\\';
+			*retptr++ = '"';
+			break;
+		case '\n':
+			*retptr++ = '\\';
+			*retptr++ = 'n';
+			break;
+		case '\r':
+			*retptr++ = '\\';
+			*retptr++ = 'r';
+			break;
+		case '\t':
+			*retptr++ = '\\';
+			*retptr++ = 't';
+			break;
+		default:
+			*retptr++ = *oriptr;
+		}
+	}
+	*retptr = '\0';
+	return returned;
+}
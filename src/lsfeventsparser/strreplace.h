@@ -4,3 +4,6 @@
 
 char *strreplace(char const *const original,
 				 char const *const pattern, char const *const replacement);
+
+// Escape the quotes, line breaks and tabs of a JSON string value
+char *jsonEscape(char const *const value);
@@ -237,10 +237,14 @@ func (c *client) getPublishing(event publisher.Event) *amqp.Publishing {
 		mode = amqp.Transient
 	}
 
+	// the id of the message, for consumers to drop duplicates
+	id, _ := data.Meta["id"].(string)
+
 	return &amqp.Publishing{
 		ContentType:  "text/plain",
 		Body:         buf,
 		DeliveryMode: mode,
+		MessageId:    id,
 	}
 }
 
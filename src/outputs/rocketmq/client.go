@@ -15,6 +15,9 @@ import (
 const (
 	producerGroup = "lsfmq"
 	instanceName  = "lsfmq.rocketmq"
+
+	// property of the keys of a message
+	messageKeys = "KEYS"
 )
 
 type client struct {
@@ -152,6 +155,16 @@ func (c *client) getMessage(event publisher.Event) *rocketmq.Message {
 		msg.Properties = props.(map[string]string)
 	}
 
+	// the id of the message is its key, for consumers to drop duplicates
+	if id, ok := data.Meta["id"].(string); ok {
+		keyed := make(map[string]string, len(msg.Properties)+1)
+		for k, v := range msg.Properties {
+			keyed[k] = v
+		}
+		keyed[messageKeys] = id
+		msg.Properties = keyed
+	}
+
 	return msg
 }
 